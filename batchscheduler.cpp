@@ -0,0 +1,162 @@
+/**
+ * @file batchscheduler.cpp
+ * @brief Реализация планировщика пакета отчётов.
+ */
+
+#include "batchscheduler.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QRegularExpression>
+#include <QStorageInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+
+namespace {
+
+/** \brief Имя сервера из "//server/share/...", "server:/export" и т.п. (в нижнем регистре). */
+QString hostOf(const QString& device)
+{
+    QString d = device;
+    d.replace(QLatin1Char('\\'), QLatin1Char('/'));
+    if (d.startsWith(QStringLiteral("//")))
+        return d.mid(2).section(QLatin1Char('/'), 0, 0).toLower();
+
+    const int colon = d.indexOf(QLatin1Char(':'));
+    if (colon > 1)
+        return d.left(colon).section(QLatin1Char('@'), -1).toLower();
+    return QString();
+}
+
+bool isNetworkFs(const QByteArray& type)
+{
+    const QByteArray t = type.toLower();
+    return t.startsWith("nfs") || t == "cifs" || t.startsWith("smb") || t == "fuse.sshfs"
+           || t == "9p" || t == "afs" || t == "ceph" || t == "glusterfs";
+}
+
+/** \brief Раздел Linux -> весь диск: /dev/sda2 -> /dev/sda, /dev/nvme0n1p3 -> /dev/nvme0n1. */
+QString wholeDisk(const QString& device)
+{
+    static const QRegularExpression scsi(QStringLiteral("^(/dev/(?:sd|hd|vd|xvd)[a-z]+)\\d+$"));
+    static const QRegularExpression nvme(QStringLiteral("^(/dev/(?:nvme\\d+n\\d+|mmcblk\\d+))p\\d+$"));
+
+    QRegularExpressionMatch m = scsi.match(device);
+    if (!m.hasMatch())
+        m = nvme.match(device);
+    return m.hasMatch() ? m.captured(1) : device;
+}
+
+} // namespace
+
+
+QString BatchScheduler::storageKey(const QString& path)
+{
+    const QString abs = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+
+    // UNC-путь Windows: QStorageInfo для него ничего полезного не скажет.
+    if (abs.startsWith(QStringLiteral("//")))
+        return QStringLiteral("net:") + hostOf(abs);
+
+    const QStorageInfo info(abs);
+    if (!info.isValid() || info.device().isEmpty())
+        return QStringLiteral("path:") + abs.toLower();
+
+    const QString device = QString::fromLocal8Bit(info.device());
+    if (isNetworkFs(info.fileSystemType()))
+    {
+        const QString host = hostOf(device);
+        if (!host.isEmpty())
+            return QStringLiteral("net:") + host;
+    }
+    return QStringLiteral("dev:") + wholeDisk(device);
+}
+
+QVector<QVector<int>> BatchScheduler::plan(const QStringList& roots) const
+{
+    QVector<QVector<int>> groups;
+    QHash<QString, int> groupOf;
+    QHash<QString, QString> keyCache;   // один корень во многих заданиях — QStorageInfo один раз
+
+    for (int i = 0; i < roots.size(); ++i)
+    {
+        auto cached = keyCache.constFind(roots.at(i));
+        if (cached == keyCache.constEnd())
+            cached = keyCache.insert(roots.at(i), storageKey(roots.at(i)));
+
+        auto it = groupOf.constFind(cached.value());
+        if (it == groupOf.constEnd())
+        {
+            it = groupOf.insert(cached.value(), groups.size());
+            groups.push_back({});
+        }
+        groups[it.value()].push_back(i);
+    }
+
+    // Несколько очередей на устройство: задания по кругу, но один корень — всегда в одну очередь.
+    const int perDevice = std::max(1, m_jobsPerDevice);
+    QVector<QVector<int>> lanes;
+    for (const QVector<int>& group : groups)
+    {
+        const int laneBase = lanes.size();
+        QHash<QString, int> laneOfRoot;
+        for (int job : group)
+        {
+            const QString rootKey = QDir::cleanPath(QFileInfo(roots.at(job)).absoluteFilePath()).toLower();
+            auto it = laneOfRoot.constFind(rootKey);
+            if (it == laneOfRoot.constEnd())
+            {
+                const int lane = laneBase + laneOfRoot.size() % perDevice;
+                it = laneOfRoot.insert(rootKey, lane);
+                if (lane == lanes.size())
+                    lanes.push_back({});
+            }
+            lanes[it.value()].push_back(job);
+        }
+    }
+
+    // Длинные очереди стартуют первыми: пакет не ждёт в конце одну длинную очередь.
+    std::stable_sort(lanes.begin(), lanes.end(),
+                     [](const QVector<int>& a, const QVector<int>& b) { return a.size() > b.size(); });
+    return lanes;
+}
+
+int BatchScheduler::run(const QStringList& roots, const std::function<void(int)>& work) const
+{
+    const QVector<QVector<int>> lanes = plan(roots);
+    if (lanes.isEmpty())
+        return 0;
+
+    int parallel = m_maxParallel > 0 ? m_maxParallel : std::max(1, QThread::idealThreadCount());
+    parallel = std::min<int>(parallel, lanes.size());
+
+    if (parallel == 1)
+    {
+        for (const QVector<int>& lane : lanes)
+            for (int job : lane)
+                work(job);
+        return lanes.size();
+    }
+
+    // Свой пул для очередей: они блокируются на генерации, а извлечение идёт в общем пуле.
+    QThreadPool drivers;
+    drivers.setMaxThreadCount(parallel);
+
+    QVector<QFuture<void>> running;
+    running.reserve(lanes.size());
+    for (const QVector<int>& lane : lanes)
+    {
+        running.push_back(QtConcurrent::run(&drivers, [lane, &work]() {
+            for (int job : lane)
+                work(job);
+        }));
+    }
+    for (QFuture<void>& f : running)
+        f.waitForFinished();
+    return lanes.size();
+}
@@ -0,0 +1,62 @@
+/**
+ * @file batchscheduler.h
+ * @brief Параллельный прогон нескольких отчётов с учётом дисков: один диск — одна очередь.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+
+/**
+ * @brief Планировщик пакета отчётов.
+ * @details
+ *  Обход каталога и чтение файлов упираются в диск, а не в процессор: два отчёта
+ *  на одном HDD или одной сетевой шаре мешают друг другу (головка/канал прыгает между
+ *  каталогами), на разных — нет. Поэтому задания группируются по устройству корня
+ *  (storageKey()), задания одного устройства идут друг за другом, разные устройства —
+ *  параллельно. Извлечение внутри отчётов по-прежнему идёт в общем пуле
+ *  (ReportGenerator::Options::threadPool), так что ядра делятся между отчётами сами.
+ *
+ *  Отчёты по одному корню попадают в одну очередь — общий файл кэша извлечения
+ *  (ExtractionCache, один на корень) не пишется двумя прогонами сразу.
+ */
+class BatchScheduler
+{
+public:
+    /**
+     * @brief Ключ устройства, на котором лежит путь.
+     * @details Сетевые пути (UNC, NFS, SMB) — по имени сервера; локальные — по устройству
+     *          из QStorageInfo, разделы одного диска Linux (sda1/sda2, nvme0n1p1/p2) — один ключ.
+     *          Путь, для которого устройство не определилось, получает собственный ключ.
+     */
+    static QString storageKey(const QString& path);
+
+    /** \brief Сколько отчётов строить одновременно (0 = по числу устройств, не больше числа ядер). */
+    void setMaxParallel(int n) { m_maxParallel = n; }
+
+    /** \brief Сколько отчётов одного устройства строить одновременно (по умолчанию 1; для SSD можно больше). */
+    void setJobsPerDevice(int n) { m_jobsPerDevice = n; }
+
+    /**
+     * @brief Разбить задания на очереди.
+     * @param roots Корень каждого задания (индекс = номер задания).
+     * @return Очереди с номерами заданий в исходном порядке; длинные очереди — первыми.
+     */
+    QVector<QVector<int>> plan(const QStringList& roots) const;
+
+    /**
+     * @brief Выполнить work(i) для каждого задания и дождаться всех.
+     * @details work вызывается из служебных потоков (не из общего пула извлечения),
+     *          по одному потоку на очередь; отмену и ошибки work обрабатывает сам.
+     * @return Число очередей.
+     */
+    int run(const QStringList& roots, const std::function<void(int)>& work) const;
+
+private:
+    int m_maxParallel = 0;
+    int m_jobsPerDevice = 1;
+};
@@ -0,0 +1,525 @@
+/**
+ * @file benchcorpus.cpp
+ * @brief Генерация синтетического корпуса для бенчмарка.
+ */
+
+#include "benchcorpus.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+namespace {
+
+/** \brief splitmix64: воспроизводим на любой платформе. */
+class Rng
+{
+public:
+    explicit Rng(quint64 seed) : m_state(seed) {}
+
+    quint64 next()
+    {
+        quint64 z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /** \brief Число в [lo, hi]. */
+    int range(int lo, int hi) { return lo + int(next() % quint64(hi - lo + 1)); }
+
+private:
+    quint64 m_state;
+};
+
+const char* const kEnWords[] = {
+    "value", "index", "buffer", "result", "count", "state", "node", "parent", "child", "offset",
+    "length", "reader", "writer", "stream", "token", "cache", "model", "entry", "limit", "report"
+};
+const char* const kRuWords[] = {
+    "значение", "индекс", "буфер", "результат", "счётчик", "состояние", "узел", "родитель",
+    "ребёнок", "смещение", "длина", "чтение", "запись", "поток", "кэш", "модель", "отчёт"
+};
+
+template <size_t N>
+const char* pick(Rng& rng, const char* const (&words)[N])
+{
+    return words[rng.next() % N];
+}
+
+/** \brief Исходник C++ примерно на approxBytes байт (UTF-8). */
+QByteArray sourceText(Rng& rng, int approxBytes, bool cyrillic)
+{
+    QByteArray out;
+    out.reserve(approxBytes + 256);
+    out += "#include <vector>\n#include <string>\n\n";
+
+    int fn = 0;
+    while (out.size() < approxBytes)
+    {
+        out += "// ";
+        out += cyrillic ? pick(rng, kRuWords) : pick(rng, kEnWords);
+        out += ' ';
+        out += pick(rng, kEnWords);
+        out += '\n';
+
+        out += "int ";
+        out += pick(rng, kEnWords);
+        out += '_';
+        out += QByteArray::number(fn++);
+        out += "(int a, int b)\n{\n";
+        const int lines = rng.range(2, 8);
+        for (int i = 0; i < lines; ++i)
+        {
+            out += "    a = a * ";
+            out += QByteArray::number(rng.range(2, 97));
+            out += " + b; // ";
+            out += pick(rng, kEnWords);
+            out += '\n';
+        }
+        out += "    return a;\n}\n\n";
+    }
+    return out;
+}
+
+/** \brief Проза из слов (для больших файлов и документов). */
+QString proseText(Rng& rng, qint64 approxChars)
+{
+    QString out;
+    out.reserve(int(approxChars + 128));
+    int inLine = 0;
+    while (out.size() < approxChars)
+    {
+        out += QString::fromUtf8((rng.next() & 1) ? pick(rng, kRuWords) : pick(rng, kEnWords));
+        if (++inLine == 12)
+        {
+            out += QLatin1Char('\n');
+            inLine = 0;
+        }
+        else
+        {
+            out += QLatin1Char(' ');
+        }
+    }
+    return out;
+}
+
+/** \brief Текст в CP1251: ASCII и кириллица 0xC0..0xFF. */
+QByteArray cp1251Text(Rng& rng, qint64 approxBytes)
+{
+    QByteArray out;
+    out.reserve(int(approxBytes + 64));
+    while (out.size() < approxBytes)
+    {
+        const int len = rng.range(3, 10);
+        for (int i = 0; i < len; ++i)
+            out += char(0xE0 + rng.range(0, 31));
+        out += (rng.range(0, 11) == 0) ? "\r\n" : " ";
+    }
+    return out;
+}
+
+QByteArray utf16leWithBom(const QString& text)
+{
+    QByteArray out;
+    out.resize(2 + text.size() * 2);
+    out[0] = char(0xFF);
+    out[1] = char(0xFE);
+    char* p = out.data() + 2;
+    for (const QChar ch : text)
+    {
+        const quint16 u = qToLittleEndian(quint16(ch.unicode()));
+        std::memcpy(p, &u, 2);
+        p += 2;
+    }
+    return out;
+}
+
+// ---------- ZIP (метод Stored) ----------
+
+quint32 crc32(const QByteArray& data)
+{
+    static const QVector<quint32> table = [] {
+        QVector<quint32> t(256);
+        for (quint32 i = 0; i < 256; ++i)
+        {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            t[int(i)] = c;
+        }
+        return t;
+    }();
+
+    quint32 c = 0xFFFFFFFFu;
+    for (const char ch : data)
+        c = table.at(int((c ^ quint8(ch)) & 0xFF)) ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+void put16(QByteArray& out, quint16 v)
+{
+    out += char(v & 0xFF);
+    out += char(v >> 8);
+}
+
+void put32(QByteArray& out, quint32 v)
+{
+    put16(out, quint16(v & 0xFFFF));
+    put16(out, quint16(v >> 16));
+}
+
+/** \brief ZIP без сжатия: ZipReader читает его тем же путём, что и настоящие DOCX/XLSX. */
+QByteArray storedZip(const QVector<std::pair<QByteArray, QByteArray>>& entries)
+{
+    QByteArray out;
+    QByteArray central;
+
+    for (const auto& e : entries)
+    {
+        const QByteArray& name = e.first;
+        const QByteArray& data = e.second;
+        const quint32 crc = crc32(data);
+        const quint32 offset = quint32(out.size());
+
+        put32(out, 0x04034B50u);
+        put16(out, 20);               // version needed
+        put16(out, 0);                // flags
+        put16(out, 0);                // method: stored
+        put16(out, 0);                // time
+        put16(out, 0x21);             // date: 1980-01-01
+        put32(out, crc);
+        put32(out, quint32(data.size()));
+        put32(out, quint32(data.size()));
+        put16(out, quint16(name.size()));
+        put16(out, 0);
+        out += name;
+        out += data;
+
+        put32(central, 0x02014B50u);
+        put16(central, 20);           // version made by
+        put16(central, 20);
+        put16(central, 0);
+        put16(central, 0);
+        put16(central, 0);
+        put16(central, 0x21);
+        put32(central, crc);
+        put32(central, quint32(data.size()));
+        put32(central, quint32(data.size()));
+        put16(central, quint16(name.size()));
+        put16(central, 0);            // extra
+        put16(central, 0);            // comment
+        put16(central, 0);            // disk
+        put16(central, 0);            // internal attrs
+        put32(central, 0);            // external attrs
+        put32(central, offset);
+        central += name;
+    }
+
+    const quint32 cdOffset = quint32(out.size());
+    out += central;
+
+    put32(out, 0x06054B50u);
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, quint16(entries.size()));
+    put16(out, quint16(entries.size()));
+    put32(out, quint32(central.size()));
+    put32(out, cdOffset);
+    put16(out, 0);
+    return out;
+}
+
+QByteArray docxFile(Rng& rng, int paragraphs)
+{
+    QByteArray doc =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"><w:body>";
+    for (int i = 0; i < paragraphs; ++i)
+    {
+        doc += "<w:p><w:r><w:t>";
+        doc += proseText(rng, rng.range(80, 400)).replace(QLatin1Char('\n'), QLatin1Char(' ')).toUtf8();
+        doc += "</w:t></w:r></w:p>";
+    }
+    doc += "</w:body></w:document>";
+
+    const QByteArray types =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Override PartName=\"/word/document.xml\" "
+        "ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.document.main+xml\"/>"
+        "</Types>";
+
+    return storedZip({ { "[Content_Types].xml", types }, { "word/document.xml", doc } });
+}
+
+QByteArray columnName(int col)
+{
+    QByteArray name;
+    for (++col; col > 0; col = (col - 1) / 26)
+        name.prepend(char('A' + (col - 1) % 26));
+    return name;
+}
+
+QByteArray xlsxFile(Rng& rng, int rows, int cols)
+{
+    const int stringCount = 200;
+    QByteArray shared = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                        "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">";
+    for (int i = 0; i < stringCount; ++i)
+    {
+        shared += "<si><t>";
+        shared += pick(rng, kRuWords);
+        shared += ' ';
+        shared += QByteArray::number(i);
+        shared += "</t></si>";
+    }
+    shared += "</sst>";
+
+    QByteArray sheet = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                       "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+    for (int r = 0; r < rows; ++r)
+    {
+        sheet += "<row r=\"" + QByteArray::number(r + 1) + "\">";
+        for (int c = 0; c < cols; ++c)
+        {
+            const QByteArray ref = columnName(c) + QByteArray::number(r + 1);
+            if ((c & 1) == 0)
+                sheet += "<c r=\"" + ref + "\" t=\"s\"><v>" + QByteArray::number(rng.range(0, stringCount - 1)) + "</v></c>";
+            else
+                sheet += "<c r=\"" + ref + "\"><v>" + QByteArray::number(rng.range(0, 1000000)) + "</v></c>";
+        }
+        sheet += "</row>";
+    }
+    sheet += "</sheetData></worksheet>";
+
+    const QByteArray workbook =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+        "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+        "<sheets><sheet name=\"Data\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>";
+    const QByteArray rels =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" "
+        "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" "
+        "Target=\"worksheets/sheet1.xml\"/></Relationships>";
+
+    return storedZip({ { "xl/workbook.xml", workbook },
+                       { "xl/_rels/workbook.xml.rels", rels },
+                       { "xl/sharedStrings.xml", shared },
+                       { "xl/worksheets/sheet1.xml", sheet } });
+}
+
+/** \brief Минимальный PDF: страницы с текстом шрифтом Helvetica, корректная таблица xref. */
+QByteArray pdfFile(Rng& rng, int pages, int linesPerPage)
+{
+    QByteArray out = "%PDF-1.4\n";
+    QVector<qint64> offsets;
+
+    // Объекты: 1 — каталог, 2 — дерево страниц, 3 — шрифт, далее пары (страница, содержимое).
+    auto begin = [&](int id) {
+        if (offsets.size() < id)
+            offsets.resize(id);
+        offsets[id - 1] = out.size();
+        out += QByteArray::number(id) + " 0 obj\n";
+    };
+
+    begin(1);
+    out += "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n";
+
+    begin(2);
+    out += "<< /Type /Pages /Count " + QByteArray::number(pages) + " /Kids [";
+    for (int p = 0; p < pages; ++p)
+        out += QByteArray::number(4 + p * 2) + " 0 R ";
+    out += "] >>\nendobj\n";
+
+    begin(3);
+    out += "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>\nendobj\n";
+
+    for (int p = 0; p < pages; ++p)
+    {
+        const int pageId = 4 + p * 2;
+        begin(pageId);
+        out += "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 3 0 R >> >> "
+               "/Contents " + QByteArray::number(pageId + 1) + " 0 R >>\nendobj\n";
+
+        QByteArray content = "BT /F1 10 Tf 12 TL 50 750 Td\n";
+        for (int l = 0; l < linesPerPage; ++l)
+        {
+            content += '(';
+            for (int w = 0; w < 10; ++w)
+            {
+                content += pick(rng, kEnWords);
+                content += ' ';
+            }
+            content += ") Tj T*\n";
+        }
+        content += "ET\n";
+
+        begin(pageId + 1);
+        out += "<< /Length " + QByteArray::number(content.size()) + " >>\nstream\n";
+        out += content;
+        out += "endstream\nendobj\n";
+    }
+
+    const qint64 xref = out.size();
+    out += "xref\n0 " + QByteArray::number(offsets.size() + 1) + "\n";
+    out += "0000000000 65535 f \n";
+    for (const qint64 off : offsets)
+        out += QByteArray::number(off).rightJustified(10, '0') + " 00000 n \n";
+    out += "trailer\n<< /Size " + QByteArray::number(offsets.size() + 1) + " /Root 1 0 R >>\n";
+    out += "startxref\n" + QByteArray::number(xref) + "\n%%EOF\n";
+    return out;
+}
+
+QByteArray binaryBlob(Rng& rng, int size)
+{
+    QByteArray out(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        out[i] = char(rng.next() & 0xFF);
+    return out;
+}
+
+/** \brief Запись файлов корпуса с подсчётом статистики. */
+class CorpusWriter
+{
+public:
+    CorpusWriter(const QString& root, CorpusStats* stats) : m_root(root), m_stats(stats) {}
+
+    bool dir(const QString& rel)
+    {
+        if (!QDir(m_root).mkpath(rel))
+            return fail(QStringLiteral("Не удалось создать папку %1").arg(rel));
+        ++m_stats->dirs;
+        return true;
+    }
+
+    bool file(const QString& rel, const QByteArray& data)
+    {
+        QFile f(QDir(m_root).filePath(rel));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(data) != data.size())
+            return fail(QStringLiteral("Не удалось записать %1: %2").arg(rel, f.errorString()));
+        ++m_stats->files;
+        m_stats->bytes += data.size();
+        return true;
+    }
+
+    QString error() const { return m_error; }
+
+private:
+    QString m_root;
+    CorpusStats* m_stats;
+    QString m_error;
+
+    bool fail(const QString& e)
+    {
+        m_error = e;
+        return false;
+    }
+};
+
+} // namespace
+
+
+bool generateCorpus(const QString& root, const CorpusSpec& spec, CorpusStats* stats, QString* errorOut)
+{
+    *stats = CorpusStats();
+    CorpusWriter w(root, stats);
+    Rng rng(spec.seed);
+    const int s = std::max(1, spec.scale);
+
+    auto failed = [&]() {
+        if (errorOut) *errorOut = w.error();
+        return false;
+    };
+
+    if (!QDir().mkpath(root))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось создать %1").arg(root);
+        return false;
+    }
+
+    // src/: много мелких исходников в умеренно вложенных папках.
+    for (int m = 0; m < 20 * s; ++m)
+    {
+        for (int sub = 0; sub < 5; ++sub)
+        {
+            const QString dir = QStringLiteral("src/module%1/part%2").arg(m, 3, 10, QLatin1Char('0')).arg(sub);
+            if (!w.dir(dir))
+                return failed();
+            for (int f = 0; f < 10; ++f)
+            {
+                const bool header = (f % 3 == 0);
+                const QString name = QStringLiteral("%1/%2_%3.%4").arg(dir).arg(QString::fromLatin1(pick(rng, kEnWords)))
+                                         .arg(f).arg(header ? QStringLiteral("h") : QStringLiteral("cpp"));
+                if (!w.file(name, sourceText(rng, rng.range(1000, 8000), (f & 1) != 0)))
+                    return failed();
+            }
+        }
+    }
+
+    // wide/: одна папка, тысячи маленьких файлов (сортировка и вывод дерева).
+    if (!w.dir(QStringLiteral("wide")))
+        return failed();
+    for (int f = 0; f < 2000 * s; ++f)
+    {
+        if (!w.file(QStringLiteral("wide/note_%1.txt").arg(f, 6, 10, QLatin1Char('0')),
+                    proseText(rng, rng.range(100, 300)).toUtf8()))
+            return failed();
+    }
+
+    // deep/: глубокая цепочка папок.
+    QString deep = QStringLiteral("deep");
+    for (int level = 0; level < 64; ++level)
+    {
+        deep += QStringLiteral("/level%1").arg(level, 2, 10, QLatin1Char('0'));
+        if (!w.dir(deep))
+            return failed();
+        if (!w.file(deep + QStringLiteral("/impl.cpp"), sourceText(rng, 600, false))
+            || !w.file(deep + QStringLiteral("/impl.h"), sourceText(rng, 300, false)))
+            return failed();
+    }
+
+    // large/: крупные файлы в разных кодировках (декодирование).
+    if (!w.dir(QStringLiteral("large")))
+        return failed();
+    if (!w.file(QStringLiteral("large/big_utf8.txt"), proseText(rng, qint64(8) * 1024 * 1024 * s).toUtf8())
+        || !w.file(QStringLiteral("large/big_utf16le.txt"), utf16leWithBom(proseText(rng, qint64(2) * 1024 * 1024 * s)))
+        || !w.file(QStringLiteral("large/big_cp1251.txt"), cp1251Text(rng, qint64(4) * 1024 * 1024 * s)))
+        return failed();
+
+    // docs/: документы для экстракторов.
+    if (!w.dir(QStringLiteral("docs")))
+        return failed();
+    for (int i = 0; i < 20 * s; ++i)
+    {
+        if (!w.file(QStringLiteral("docs/spec_%1.docx").arg(i, 3, 10, QLatin1Char('0')), docxFile(rng, 200))
+            || !w.file(QStringLiteral("docs/table_%1.xlsx").arg(i, 3, 10, QLatin1Char('0')), xlsxFile(rng, 300, 8)))
+            return failed();
+    }
+    for (int i = 0; i < 5 * s; ++i)
+    {
+        if (!w.file(QStringLiteral("docs/paper_%1.pdf").arg(i, 3, 10, QLatin1Char('0')), pdfFile(rng, 10, 50)))
+            return failed();
+    }
+
+    // assets/: двоичные файлы (отсев по содержимому).
+    if (!w.dir(QStringLiteral("assets")))
+        return failed();
+    for (int i = 0; i < 50 * s; ++i)
+    {
+        const QString ext = (i & 1) ? QStringLiteral("png") : QStringLiteral("bin");
+        if (!w.file(QStringLiteral("assets/blob_%1.%2").arg(i, 3, 10, QLatin1Char('0')).arg(ext),
+                    binaryBlob(rng, 16 * 1024)))
+            return failed();
+    }
+
+    return true;
+}
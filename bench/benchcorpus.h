@@ -0,0 +1,42 @@
+/**
+ * @file benchcorpus.h
+ * @brief Синтетический каталог для бенчмарка: воспроизводимый по seed и масштабу.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+
+/**
+ * @brief Параметры корпуса.
+ * @details Одинаковые seed и scale дают байт-в-байт одинаковое дерево на любой машине
+ *          (генератор случайных чисел свой, не зависит от версии Qt/STL).
+ */
+struct CorpusSpec
+{
+    quint64 seed = 1;
+    int scale = 1;   ///< Множитель числа файлов и размера больших файлов (1 = ~3000 файлов, ~40 МБ).
+};
+
+/** \brief Что получилось на диске. */
+struct CorpusStats
+{
+    qint64 files = 0;
+    qint64 dirs = 0;
+    qint64 bytes = 0;
+};
+
+/**
+ * @brief Создать корпус в папке root (папка должна быть пустой или отсутствовать).
+ * @details Состав:
+ *  - src/      — модули с мелкими исходниками .cpp/.h (UTF-8, местами кириллица);
+ *  - wide/     — одна папка с тысячами маленьких файлов;
+ *  - deep/     — цепочка из 64 вложенных папок;
+ *  - large/    — крупные текстовые файлы в UTF-8, UTF-16LE (BOM) и CP1251;
+ *  - docs/     — DOCX, XLSX (ZIP без сжатия) и PDF с текстом;
+ *  - assets/   — двоичные файлы (для проверки отсева по содержимому).
+ * @return false и errorOut при ошибке записи.
+ */
+bool generateCorpus(const QString& root, const CorpusSpec& spec, CorpusStats* stats, QString* errorOut);
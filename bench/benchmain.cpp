@@ -0,0 +1,538 @@
+/**
+ * @file benchmain.cpp
+ * @brief ContextMakerBench: замеры ReportGenerator на синтетическом корпусе, результат — JSON.
+ * @details
+ *  Каждый сценарий — отдельный прогон generate() (или только обхода каталога) с repeat
+ *  повторами; в JSON — медиана, минимум и максимум, фазы (обход+дерево / содержимое),
+ *  фазы и экстракторы по профилю генератора (ReportProfile), пропускная способность
+ *  и пиковый RSS. Отчёт пишется в приёмник-счётчик: замеряется
+ *  генератор, а не диск под отчётом.
+ *
+ *  Пример сравнения двух коммитов:
+ *    ContextMakerBench --corpus /tmp/cm-corpus --keep --label $(git rev-parse --short HEAD) -o a.json
+ */
+
+#include "benchcorpus.h"
+#include "utf8selfcheck.h"
+
+#include "dirmodel.h"
+#include "optionparse.h"
+#include "pdftext.h"
+#include "reportgenerator.h"
+#include "reportprofile.h"
+#include "reportwriter.h"
+#include "utf8codec.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <functional>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX) && !defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+
+/** \brief Приёмник, который только считает символы. */
+class CountingSink : public ReportSink
+{
+public:
+    bool write(const QString& text) override
+    {
+        m_chars += text.size();
+        return true;
+    }
+    bool writeUtf8(const QByteArray& utf8) override
+    {
+        m_chars += utf8.size();
+        return true;
+    }
+    qint64 chars() const { return m_chars; }
+
+private:
+    qint64 m_chars = 0;
+};
+
+/** \brief Пиковый RSS процесса в байтах (0 — неизвестно). */
+qint64 peakRssBytes()
+{
+#if defined(Q_OS_LINUX)
+    QFile f(QStringLiteral("/proc/self/status"));
+    if (!f.open(QIODevice::ReadOnly))
+        return 0;
+    for (const QByteArray& line : f.readAll().split('\n'))
+    {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+    }
+    return 0;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return qint64(pmc.PeakWorkingSetSize);
+    return 0;
+#elif defined(Q_OS_UNIX)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+#if defined(Q_OS_DARWIN)
+    return qint64(ru.ru_maxrss);          // байты
+#else
+    return qint64(ru.ru_maxrss) * 1024;   // КБ
+#endif
+#else
+    return 0;
+#endif
+}
+
+/** \brief Сбросить пиковый RSS перед сценарием (только Linux); false — пик накопительный. */
+bool resetPeakRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile f(QStringLiteral("/proc/self/clear_refs"));
+    return f.open(QIODevice::WriteOnly) && f.write("5") == 1;
+#else
+    return false;
+#endif
+}
+
+/** \brief Один прогон сценария. */
+struct RunResult
+{
+    bool ok = true;
+    QString error;
+    double totalMs = 0;
+    double scanMs = 0;       ///< До начала секции 2: обход, сортировка, дерево.
+    double contentsMs = 0;   ///< Секция 2: чтение, декодирование, извлечение, сборка.
+    qint64 files = 0;
+    qint64 filesExtracted = 0;
+    qint64 bytesRead = 0;
+    qint64 reportChars = 0;
+    qint64 entries = 0;
+    QMap<QString, double> phaseMs;   ///< Фазы по профилю генератора (ReportProfile), сумма по имени.
+    QJsonObject extractors;          ///< Счётчики экстракторов профиля.
+};
+
+RunResult runGenerate(ReportGenerator::Options opt)
+{
+    ReportProgress progress;
+    opt.progress = &progress;
+    ReportProfile profile;
+    opt.profile = &profile;
+
+    CountingSink sink;
+    RunResult r;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    QFuture<bool> f = QtConcurrent::run([&opt, &sink, &r]() {
+        ReportGenerator gen(opt);
+        return gen.generate(sink, &r.error);
+    });
+
+    // Границу фаз ловим опросом: точность ~0.2 мс, генератор не трогаем.
+    qint64 contentsAtNs = -1;
+    while (!f.isFinished())
+    {
+        if (contentsAtNs < 0 && progress.phase.load() == ReportProgress::Contents)
+            contentsAtNs = clock.nsecsElapsed();
+        QThread::usleep(200);
+    }
+    r.ok = f.result();
+
+    const qint64 totalNs = clock.nsecsElapsed();
+    r.totalMs = totalNs / 1e6;
+    r.scanMs = (contentsAtNs < 0 ? totalNs : contentsAtNs) / 1e6;
+    r.contentsMs = (contentsAtNs < 0 ? 0 : totalNs - contentsAtNs) / 1e6;
+    r.files = progress.filesDone.load();
+    r.filesExtracted = progress.filesExtracted.load();
+    r.bytesRead = progress.bytesRead.load();
+    r.entries = progress.entriesScanned.load();
+    r.reportChars = sink.chars();
+
+    for (const ReportProfile::PhaseSpan& p : profile.phases())
+        r.phaseMs[p.name] += p.durUs / 1000.0;
+    for (int i = 0; i < int(ReportProfile::Extractor::Count); ++i)
+    {
+        const ReportProfile::ExtractorStats s = profile.extractorStats(ReportProfile::Extractor(i));
+        if (s.calls == 0)
+            continue;
+        QJsonObject e;
+        e.insert(QStringLiteral("calls"), s.calls);
+        e.insert(QStringLiteral("errors"), s.errors);
+        e.insert(QStringLiteral("bytesIn"), s.bytesIn);
+        e.insert(QStringLiteral("charsOut"), s.charsOut);
+        e.insert(QStringLiteral("totalMs"), s.totalUs / 1000.0);
+        e.insert(QStringLiteral("maxMs"), s.maxUs / 1000.0);
+        r.extractors.insert(QLatin1String(ReportProfile::extractorName(ReportProfile::Extractor(i))), e);
+    }
+    return r;
+}
+
+RunResult runWalk(const QString& root, int threads)
+{
+    RunResult r;
+    std::atomic<qint64> scanned { 0 };
+
+    QElapsedTimer clock;
+    clock.start();
+    DirModel model;
+    r.ok = model.build(root, nullptr, nullptr, &scanned, threads);
+    r.totalMs = r.scanMs = clock.nsecsElapsed() / 1e6;
+    r.entries = scanned.load();
+    return r;
+}
+
+/** \brief Самопроверка UTF-8: не замер, а сверка векторного пути с эталоном (ok = совпало). */
+RunResult runUtf8Check(quint64 seed, int count)
+{
+    RunResult r;
+    Utf8SelfCheckStats stats;
+
+    QElapsedTimer clock;
+    clock.start();
+    r.ok = runUtf8SelfCheck(seed, count, &stats, &r.error);
+    r.totalMs = r.contentsMs = clock.nsecsElapsed() / 1e6;
+    r.files = stats.inputs;
+    r.filesExtracted = stats.valid;
+    r.bytesRead = stats.bytes;
+    return r;
+}
+
+/** \brief Сценарий: имя, что измеряет, и как запустить один прогон. */
+struct Scenario
+{
+    QString name;
+    QString description;
+    std::function<RunResult()> run;
+    std::function<void()> warmUp;   ///< Прогон перед замерами (не учитывается), может быть пустым.
+};
+
+QJsonObject stat(QVector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    QJsonObject o;
+    o.insert(QStringLiteral("median"), v.isEmpty() ? 0.0 : v.at(v.size() / 2));
+    o.insert(QStringLiteral("min"), v.isEmpty() ? 0.0 : v.first());
+    o.insert(QStringLiteral("max"), v.isEmpty() ? 0.0 : v.last());
+    return o;
+}
+
+QTextStream& err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ContextMakerBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Бенчмарк ReportGenerator на синтетическом корпусе (результат — JSON)."));
+    parser.addHelpOption();
+
+    const QCommandLineOption corpusOpt(QStringLiteral("corpus"),
+                                       QStringLiteral("Папка корпуса (по умолчанию — временная)."), QStringLiteral("папка"));
+    const QCommandLineOption keepOpt(QStringLiteral("keep"),
+                                     QStringLiteral("Не пересоздавать корпус, если папка уже есть (и не удалять после)."));
+    const QCommandLineOption scaleOpt(QStringLiteral("scale"), QStringLiteral("Масштаб корпуса (1 = ~3000 файлов, ~40 МБ)."),
+                                      QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption seedOpt(QStringLiteral("seed"), QStringLiteral("Seed генератора корпуса."),
+                                     QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption repeatOpt(QStringLiteral("repeat"), QStringLiteral("Повторов каждого сценария."),
+                                       QStringLiteral("n"), QStringLiteral("3"));
+    const QCommandLineOption onlyOpt(QStringLiteral("scenario"),
+                                     QStringLiteral("Только эти сценарии (через запятую, можно повторять)."),
+                                     QStringLiteral("имя"));
+    const QCommandLineOption labelOpt(QStringLiteral("label"),
+                                      QStringLiteral("Метка прогона в JSON (например, хэш коммита)."), QStringLiteral("текст"));
+    const QCommandLineOption outOpt({QStringLiteral("o"), QStringLiteral("out")},
+                                    QStringLiteral("JSON в файл (по умолчанию — stdout)."), QStringLiteral("файл"));
+    const QCommandLineOption listOpt(QStringLiteral("list"), QStringLiteral("Показать сценарии и выйти."));
+
+    parser.addOptions({corpusOpt, keepOpt, scaleOpt, seedOpt, repeatOpt, onlyOpt, labelOpt, outOpt, listOpt});
+    parser.process(app);
+
+    CorpusSpec spec;
+    spec.scale = std::max(1, parser.value(scaleOpt).toInt());
+    spec.seed = parser.value(seedOpt).toULongLong();
+    const int repeat = std::max(1, parser.value(repeatOpt).toInt());
+
+    // --- Корпус ---
+    QTemporaryDir tempDir;
+    QString corpus = parser.value(corpusOpt);
+    if (corpus.isEmpty())
+    {
+        if (!tempDir.isValid())
+        {
+            err() << "Не удалось создать временную папку.\n";
+            return 1;
+        }
+        corpus = tempDir.path() + QStringLiteral("/corpus");
+    }
+    corpus = QDir::cleanPath(QDir(corpus).absolutePath());
+
+    CorpusStats corpusStats;
+    double corpusMs = 0;
+    const bool reuse = parser.isSet(keepOpt) && QDir(corpus).exists();
+    if (!reuse && !parser.isSet(listOpt))
+    {
+        if (QDir(corpus).exists() && !QDir(corpus).isEmpty())
+        {
+            err() << "Папка корпуса не пуста: " << corpus << " (для повторного использования — --keep)\n";
+            return 1;
+        }
+        err() << "Генерация корпуса: " << corpus << "\n";
+        err().flush();
+
+        QElapsedTimer clock;
+        clock.start();
+        QString genErr;
+        if (!generateCorpus(corpus, spec, &corpusStats, &genErr))
+        {
+            err() << "Ошибка генерации корпуса: " << genErr << "\n";
+            return 1;
+        }
+        corpusMs = clock.nsecsElapsed() / 1e6;
+    }
+
+    // --- Сценарии ---
+    ReportGenerator::Options base;
+    base.rootPath = corpus;
+    base.includeExt = defaultIncludeExt();
+    base.excludeDirNames = defaultExcludeDirs();
+    base.useExtractionCache = false;   // замеряем работу, а не кэш (кроме full-cached)
+
+    auto withRoot = [&](const QString& sub) {
+        ReportGenerator::Options o = base;
+        o.rootPath = QDir(corpus).filePath(sub);
+        return o;
+    };
+    auto onlyExt = [](ReportGenerator::Options o, const QString& ext) {
+        o.includeExt = QStringList { ext };
+        o.maxBytes = qint64(256) * 1024 * 1024;
+        o.maxOutChars = 0;
+        return o;
+    };
+
+    ReportGenerator::Options full = base;
+    full.includeExt << QStringLiteral(".docx") << QStringLiteral(".xlsx") << QStringLiteral(".pdf");
+    full.includeExt.removeDuplicates();
+    full.maxBytes = qint64(64) * 1024 * 1024;
+
+    ReportGenerator::Options largeText = withRoot(QStringLiteral("large"));
+    largeText.includeExt = QStringList { QStringLiteral(".txt") };
+    largeText.maxBytes = qint64(1024) * 1024 * 1024;
+    largeText.maxOutChars = 0;
+
+    ReportGenerator::Options treeOnly = base;
+    treeOnly.treeOnly = true;
+
+    ReportGenerator::Options anyText = base;
+    anyText.includeAnyText = true;
+
+    ReportGenerator::Options serial = full;
+    serial.maxParallelReads = 1;
+    serial.scanThreads = 1;
+
+    QTemporaryDir cacheDir;
+    ReportGenerator::Options cached = full;
+    cached.useExtractionCache = true;
+    cached.cacheDir = cacheDir.path();
+
+    const bool havePdf = QLatin1String(pdfTextBackendId(full.pdfTimeoutMs)) != QLatin1String("pdftotext") || !findPdfToTextExe().isEmpty();
+
+    QVector<Scenario> scenarios = {
+        { QStringLiteral("walk-serial"), QStringLiteral("DirModel::build, 1 поток"),
+          [&] { return runWalk(corpus, 1); }, {} },
+        { QStringLiteral("walk-parallel"), QStringLiteral("DirModel::build, потоков по числу ядер (до 8)"),
+          [&] { return runWalk(corpus, std::clamp(QThread::idealThreadCount(), 1, 8)); }, {} },
+        { QStringLiteral("tree-only"), QStringLiteral("обход + сортировка + дерево, без секции 2"),
+          [&] { return runGenerate(treeOnly); }, {} },
+        { QStringLiteral("sources"), QStringLiteral("src/: мелкие исходники UTF-8"),
+          [&] { return runGenerate(withRoot(QStringLiteral("src"))); }, {} },
+        { QStringLiteral("wide"), QStringLiteral("wide/: тысячи маленьких файлов в одной папке"),
+          [&] { return runGenerate(withRoot(QStringLiteral("wide"))); }, {} },
+        { QStringLiteral("large-text"), QStringLiteral("large/: чтение и декодирование UTF-8/UTF-16/CP1251 без лимита"),
+          [&] { return runGenerate(largeText); }, {} },
+        { QStringLiteral("docx"), QStringLiteral("docs/*.docx: извлечение"),
+          [&] { return runGenerate(onlyExt(withRoot(QStringLiteral("docs")), QStringLiteral(".docx"))); }, {} },
+        { QStringLiteral("xlsx"), QStringLiteral("docs/*.xlsx: извлечение"),
+          [&] { return runGenerate(onlyExt(withRoot(QStringLiteral("docs")), QStringLiteral(".xlsx"))); }, {} },
+        { QStringLiteral("any-text"), QStringLiteral("весь корпус, отбор по содержимому"),
+          [&] { return runGenerate(anyText); }, {} },
+        { QStringLiteral("full"), QStringLiteral("весь корпус с документами"),
+          [&] { return runGenerate(full); }, {} },
+        { QStringLiteral("full-serial"), QStringLiteral("весь корпус, 1 поток обхода и извлечения"),
+          [&] { return runGenerate(serial); }, {} },
+        { QStringLiteral("full-cached"), QStringLiteral("весь корпус, тёплый кэш извлечения"),
+          [&] { return runGenerate(cached); }, [&] { runGenerate(cached); } },
+        { QStringLiteral("utf8-selfcheck"),
+          QStringLiteral("utf8IsValid/utf8DecodeStrictTo (%1) против побайтового эталона, 200000 случайных входов")
+              .arg(QLatin1String(utf8SimdPath())),
+          [&] { return runUtf8Check(spec.seed, 200000); }, {} },
+    };
+    if (havePdf)
+    {
+        scenarios.push_back({ QStringLiteral("pdf"), QStringLiteral("docs/*.pdf: извлечение"),
+                              [&] { return runGenerate(onlyExt(withRoot(QStringLiteral("docs")), QStringLiteral(".pdf"))); },
+                              {} });
+    }
+
+    if (parser.isSet(listOpt))
+    {
+        QTextStream out(stdout);
+        for (const Scenario& s : scenarios)
+            out << s.name << "\t" << s.description << "\n";
+        return 0;
+    }
+
+    const QStringList only = parseUserList(parser.values(onlyOpt).join(QLatin1Char(',')), false, true);
+
+    QJsonArray results;
+    bool allOk = true;
+    for (const Scenario& s : scenarios)
+    {
+        if (!only.isEmpty() && !only.contains(s.name))
+            continue;
+
+        err() << "  " << s.name << "...\n";
+        err().flush();
+
+        const bool rssReset = resetPeakRss();
+        if (s.warmUp)
+            s.warmUp();
+
+        QVector<double> total, scan, contents;
+        QMap<QString, QVector<double>> phaseRuns;
+        RunResult last;
+        for (int i = 0; i < repeat; ++i)
+        {
+            last = s.run();
+            total.push_back(last.totalMs);
+            scan.push_back(last.scanMs);
+            contents.push_back(last.contentsMs);
+            for (auto it = last.phaseMs.constBegin(); it != last.phaseMs.constEnd(); ++it)
+                phaseRuns[it.key()].push_back(it.value());
+            if (!last.ok)
+                break;
+        }
+        allOk = allOk && last.ok;
+
+        const QJsonObject totalStat = stat(total);
+        const double medianSec = totalStat.value(QStringLiteral("median")).toDouble() / 1000.0;
+
+        QJsonObject o;
+        o.insert(QStringLiteral("name"), s.name);
+        o.insert(QStringLiteral("description"), s.description);
+        o.insert(QStringLiteral("ok"), last.ok);
+        if (!last.error.isEmpty())
+            o.insert(QStringLiteral("message"), last.error);
+        o.insert(QStringLiteral("runs"), total.size());
+        o.insert(QStringLiteral("totalMs"), totalStat);
+        o.insert(QStringLiteral("scanMs"), stat(scan));
+        o.insert(QStringLiteral("contentsMs"), stat(contents));
+        if (!phaseRuns.isEmpty())
+        {
+            QJsonObject phases;
+            for (auto it = phaseRuns.constBegin(); it != phaseRuns.constEnd(); ++it)
+                phases.insert(it.key(), stat(it.value()));
+            o.insert(QStringLiteral("profileMs"), phases);
+            o.insert(QStringLiteral("extractors"), last.extractors);
+        }
+        o.insert(QStringLiteral("entries"), last.entries);
+        o.insert(QStringLiteral("files"), last.files);
+        o.insert(QStringLiteral("filesExtracted"), last.filesExtracted);
+        o.insert(QStringLiteral("bytesRead"), last.bytesRead);
+        o.insert(QStringLiteral("reportChars"), last.reportChars);
+        o.insert(QStringLiteral("mbPerSec"), medianSec > 0 ? last.bytesRead / (1024.0 * 1024.0) / medianSec : 0.0);
+        o.insert(QStringLiteral("filesPerSec"), medianSec > 0 ? last.files / medianSec : 0.0);
+        o.insert(QStringLiteral("peakRssBytes"), peakRssBytes());
+        o.insert(QStringLiteral("peakRssPerScenario"), rssReset);
+        results.push_back(o);
+    }
+
+    QJsonObject corpusInfo;
+    corpusInfo.insert(QStringLiteral("path"), corpus);
+    corpusInfo.insert(QStringLiteral("seed"), QString::number(spec.seed));
+    corpusInfo.insert(QStringLiteral("scale"), spec.scale);
+    corpusInfo.insert(QStringLiteral("reused"), reuse);
+    if (!reuse)
+    {
+        corpusInfo.insert(QStringLiteral("files"), corpusStats.files);
+        corpusInfo.insert(QStringLiteral("dirs"), corpusStats.dirs);
+        corpusInfo.insert(QStringLiteral("bytes"), corpusStats.bytes);
+        corpusInfo.insert(QStringLiteral("generateMs"), corpusMs);
+    }
+
+    QJsonObject env;
+    env.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+    env.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+    env.insert(QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture());
+    env.insert(QStringLiteral("threads"), QThread::idealThreadCount());
+    env.insert(QStringLiteral("utf8Simd"), QString::fromLatin1(utf8SimdPath()));
+    env.insert(QStringLiteral("pdfBackend"), QString::fromLatin1(pdfTextBackendId(full.pdfTimeoutMs)));
+
+    QJsonObject root;
+    root.insert(QStringLiteral("tool"), QStringLiteral("ContextMakerBench"));
+    root.insert(QStringLiteral("formatVersion"), 1);
+    root.insert(QStringLiteral("label"), parser.value(labelOpt));
+    root.insert(QStringLiteral("startedUtc"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert(QStringLiteral("repeat"), repeat);
+    root.insert(QStringLiteral("environment"), env);
+    root.insert(QStringLiteral("corpus"), corpusInfo);
+    root.insert(QStringLiteral("scenarios"), results);
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    const QString outPath = parser.value(outOpt);
+    if (outPath.isEmpty())
+    {
+        QFile out;
+        if (!out.open(stdout, QIODevice::WriteOnly) || out.write(json) != json.size())
+            return 1;
+    }
+    else
+    {
+        QFile out(outPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size())
+        {
+            err() << "Не удалось записать " << outPath << ": " << out.errorString() << "\n";
+            return 1;
+        }
+    }
+
+    if (parser.isSet(keepOpt))
+        tempDir.setAutoRemove(false);
+
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file utf8selfcheck.cpp
+ * @brief Реализация самопроверки UTF-8.
+ */
+
+#include "utf8selfcheck.h"
+
+#include "utf8codec.h"
+
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
+
+
+namespace {
+
+/** \brief splitmix64 (как в корпусе): не зависит от версии Qt/STL. */
+class Rng
+{
+public:
+    explicit Rng(quint64 seed) : m_state(seed) {}
+
+    quint64 next()
+    {
+        quint64 z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /** \brief Число в [lo, hi]. */
+    int range(int lo, int hi) { return lo + int(next() % quint64(hi - lo + 1)); }
+
+private:
+    quint64 m_state;
+};
+
+void appendCodePoint(QByteArray& out, uint cp)
+{
+    if (cp < 0x80)
+    {
+        out += char(cp);
+    }
+    else if (cp < 0x800)
+    {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+/** \brief Допустимый не-ASCII символ: 2, 3 или 4 байта (без суррогатов). */
+uint randomCodePoint(Rng& rng)
+{
+    switch (rng.range(0, 2))
+    {
+    case 0:
+        return uint(rng.range(0x80, 0x7FF));
+    case 1:
+    {
+        uint cp = uint(rng.range(0x800, 0xFFFF - 0x800));
+        return cp >= 0xD800 ? cp + 0x800 : cp;
+    }
+    default:
+        return uint(rng.range(0x10000, 0x10FFFF));
+    }
+}
+
+QByteArray randomText(Rng& rng)
+{
+    // В основном короткие строки; часть — длинные, через много векторных блоков.
+    const int roll = rng.range(0, 9);
+    const int target = roll < 6 ? rng.range(0, 96) : roll < 9 ? rng.range(0, 600) : rng.range(0, 4096);
+
+    QByteArray out;
+    out.reserve(target + 4);
+    while (out.size() < target)
+    {
+        if (rng.range(0, 2) > 0)
+        {
+            const int run = rng.range(0, 80);
+            for (int k = 0; k < run; ++k)
+                out += char(rng.range(0, 3) ? rng.range(0x20, 0x7E) : rng.range(0x00, 0x7F));
+        }
+        else
+        {
+            appendCodePoint(out, randomCodePoint(rng));
+        }
+    }
+    return out;
+}
+
+/** \brief Испортить вход одним из типичных способов (результат может оказаться допустимым). */
+void corrupt(Rng& rng, QByteArray& text)
+{
+    static const char* const kBad[] = {
+        "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF",   // продолжение, overlong
+        "\xF0\x80\x80\x80", "\xF0\x8F\xBF\xBF", "\xED\xA0\x80", "\xED\xBF\xBF",   // overlong, суррогаты
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xF8", "\xFE", "\xFF",           // > U+10FFFF, мусор
+        "\xC3", "\xE2\x82", "\xF0\x9F\x98",                                       // обрезанные
+    };
+
+    const int pos = text.isEmpty() ? 0 : rng.range(0, text.size() - 1);
+    switch (rng.range(0, 3))
+    {
+    case 0:
+        text.insert(pos, kBad[rng.next() % (sizeof(kBad) / sizeof(kBad[0]))]);
+        break;
+    case 1:
+        if (!text.isEmpty())
+            text[pos] = char(text.at(pos) ^ char(1 << rng.range(0, 7)));
+        break;
+    case 2:
+        text.truncate(pos);   // может разрезать последний символ
+        break;
+    default:
+        // Случайный старший байт на месте любого — начало, продолжение или мусор.
+        if (text.isEmpty())
+            text += char(rng.range(0x80, 0xFF));
+        else
+            text[pos] = char(rng.range(0x80, 0xFF));
+        break;
+    }
+}
+
+QString hexDump(const char* data, qint64 len)
+{
+    const int shown = int(std::min<qint64>(len, 96));
+    QString hex = QString::fromLatin1(QByteArray(data, shown).toHex(' '));
+    if (shown < len)
+        hex += QStringLiteral(" …");
+    return hex;
+}
+
+} // namespace
+
+
+bool runUtf8SelfCheck(quint64 seed, int count, Utf8SelfCheckStats* stats, QString* errorOut)
+{
+    Rng rng(seed);
+    QByteArray buffer;
+    QVector<char16_t> decoded;
+    Utf8SelfCheckStats s;
+
+    for (int i = 0; i < count; ++i)
+    {
+        QByteArray text = randomText(rng);
+        if (rng.range(0, 1))
+            corrupt(rng, text);
+
+        // Сдвиг от начала буфера: векторные загрузки идут с любого выравнивания.
+        const int shift = rng.range(0, 31);
+        buffer.fill('\0', shift + text.size());
+        std::copy(text.cbegin(), text.cend(), buffer.begin() + shift);
+        const char* data = buffer.constData() + shift;
+        const qint64 len = text.size();
+
+        const bool expected = utf8IsValidScalar(data, len);
+        const bool fast = utf8IsValid(data, len);
+
+        decoded.resize(int(len) + 1);
+        const qint64 n = utf8DecodeStrictTo(data, len, decoded.data());
+
+        QString mismatch;
+        if (fast != expected)
+            mismatch = QStringLiteral("utf8IsValid() = %1, эталон = %2").arg(int(fast)).arg(int(expected));
+        else if ((n >= 0) != expected)
+            mismatch = QStringLiteral("utf8DecodeStrictTo() = %1, эталон = %2").arg(n).arg(int(expected));
+        else if (expected && QString::fromUtf8(data, int(len))
+                                 != QString::fromUtf16(decoded.constData(), int(n)))
+            mismatch = QStringLiteral("utf8DecodeStrictTo() декодировал иначе, чем QString::fromUtf8()");
+
+        if (!mismatch.isEmpty())
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("UTF-8 (%1): вход %2, сдвиг %3, %4 байт: %5; байты: %6")
+                                .arg(QLatin1String(utf8SimdPath()))
+                                .arg(i)
+                                .arg(shift)
+                                .arg(len)
+                                .arg(mismatch, hexDump(data, len));
+            if (stats) *stats = s;
+            return false;
+        }
+
+        ++s.inputs;
+        s.valid += expected ? 1 : 0;
+        s.bytes += len;
+    }
+
+    if (stats) *stats = s;
+    return true;
+}
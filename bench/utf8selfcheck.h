@@ -0,0 +1,32 @@
+/**
+ * @file utf8selfcheck.h
+ * @brief Самопроверка векторного UTF-8 (utf8codec.h) против побайтового эталона.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+
+/** \brief Итог самопроверки. */
+struct Utf8SelfCheckStats
+{
+    qint64 inputs = 0;
+    qint64 valid = 0;    ///< Сколько входов эталон признал строгим UTF-8.
+    qint64 bytes = 0;
+};
+
+/**
+ * @brief Сверить utf8IsValid() и utf8DecodeStrictTo() с utf8IsValidScalar() на случайных входах.
+ * @details
+ *  Входы — ASCII-участки разной длины (через границы блоков 16/32 байта) вперемешку
+ *  с 2-4-байтовыми символами; половина затем портится: лишний байт продолжения, обрезка,
+ *  overlong, суррогат, код выше U+10FFFF, случайный бит. Каждый вход кладётся
+ *  со случайным сдвигом от начала буфера (невыровненные загрузки). Для допустимых входов
+ *  результат декодирования сравнивается с QString::fromUtf8().
+ *  Одинаковые seed и count дают одинаковые входы на любой машине.
+ * @param errorOut Первое расхождение: номер входа, сдвиг и байты в hex.
+ * @return false при первом расхождении.
+ */
+bool runUtf8SelfCheck(quint64 seed, int count, Utf8SelfCheckStats* stats, QString* errorOut = nullptr);
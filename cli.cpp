@@ -0,0 +1,755 @@
+/**
+ * @file cli.cpp
+ * @brief Реализация консольного режима.
+ */
+
+#include "cli.h"
+#include "reportgenerator.h"
+#include "reportmanifest.h"
+#include "optionparse.h"
+#include "compressedoutput.h"
+#include "jobpreset.h"
+#include "batchscheduler.h"
+#include "splitoutput.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+
+namespace {
+
+/** \brief Флаг отмены по Ctrl+C (генератор проверяет его сам). */
+std::atomic_bool g_cancelRequested { false };
+
+void onInterrupt(int)
+{
+    g_cancelRequested.store(true, std::memory_order_relaxed);
+}
+
+#ifdef Q_OS_WIN
+/**
+ * @brief Подключиться к консоли родителя.
+ * @details Приложение собрано как GUI (WIN32_EXECUTABLE), и без явного перенаправления
+ *          у него нет stdout/stderr. Перенаправленные (в файл, pipe) потоки не трогаем.
+ */
+void attachParentConsole()
+{
+    const HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    const HANDLE err = GetStdHandle(STD_ERROR_HANDLE);
+    const bool noOut = (out == nullptr || out == INVALID_HANDLE_VALUE);
+    const bool noErr = (err == nullptr || err == INVALID_HANDLE_VALUE);
+
+    if ((noOut || noErr) && AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        if (noOut)
+            freopen("CONOUT$", "w", stdout);
+        if (noErr)
+            freopen("CONOUT$", "w", stderr);
+    }
+}
+#endif
+
+QTextStream& errStream()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+/** \brief Строка в stderr; отчёты пакета строятся параллельно, поэтому под мьютексом. */
+void printError(const QString& text)
+{
+    static QMutex mutex;
+    const QMutexLocker lock(&mutex);
+    errStream() << text << '\n';
+    errStream().flush();
+}
+
+/** \brief Один отчёт: корень, файл вывода (пусто = stdout) и параметры генератора. */
+struct Job
+{
+    QString root;
+    QString outPath;
+    OutputCompression compression = OutputCompression::None;
+    ReportGenerator::Options options;
+};
+
+/** \brief Имена отчётов в --out-dir: <имя корня>.md, при совпадении — с номером. */
+QString uniqueReportName(const QString& root, QSet<QString>& used)
+{
+    QString base = QFileInfo(root).fileName();
+    if (base.isEmpty())
+        base = QStringLiteral("report");
+
+    QString name = base + QStringLiteral(".md");
+    for (int i = 2; used.contains(name.toLower()); ++i)
+        name = QStringLiteral("%1-%2.md").arg(base).arg(i);
+
+    used.insert(name.toLower());
+    return name;
+}
+
+} // namespace
+
+
+bool isCliInvocation(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--cli") == 0)
+            return true;
+    }
+    return false;
+}
+
+int runCli(int argc, char* argv[])
+{
+#ifdef Q_OS_WIN
+    attachParentConsole();
+#endif
+
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Отчёт по каталогу(-ам): дерево + содержимое текстовых файлов (Markdown).\n"
+        "Без -o/--out-dir отчёт пишется в stdout."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("roots"), QStringLiteral("Корневые каталоги."),
+                                 QStringLiteral("<каталог>..."));
+
+    const QCommandLineOption cliOpt(QStringLiteral("cli"), QStringLiteral("Консольный режим (без окна)."));
+    const QCommandLineOption outOpt({QStringLiteral("o"), QStringLiteral("out")},
+                                    QStringLiteral("Файл отчёта (для одного каталога)."), QStringLiteral("файл"));
+    const QCommandLineOption outDirOpt(QStringLiteral("out-dir"),
+                                       QStringLiteral("Папка для отчётов (<имя каталога>.md на каждый каталог)."),
+                                       QStringLiteral("папка"));
+    const QCommandLineOption bomOpt(QStringLiteral("bom"), QStringLiteral("Писать BOM UTF-8 в начало файла отчёта."));
+    const QCommandLineOption compressOpt(QStringLiteral("compress"),
+                                         QStringLiteral("Сжимать файл отчёта: gzip или zstd (по умолчанию — по расширению -o: .gz/.zst)."),
+                                         QStringLiteral("формат"));
+    const QCommandLineOption includeOpt(QStringLiteral("include-ext"),
+                                        QStringLiteral("Расширения файлов секции 2 (через запятую, можно повторять)."),
+                                        QStringLiteral("список"));
+    const QCommandLineOption excludeOpt(QStringLiteral("exclude-dir"),
+                                        QStringLiteral("Исключаемые папки: имя, маска или путь от корня (можно повторять)."),
+                                        QStringLiteral("список"));
+    const QCommandLineOption maxBytesOpt(QStringLiteral("max-bytes"),
+                                         QStringLiteral("Не читать файлы больше этого размера (по умолчанию 1MB)."),
+                                         QStringLiteral("размер"), QStringLiteral("1MB"));
+    const QCommandLineOption maxOutOpt(QStringLiteral("max-out-chars"),
+                                       QStringLiteral("Лимит текста на файл, 0 = без лимита (по умолчанию 1MB)."),
+                                       QStringLiteral("размер"), QStringLiteral("1MB"));
+    const QCommandLineOption cmdTreeOpt(QStringLiteral("cmd-tree"), QStringLiteral("Дерево через tree /F /A (Windows)."));
+    const QCommandLineOption cmdTreeTimeoutOpt(QStringLiteral("cmd-tree-timeout"),
+                                               QStringLiteral("Секунд на tree /F /A, 0 = без ограничения (по умолчанию 120); "
+                                                              "по таймауту — встроенное дерево."),
+                                               QStringLiteral("сек"), QStringLiteral("120"));
+    const QCommandLineOption treeStyleOpt(QStringLiteral("tree-style"),
+                                          QStringLiteral("Оформление дерева: unicode или ascii (как tree /F /A, без cmd)."),
+                                          QStringLiteral("стиль"), QStringLiteral("unicode"));
+    const QCommandLineOption treeOnlyOpt(QStringLiteral("tree-only"), QStringLiteral("Только дерево, без содержимого файлов."));
+    const QCommandLineOption treeDepthOpt(QStringLiteral("tree-depth"),
+                                          QStringLiteral("Глубина дерева (0 = без ограничения); глубже — сводкой."),
+                                          QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption treeEntriesOpt(QStringLiteral("tree-max-entries"),
+                                            QStringLiteral("Элементов на папку в дереве (0 = все); остальные — сводкой."),
+                                            QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption treeIncludedOpt(QStringLiteral("tree-included-only"),
+                                             QStringLiteral("В дереве только папки, где есть файлы для секции содержимого."));
+    const QCommandLineOption encodingOpt(QStringLiteral("encoding"),
+                                         QStringLiteral("Файлы без BOM: auto (UTF-8, иначе ANSI) или ansi."),
+                                         QStringLiteral("режим"), QStringLiteral("auto"));
+    const QCommandLineOption pdfPagesOpt(QStringLiteral("pdf-max-pages"),
+                                         QStringLiteral("Сколько первых страниц PDF извлекать, 0 = все."),
+                                         QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption pdfTimeoutOpt(QStringLiteral("pdf-timeout"),
+                                           QStringLiteral("Секунд на один PDF, 0 = без ограничения (по умолчанию 120)."),
+                                           QStringLiteral("сек"), QStringLiteral("120"));
+    const QCommandLineOption budgetOpt(QStringLiteral("budget"),
+                                       QStringLiteral("Общий бюджет отчёта в символах (например 2M); файлы сверх него не читаются."),
+                                       QStringLiteral("размер"));
+    const QCommandLineOption budgetTokensOpt(QStringLiteral("budget-tokens"),
+                                             QStringLiteral("То же в токенах (≈4 символа на токен), например 200K."),
+                                             QStringLiteral("n"));
+    const QCommandLineOption orderOpt(QStringLiteral("budget-order"),
+                                      QStringLiteral("Порядок заполнения бюджета: path, small (маленькие сначала), new (новые сначала)."),
+                                      QStringLiteral("порядок"), QStringLiteral("path"));
+    const QCommandLineOption priorityOpt(QStringLiteral("priority"),
+                                         QStringLiteral("Вес путей для бюджета: маска=вес (можно повторять), например src/*=10."),
+                                         QStringLiteral("правило"));
+    const QCommandLineOption anyTextOpt(QStringLiteral("any-text"),
+                                        QStringLiteral("Любые текстовые файлы (определяется по содержимому), не только из --include-ext."));
+    const QCommandLineOption dedupOpt(QStringLiteral("dedup"),
+                                      QStringLiteral("Одинаковые по содержимому файлы выводить один раз (повторы — ссылкой)."));
+    const QCommandLineOption jobsOpt({QStringLiteral("j"), QStringLiteral("jobs")},
+                                     QStringLiteral("Потоков извлечения (0 = по числу ядер)."),
+                                     QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption scanThreadsOpt(QStringLiteral("scan-threads"),
+                                            QStringLiteral("Потоков обхода каталога (0 = авто, 1 = последовательно)."),
+                                            QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption noCacheOpt(QStringLiteral("no-cache"), QStringLiteral("Не использовать кэш извлечённого текста."));
+    const QCommandLineOption cacheDirOpt(QStringLiteral("cache-dir"), QStringLiteral("Папка кэша извлечённого текста."),
+                                         QStringLiteral("папка"));
+    const QCommandLineOption incrementalOpt(QStringLiteral("incremental"),
+                                            QStringLiteral("Перегенерация: неизменённые файлы берутся из прошлого отчёта (того же файла вывода)."));
+    const QCommandLineOption sinceOpt(QStringLiteral("since"),
+                                      QStringLiteral("Прошлый отчёт для сравнения (рядом — его .manifest)."),
+                                      QStringLiteral("файл"));
+    const QCommandLineOption changedOnlyOpt(QStringLiteral("changed-only"),
+                                            QStringLiteral("Только новые/изменённые файлы относительно прошлого отчёта."));
+    const QCommandLineOption manifestOpt(QStringLiteral("manifest"),
+                                         QStringLiteral("Записать <отчёт>.manifest для следующей инкрементальной сборки."));
+    const QCommandLineOption profileOpt(QStringLiteral("profile"),
+                                        QStringLiteral("Дописать в отчёт раздел с профилем: время фаз, экстракторы, самые долгие файлы."));
+    const QCommandLineOption profileTopOpt(QStringLiteral("profile-top"),
+                                           QStringLiteral("Сколько самых долгих файлов показывать в профиле (по умолчанию 20)."),
+                                           QStringLiteral("n"), QStringLiteral("20"));
+    const QCommandLineOption traceOpt(QStringLiteral("trace"),
+                                      QStringLiteral("Записать трассу генерации (Chrome trace events JSON, для chrome://tracing / Perfetto)."),
+                                      QStringLiteral("файл"));
+    const QCommandLineOption splitOpt(QStringLiteral("split"),
+                                      QStringLiteral("Резать отчёт на части не больше этого числа символов (например 400K): <отчёт>.part001.md, ..."),
+                                      QStringLiteral("размер"));
+    const QCommandLineOption splitTokensOpt(QStringLiteral("split-tokens"),
+                                            QStringLiteral("То же в токенах (≈4 символа на токен), например 100K."),
+                                            QStringLiteral("n"));
+    const QCommandLineOption presetOpt(QStringLiteral("preset"),
+                                       QStringLiteral("Файл пресетов (JSON): задания с каталогами, выводом и параметрами (можно повторять)."),
+                                       QStringLiteral("файл"));
+    const QCommandLineOption presetJobOpt(QStringLiteral("preset-job"),
+                                          QStringLiteral("Только задания с этим именем (можно повторять)."),
+                                          QStringLiteral("имя"));
+    const QCommandLineOption savePresetOpt(QStringLiteral("save-preset"),
+                                           QStringLiteral("Добавить каталоги и параметры этой командной строки заданием в файл пресетов "
+                                                          "(задание с тем же именем заменяется) и выйти."),
+                                           QStringLiteral("файл"));
+    const QCommandLineOption parallelOpt(QStringLiteral("parallel"),
+                                         QStringLiteral("Сколько отчётов строить одновременно (0 = по числу дисков)."),
+                                         QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption perDeviceOpt(QStringLiteral("per-device"),
+                                          QStringLiteral("Сколько отчётов одного диска строить одновременно (по умолчанию 1)."),
+                                          QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption quietOpt({QStringLiteral("q"), QStringLiteral("quiet")},
+                                      QStringLiteral("Не печатать сводку в stderr."));
+
+    parser.addOptions({cliOpt, outOpt, outDirOpt, bomOpt, compressOpt, includeOpt, excludeOpt, maxBytesOpt, maxOutOpt,
+                       cmdTreeOpt, cmdTreeTimeoutOpt, treeStyleOpt, treeOnlyOpt, treeDepthOpt, treeEntriesOpt, treeIncludedOpt, encodingOpt, pdfPagesOpt, pdfTimeoutOpt, budgetOpt, budgetTokensOpt, orderOpt, priorityOpt, dedupOpt, anyTextOpt, jobsOpt, scanThreadsOpt, noCacheOpt, cacheDirOpt,
+                       incrementalOpt, sinceOpt, changedOnlyOpt, manifestOpt, profileOpt, profileTopOpt, traceOpt, splitOpt, splitTokensOpt,
+                       presetOpt, presetJobOpt, savePresetOpt, parallelOpt, perDeviceOpt, quietOpt});
+
+    if (!parser.parse(QCoreApplication::arguments()))
+    {
+        printError(parser.errorText());
+        return 2;
+    }
+    if (parser.isSet(QStringLiteral("help")))
+    {
+        printError(parser.helpText());
+        return 0;
+    }
+
+    auto usageError = [](const QString& text) {
+        printError(text);
+        return 2;
+    };
+
+    // --- Параметры генератора ---
+    ReportGenerator::Options base;
+
+    QString sizeErr;
+    if (!parseHumanSizeToBytes(parser.value(maxBytesOpt), &base.maxBytes, &sizeErr))
+        return usageError(QStringLiteral("--max-bytes: %1").arg(sizeErr));
+    if (!parseHumanSizeToBytesAllowZero(parser.value(maxOutOpt), &base.maxOutChars, &sizeErr))
+        return usageError(QStringLiteral("--max-out-chars: %1").arg(sizeErr));
+
+    base.includeExt = parseUserList(parser.values(includeOpt).join(QLatin1Char(',')), true, true);
+    if (base.includeExt.isEmpty())
+        base.includeExt = defaultIncludeExt();
+
+    base.excludeDirNames = parseUserList(parser.values(excludeOpt).join(QLatin1Char(',')), false, true);
+    if (base.excludeDirNames.isEmpty())
+        base.excludeDirNames = defaultExcludeDirs();
+
+    base.useCmdTree = parser.isSet(cmdTreeOpt);
+
+    bool cmdTreeTimeoutOk = false;
+    const int cmdTreeTimeoutSec = parser.value(cmdTreeTimeoutOpt).toInt(&cmdTreeTimeoutOk);
+    if (!cmdTreeTimeoutOk || cmdTreeTimeoutSec < 0 || cmdTreeTimeoutSec > 24 * 3600)
+        return usageError(QStringLiteral("--cmd-tree-timeout: ожидается число секунд от 0 до 86400"));
+    base.cmdTreeTimeoutMs = cmdTreeTimeoutSec * 1000;
+    base.treeOnly = parser.isSet(treeOnlyOpt);
+
+    const QString treeStyle = parser.value(treeStyleOpt).trimmed().toLower();
+    if (treeStyle == QStringLiteral("ascii"))
+        base.treeStyle = ReportGenerator::Options::TreeStyle::Ascii;
+    else if (treeStyle == QStringLiteral("unicode"))
+        base.treeStyle = ReportGenerator::Options::TreeStyle::Unicode;
+    else
+        return usageError(QStringLiteral("--tree-style: ожидается unicode или ascii"));
+    base.treeOnlyIncludedDirs = parser.isSet(treeIncludedOpt);
+
+    bool treeDepthOk = false;
+    base.treeMaxDepth = parser.value(treeDepthOpt).toInt(&treeDepthOk);
+    if (!treeDepthOk || base.treeMaxDepth < 0)
+        return usageError(QStringLiteral("--tree-depth: ожидается число >= 0"));
+
+    bool treeEntriesOk = false;
+    base.treeMaxEntriesPerDir = parser.value(treeEntriesOpt).toInt(&treeEntriesOk);
+    if (!treeEntriesOk || base.treeMaxEntriesPerDir < 0)
+        return usageError(QStringLiteral("--tree-max-entries: ожидается число >= 0"));
+
+    const QString encoding = parser.value(encodingOpt).trimmed().toLower();
+    if (encoding == QStringLiteral("ansi"))
+        base.noBomEncodingMode = ReportGenerator::Options::NoBomEncodingMode::ForceAnsi;
+    else if (encoding == QStringLiteral("auto"))
+        base.noBomEncodingMode = ReportGenerator::Options::NoBomEncodingMode::AutoUtf8ThenAnsi;
+    else
+        return usageError(QStringLiteral("--encoding: ожидается auto или ansi"));
+
+    if (parser.isSet(budgetOpt) && parser.isSet(budgetTokensOpt))
+        return usageError(QStringLiteral("--budget и --budget-tokens вместе не используются."));
+    if (parser.isSet(budgetOpt)
+        && !parseHumanSizeToBytesAllowZero(parser.value(budgetOpt), &base.reportBudgetChars, &sizeErr))
+        return usageError(QStringLiteral("--budget: %1").arg(sizeErr));
+    if (parser.isSet(budgetTokensOpt))
+    {
+        qint64 tokens = 0;
+        if (!parseHumanSizeToBytesAllowZero(parser.value(budgetTokensOpt), &tokens, &sizeErr))
+            return usageError(QStringLiteral("--budget-tokens: %1").arg(sizeErr));
+        base.reportBudgetChars = tokens * ReportGenerator::Options::kCharsPerToken;
+    }
+
+    const QString order = parser.value(orderOpt).trimmed().toLower();
+    if (order == QStringLiteral("path"))
+        base.budgetOrder = ReportGenerator::Options::BudgetOrder::Path;
+    else if (order == QStringLiteral("small"))
+        base.budgetOrder = ReportGenerator::Options::BudgetOrder::SmallestFirst;
+    else if (order == QStringLiteral("new"))
+        base.budgetOrder = ReportGenerator::Options::BudgetOrder::NewestFirst;
+    else
+        return usageError(QStringLiteral("--budget-order: ожидается path, small или new"));
+
+    for (const QString& rule : parser.values(priorityOpt))
+    {
+        const int eq = rule.lastIndexOf(QLatin1Char('='));
+        bool weightOk = false;
+        if (eq > 0)
+            rule.mid(eq + 1).trimmed().toInt(&weightOk);
+        if (!weightOk)
+            return usageError(QStringLiteral("--priority: ожидается маска=вес, получено \"%1\"").arg(rule));
+        base.priorityRules << rule;
+    }
+
+    bool pdfPagesOk = false;
+    base.pdfMaxPages = parser.value(pdfPagesOpt).toInt(&pdfPagesOk);
+    if (!pdfPagesOk || base.pdfMaxPages < 0)
+        return usageError(QStringLiteral("--pdf-max-pages: ожидается число >= 0"));
+
+    bool pdfTimeoutOk = false;
+    const int pdfTimeoutSec = parser.value(pdfTimeoutOpt).toInt(&pdfTimeoutOk);
+    if (!pdfTimeoutOk || pdfTimeoutSec < 0 || pdfTimeoutSec > 24 * 3600)
+        return usageError(QStringLiteral("--pdf-timeout: ожидается число секунд от 0 до 86400"));
+    base.pdfTimeoutMs = pdfTimeoutSec * 1000;
+
+    bool jobsOk = false;
+    const int jobs = parser.value(jobsOpt).toInt(&jobsOk);
+    if (!jobsOk || jobs < 0)
+        return usageError(QStringLiteral("--jobs: ожидается число >= 0"));
+
+    bool scanThreadsOk = false;
+    base.scanThreads = parser.value(scanThreadsOpt).toInt(&scanThreadsOk);
+    if (!scanThreadsOk || base.scanThreads < 0 || base.scanThreads > 64)
+        return usageError(QStringLiteral("--scan-threads: ожидается число от 0 до 64"));
+
+    base.useExtractionCache = !parser.isSet(noCacheOpt);
+    base.cacheDir = parser.value(cacheDirOpt);
+    base.changedOnly = parser.isSet(changedOnlyOpt);
+    base.dedupContent = parser.isSet(dedupOpt);
+    base.includeAnyText = parser.isSet(anyTextOpt);
+    base.cancelRequested = &g_cancelRequested;
+
+    base.profileAppendix = parser.isSet(profileOpt);
+    bool profileTopOk = false;
+    base.profileSlowestFiles = parser.value(profileTopOpt).toInt(&profileTopOk);
+    if (!profileTopOk || base.profileSlowestFiles < 0)
+        return usageError(QStringLiteral("--profile-top: ожидается число >= 0"));
+
+    // --- Что и куда писать ---
+    const QStringList roots = parser.positionalArguments();
+    const QStringList presetFiles = parser.values(presetOpt);
+    if (roots.isEmpty() && presetFiles.isEmpty())
+        return usageError(QStringLiteral("Не задан ни один каталог. См. --help."));
+
+    const QString outPath = parser.value(outOpt);
+    const QString outDir = parser.value(outDirOpt);
+    if (!outPath.isEmpty() && !outDir.isEmpty())
+        return usageError(QStringLiteral("-o и --out-dir вместе не используются."));
+    if (!outPath.isEmpty() && (roots.size() > 1 || !presetFiles.isEmpty()))
+        return usageError(QStringLiteral("-o задаёт один файл; для нескольких каталогов используйте --out-dir."));
+
+    if (parser.isSet(savePresetOpt))
+    {
+        if (roots.isEmpty())
+            return usageError(QStringLiteral("--save-preset: не задан ни один каталог."));
+
+        JobPreset preset;
+        for (const QString& root : roots)
+            preset.roots << QDir::cleanPath(QFileInfo(root).absoluteFilePath());
+        preset.name = QFileInfo(preset.roots.first()).fileName();
+        if (!outPath.isEmpty())
+            preset.outPath = QFileInfo(outPath).absoluteFilePath();
+        if (!outDir.isEmpty())
+            preset.outDir = QFileInfo(outDir).absoluteFilePath();
+        preset.options = base;
+
+        QString saveErr;
+        if (!saveJobPreset(parser.value(savePresetOpt), preset, &saveErr))
+        {
+            printError(saveErr);
+            return 1;
+        }
+        return 0;
+    }
+
+    qint64 splitChars = 0;
+    if (parser.isSet(splitOpt) && parser.isSet(splitTokensOpt))
+        return usageError(QStringLiteral("--split и --split-tokens вместе не используются."));
+    if (parser.isSet(splitOpt) && !parseHumanSizeToBytes(parser.value(splitOpt), &splitChars, &sizeErr))
+        return usageError(QStringLiteral("--split: %1").arg(sizeErr));
+    if (parser.isSet(splitTokensOpt))
+    {
+        qint64 tokens = 0;
+        if (!parseHumanSizeToBytes(parser.value(splitTokensOpt), &tokens, &sizeErr))
+            return usageError(QStringLiteral("--split-tokens: %1").arg(sizeErr));
+        splitChars = tokens * ReportGenerator::Options::kCharsPerToken;
+    }
+    if (splitChars > 0 && splitChars < 4 * SplitReportSink::kHeaderReserve)
+        return usageError(QStringLiteral("--split: часть должна быть не меньше %1 символов.")
+                              .arg(4 * SplitReportSink::kHeaderReserve));
+
+    bool parallelOk = false;
+    const int parallel = parser.value(parallelOpt).toInt(&parallelOk);
+    if (!parallelOk || parallel < 0)
+        return usageError(QStringLiteral("--parallel: ожидается число >= 0"));
+    bool perDeviceOk = false;
+    const int perDevice = parser.value(perDeviceOpt).toInt(&perDeviceOk);
+    if (!perDeviceOk || perDevice < 1)
+        return usageError(QStringLiteral("--per-device: ожидается число >= 1"));
+
+    const bool incremental = parser.isSet(incrementalOpt);
+    const bool writeManifest = parser.isSet(manifestOpt);
+    const bool writeBom = parser.isSet(bomOpt);
+    const QString since = parser.value(sinceOpt);
+
+    OutputCompression compression = compressionForPath(outPath);
+    if (parser.isSet(compressOpt))
+    {
+        const QString format = parser.value(compressOpt).trimmed().toLower();
+        if (format == QStringLiteral("gzip") || format == QStringLiteral("gz"))
+            compression = OutputCompression::Gzip;
+        else if (format == QStringLiteral("zstd") || format == QStringLiteral("zst"))
+            compression = OutputCompression::Zstd;
+        else
+            return usageError(QStringLiteral("--compress: ожидается gzip или zstd"));
+    }
+
+    // Задания: каталоги командной строки с её параметрами, затем задания пресетов.
+    QVector<Job> jobsList;
+    QHash<QString, QSet<QString>> usedNames;   // имена отчётов — по папкам вывода
+    auto addJob = [&](const QString& root, const QString& file, const QString& dir,
+                      const ReportGenerator::Options& options) {
+        Job j;
+        j.root = root;
+        j.options = options;
+        if (!file.isEmpty())
+        {
+            j.outPath = file;
+            j.compression = parser.isSet(compressOpt) ? compression : compressionForPath(file);
+        }
+        else if (!dir.isEmpty())
+        {
+            QSet<QString>& used = usedNames[QDir::cleanPath(QFileInfo(dir).absoluteFilePath()).toLower()];
+            j.compression = compression;
+            j.outPath = QDir(dir).filePath(uniqueReportName(QDir::cleanPath(QFileInfo(root).absoluteFilePath()), used))
+                        + compressionSuffix(compression);
+        }
+        jobsList.push_back(j);
+    };
+
+    for (const QString& root : roots)
+        addJob(root, outPath, outDir, base);
+
+    const QStringList presetNames = parser.values(presetJobOpt);
+    for (const QString& presetFile : presetFiles)
+    {
+        QVector<JobPreset> presets;
+        QString presetErr;
+        if (!loadJobPresets(presetFile, base, &presets, &presetErr))
+            return usageError(presetErr);
+
+        for (const JobPreset& preset : presets)
+        {
+            if (!presetNames.isEmpty() && !presetNames.contains(preset.name, Qt::CaseInsensitive))
+                continue;
+            // Папка вывода пресета, иначе --out-dir командной строки, иначе stdout.
+            for (const QString& root : preset.roots)
+                addJob(root, preset.outPath, preset.outPath.isEmpty() && preset.outDir.isEmpty() ? outDir : preset.outDir,
+                       preset.options);
+        }
+    }
+    if (jobsList.isEmpty())
+        return usageError(QStringLiteral("--preset-job: в пресетах нет заданий с такими именами."));
+
+    bool toStdout = false;
+    QSet<QString> outPaths;
+    for (const Job& job : jobsList)
+    {
+        toStdout = toStdout || job.outPath.isEmpty();
+        if (job.outPath.isEmpty())
+            continue;
+        const QString key = QDir::cleanPath(QFileInfo(job.outPath).absoluteFilePath()).toLower();
+        if (outPaths.contains(key))
+            return usageError(QStringLiteral("Два задания пишут в один файл: %1").arg(job.outPath));
+        outPaths.insert(key);
+
+        if (job.compression != OutputCompression::None && !compressionAvailable(job.compression))
+            return usageError(QStringLiteral("Эта сборка не умеет сжимать в %1.").arg(compressionSuffix(job.compression)));
+        // Блоки прошлого отчёта берутся по смещениям несжатого файла.
+        if (job.compression != OutputCompression::None && (incremental || writeManifest || !since.isEmpty()))
+            return usageError(QStringLiteral("Сжатый отчёт несовместим с --incremental, --since и --manifest."));
+    }
+
+    if (toStdout && (incremental || writeManifest))
+        return usageError(QStringLiteral("--incremental и --manifest требуют вывода в файл (-o или --out-dir)."));
+    if (toStdout && parser.isSet(compressOpt))
+        return usageError(QStringLiteral("--compress требует вывода в файл (-o или --out-dir)."));
+    if (splitChars > 0 && toStdout)
+        return usageError(QStringLiteral("--split требует вывода в файл (-o или --out-dir)."));
+    // Части не описываются манифестом инкрементальной сборки: смещения блоков у каждой части свои.
+    if (splitChars > 0 && (incremental || writeManifest || !since.isEmpty()))
+        return usageError(QStringLiteral("Отчёт частями несовместим с --incremental, --since и --manifest."));
+
+    const QString tracePath = parser.value(traceOpt);
+    if (!tracePath.isEmpty() && jobsList.size() > 1)
+        return usageError(QStringLiteral("--trace задаёт один файл трассы; укажите один каталог."));
+    if (!since.isEmpty() && jobsList.size() > 1)
+        return usageError(QStringLiteral("--since задаёт один прошлый отчёт; для нескольких каталогов используйте --incremental."));
+    if (base.changedOnly && !incremental && since.isEmpty())
+        return usageError(QStringLiteral("--changed-only требует --since или --incremental."));
+
+    // Общий пул на все отчёты: потоки не пересоздаются, одновременные отчёты делят ядра.
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs > 0 ? jobs : std::max(1, QThread::idealThreadCount()));
+
+    std::signal(SIGINT, onInterrupt);
+
+    QFile stdoutFile;
+    if (toStdout && !stdoutFile.open(stdout, QIODevice::WriteOnly))
+    {
+        printError(QStringLiteral("Не удалось открыть stdout: %1").arg(stdoutFile.errorString()));
+        return 1;
+    }
+
+    const bool quiet = parser.isSet(quietOpt);
+    std::atomic_int failed { 0 };
+
+    // Вызывается из очередей планировщика: всё, что пишется в общее, — атомарно или под мьютексом.
+    auto runJob = [&](int i) {
+        const Job& job = jobsList.at(i);
+        if (g_cancelRequested.load(std::memory_order_relaxed))
+            return;
+
+        ReportGenerator::Options opt = job.options;
+        opt.rootPath = job.root;
+        opt.threadPool = &pool;
+        opt.cancelRequested = &g_cancelRequested;
+
+        ReportProgress progress;
+        opt.progress = &progress;
+        ReportProfile profile;
+        if (!tracePath.isEmpty())
+            opt.profile = &profile;
+
+        if (!job.outPath.isEmpty())
+        {
+            if (!since.isEmpty())
+                opt.previousReportPath = since;
+            else if (incremental && QFileInfo::exists(job.outPath))
+                opt.previousReportPath = job.outPath;
+
+            // В режиме "только изменённые" манифест не пишется, базой остаётся прошлый полный отчёт.
+            if ((incremental || writeManifest) && !opt.changedOnly)
+                opt.manifestPath = ReportManifest::pathForReport(job.outPath);
+        }
+
+        ReportGenerator gen(opt);
+        QString error;
+        bool ok = false;
+        int partCount = 0;
+
+        if (splitChars > 0)
+        {
+            // Части пишутся по мере заполнения; каждая сжимается форматом задания (--compress или расширение).
+            QDir().mkpath(QFileInfo(job.outPath).absolutePath());
+            SplitReportSink parts(job.outPath, splitChars, writeBom, job.compression);
+            ok = gen.generate(parts, &error) && parts.finish(&error);
+            if (ok)
+                partCount = parts.parts().size();
+            else
+                parts.discard();
+        }
+        else if (job.outPath.isEmpty())
+        {
+            // Несколько отчётов в stdout разделяем пустой строкой.
+            if (i > 0)
+                stdoutFile.write("\n\n");
+            ok = gen.generateToDevice(&stdoutFile, &error);
+            stdoutFile.flush();
+        }
+        else
+        {
+            QDir().mkpath(QFileInfo(job.outPath).absolutePath());
+
+            // QSaveFile: прошлый отчёт остаётся на месте до commit() — из него берутся блоки.
+            QSaveFile file(job.outPath);
+            if (!file.open(QIODevice::WriteOnly))
+            {
+                error = QStringLiteral("Не удалось открыть файл для записи: %1").arg(file.errorString());
+            }
+            else
+            {
+                // Сжатие на лету: отчёт идёт в компрессор теми же кусками, что и в файл.
+                CompressedWriteDevice packed(&file, job.compression);
+                QIODevice* device = &file;
+                if (job.compression != OutputCompression::None)
+                {
+                    if (packed.open(QIODevice::WriteOnly))
+                        device = &packed;
+                    else
+                        device = nullptr;
+                }
+
+                if (!device)
+                {
+                    error = packed.errorString();
+                }
+                else
+                {
+                    if (writeBom)
+                        device->write("\xEF\xBB\xBF", 3);
+
+                    ok = gen.generateToDevice(device, &error);
+                    if (ok && device == &packed && !packed.finish())
+                    {
+                        ok = false;
+                        error = QStringLiteral("Не удалось записать отчёт: %1").arg(packed.errorString());
+                    }
+                }
+
+                if (ok && !file.commit())
+                {
+                    ok = false;
+                    error = QStringLiteral("Не удалось записать отчёт: %1").arg(file.errorString());
+                }
+                else if (!ok)
+                {
+                    file.cancelWriting();
+                }
+            }
+        }
+
+        // Трасса пишется и для неудачного прогона: по ней видно, где он остановился.
+        QString traceErr;
+        if (!tracePath.isEmpty() && !profile.saveChromeTrace(tracePath, &traceErr))
+            printError(QStringLiteral("%1: предупреждение: %2").arg(job.root, traceErr));
+
+        QString target = job.outPath.isEmpty() ? QStringLiteral("stdout") : job.outPath;
+        if (partCount > 0)
+            target = QStringLiteral("%1 (частей: %2, %3)")
+                         .arg(SplitReportSink::partPath(job.outPath, 1, job.compression))
+                         .arg(partCount)
+                         .arg(SplitReportSink::manifestPath(job.outPath));
+        if (!ok)
+        {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            printError(QStringLiteral("%1: ошибка: %2").arg(job.root, error));
+            return;
+        }
+
+        if (!error.isEmpty())
+            printError(QStringLiteral("%1: предупреждение: %2").arg(job.root, error));
+
+        if (!quiet)
+        {
+            const double elapsedSec = (QDateTime::currentMSecsSinceEpoch() - progress.startedMs.load()) / 1000.0;
+            printError(QStringLiteral("%1 -> %2: %3 файлов (прочитано %4, %5 МБ) за %6 с")
+                           .arg(job.root, target)
+                           .arg(progress.filesDone.load())
+                           .arg(progress.filesExtracted.load())
+                           .arg(progress.bytesRead.load() / (1024.0 * 1024.0), 0, 'f', 1)
+                           .arg(elapsedSec, 0, 'f', 1));
+        }
+    };
+
+    const qint64 batchStartMs = QDateTime::currentMSecsSinceEpoch();
+    int lanes = 1;
+    if (toStdout)
+    {
+        // stdout один на всех: отчёты идут по очереди и в порядке заданий.
+        for (int i = 0; i < jobsList.size(); ++i)
+            runJob(i);
+    }
+    else
+    {
+        QStringList jobRoots;
+        for (const Job& job : jobsList)
+            jobRoots << job.root;
+
+        BatchScheduler scheduler;
+        scheduler.setMaxParallel(parallel);
+        scheduler.setJobsPerDevice(perDevice);
+        lanes = scheduler.run(jobRoots, runJob);
+    }
+
+    if (g_cancelRequested.load(std::memory_order_relaxed))
+    {
+        printError(QStringLiteral("Отменено пользователем."));
+        return 1;
+    }
+
+    if (!quiet && jobsList.size() > 1)
+    {
+        printError(QStringLiteral("Итого: %1 отчётов (ошибок: %2), очередей по дискам: %3, за %4 с")
+                       .arg(jobsList.size())
+                       .arg(failed.load())
+                       .arg(lanes)
+                       .arg((QDateTime::currentMSecsSinceEpoch() - batchStartMs) / 1000.0, 0, 'f', 1));
+    }
+
+    return failed.load() > 0 ? 1 : 0;
+}
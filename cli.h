@@ -0,0 +1,22 @@
+/**
+ * @file cli.h
+ * @brief Консольный режим (без GUI): отчёты из скриптов сборки и CI.
+ */
+
+#pragma once
+
+
+/**
+ * @brief Проверка: программа запущена в консольном режиме (есть аргумент --cli).
+ */
+bool isCliInvocation(int argc, char* argv[]);
+
+/**
+ * @brief Точка входа консольного режима.
+ * @details Создаёт QCoreApplication (окна и дисплей не нужны), разбирает аргументы
+ *          в ReportGenerator::Options и строит отчёты по всем переданным корням
+ *          и заданиям пресетов (--preset, см. jobpreset.h). Отчёты с корнями на разных
+ *          дисках строятся одновременно (BatchScheduler), с общим пулом потоков и общей папкой кэша.
+ * @return Код выхода: 0 — все отчёты построены, 1 — были ошибки, 2 — неверные аргументы.
+ */
+int runCli(int argc, char* argv[]);
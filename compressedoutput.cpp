@@ -0,0 +1,361 @@
+/**
+ * @file compressedoutput.cpp
+ * @brief Реализация потокового сжатия отчёта.
+ */
+
+#include "compressedoutput.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <cstring>
+
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+
+namespace {
+
+/** \brief Размер выходного буфера компрессора. */
+constexpr int kOutChunk = 256 * 1024;
+
+bool writeAllTo(QIODevice* target, const char* data, qint64 left, QString* err)
+{
+    while (left > 0)
+    {
+        const qint64 n = target->write(data, left);
+        if (n <= 0)
+        {
+            *err = target->errorString();
+            if (err->isEmpty())
+                *err = QStringLiteral("Ошибка записи сжатого отчёта.");
+            return false;
+        }
+        data += n;
+        left -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+
+bool compressionAvailable(OutputCompression c)
+{
+    switch (c)
+    {
+    case OutputCompression::None:
+        return true;
+    case OutputCompression::Gzip:
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case OutputCompression::Zstd:
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+OutputCompression compressionForPath(const QString& path)
+{
+    if (path.endsWith(QStringLiteral(".gz"), Qt::CaseInsensitive))
+        return OutputCompression::Gzip;
+    if (path.endsWith(QStringLiteral(".zst"), Qt::CaseInsensitive))
+        return OutputCompression::Zstd;
+    return OutputCompression::None;
+}
+
+QString compressionSuffix(OutputCompression c)
+{
+    switch (c)
+    {
+    case OutputCompression::Gzip: return QStringLiteral(".gz");
+    case OutputCompression::Zstd: return QStringLiteral(".zst");
+    case OutputCompression::None: break;
+    }
+    return {};
+}
+
+
+struct CompressedWriteDevice::Impl
+{
+    QIODevice* target = nullptr;
+    OutputCompression format = OutputCompression::None;
+    int level = -1;
+    bool started = false;
+    bool finished = false;
+    bool finishOk = false;
+    QByteArray out;
+
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+    z_stream zs;
+#endif
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+    ZSTD_CStream* zc = nullptr;
+#endif
+};
+
+
+CompressedWriteDevice::CompressedWriteDevice(QIODevice* target, OutputCompression c, int level)
+    : d(new Impl)
+{
+    d->target = target;
+    d->format = c;
+    d->level = level;
+    d->out.resize(kOutChunk);
+}
+
+CompressedWriteDevice::~CompressedWriteDevice()
+{
+    if (isOpen())
+        close();
+
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+    if (d->started && d->format == OutputCompression::Gzip)
+        deflateEnd(&d->zs);
+#endif
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+    if (d->zc)
+        ZSTD_freeCStream(d->zc);
+#endif
+}
+
+bool CompressedWriteDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::ReadOnly) || !(mode & QIODevice::WriteOnly))
+    {
+        setErrorString(QStringLiteral("Сжатый поток поддерживает только запись."));
+        return false;
+    }
+    if (!d->target || !d->target->isWritable())
+    {
+        setErrorString(QStringLiteral("Не задано устройство вывода."));
+        return false;
+    }
+    if (d->started)
+    {
+        setErrorString(QStringLiteral("Сжатый поток уже использован."));
+        return false;
+    }
+
+    switch (d->format)
+    {
+    case OutputCompression::None:
+        break;
+
+    case OutputCompression::Gzip:
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+        std::memset(&d->zs, 0, sizeof(d->zs));
+        // windowBits 15 + 16: заголовок и CRC gzip вместо zlib.
+        if (deflateInit2(&d->zs, d->level < 0 ? Z_DEFAULT_COMPRESSION : d->level,
+                         Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            setErrorString(QStringLiteral("zlib: не удалось инициализировать сжатие."));
+            return false;
+        }
+        break;
+#else
+        setErrorString(QStringLiteral("Сборка без zlib: сжатие gzip недоступно."));
+        return false;
+#endif
+
+    case OutputCompression::Zstd:
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+        d->zc = ZSTD_createCStream();
+        if (!d->zc || ZSTD_isError(ZSTD_initCStream(d->zc, d->level < 0 ? 3 : d->level)))
+        {
+            setErrorString(QStringLiteral("zstd: не удалось инициализировать сжатие."));
+            return false;
+        }
+        break;
+#else
+        setErrorString(QStringLiteral("Сборка без libzstd: сжатие zstd недоступно."));
+        return false;
+#endif
+    }
+
+    d->started = true;
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void CompressedWriteDevice::close()
+{
+    if (!isOpen())
+        return;
+    finish();
+    QIODevice::close();
+}
+
+qint64 CompressedWriteDevice::readData(char*, qint64)
+{
+    return -1;
+}
+
+qint64 CompressedWriteDevice::writeData(const char* data, qint64 size)
+{
+    if (d->finished)
+        return -1;
+
+    QString err;
+    char* const buf = d->out.data();
+
+    switch (d->format)
+    {
+    case OutputCompression::None:
+        if (!writeAllTo(d->target, data, size, &err))
+        {
+            setErrorString(err);
+            return -1;
+        }
+        return size;
+
+    case OutputCompression::Gzip:
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+    {
+        qint64 left = size;
+        const char* p = data;
+        while (left > 0)
+        {
+            // avail_in — 32-битный: огромные куски подаём частями.
+            const uInt piece = uInt(std::min<qint64>(left, 1 << 30));
+            d->zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(p));
+            d->zs.avail_in = piece;
+            do
+            {
+                d->zs.next_out = reinterpret_cast<Bytef*>(buf);
+                d->zs.avail_out = uInt(kOutChunk);
+                if (deflate(&d->zs, Z_NO_FLUSH) == Z_STREAM_ERROR)
+                {
+                    setErrorString(QStringLiteral("zlib: ошибка сжатия."));
+                    return -1;
+                }
+                if (!writeAllTo(d->target, buf, kOutChunk - d->zs.avail_out, &err))
+                {
+                    setErrorString(err);
+                    return -1;
+                }
+            } while (d->zs.avail_out == 0);
+            p += piece;
+            left -= piece;
+        }
+        return size;
+    }
+#else
+        return -1;
+#endif
+
+    case OutputCompression::Zstd:
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+    {
+        ZSTD_inBuffer in { data, size_t(size), 0 };
+        while (in.pos < in.size)
+        {
+            ZSTD_outBuffer o { buf, size_t(kOutChunk), 0 };
+            const size_t r = ZSTD_compressStream2(d->zc, &o, &in, ZSTD_e_continue);
+            if (ZSTD_isError(r))
+            {
+                setErrorString(QStringLiteral("zstd: %1").arg(QString::fromLatin1(ZSTD_getErrorName(r))));
+                return -1;
+            }
+            if (!writeAllTo(d->target, buf, qint64(o.pos), &err))
+            {
+                setErrorString(err);
+                return -1;
+            }
+        }
+        return size;
+    }
+#else
+        return -1;
+#endif
+    }
+    return -1;
+}
+
+bool CompressedWriteDevice::finish()
+{
+    if (!d->started)
+        return false;
+    if (!d->finished)
+    {
+        d->finished = true;
+        d->finishOk = finishStream();
+    }
+    return d->finishOk;
+}
+
+bool CompressedWriteDevice::finishStream()
+{
+    QString err;
+    char* const buf = d->out.data();
+
+    switch (d->format)
+    {
+    case OutputCompression::None:
+        return true;
+
+    case OutputCompression::Gzip:
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+    {
+        d->zs.next_in = nullptr;
+        d->zs.avail_in = 0;
+        int rc = Z_OK;
+        while (rc != Z_STREAM_END)
+        {
+            d->zs.next_out = reinterpret_cast<Bytef*>(buf);
+            d->zs.avail_out = uInt(kOutChunk);
+            rc = deflate(&d->zs, Z_FINISH);
+            if (rc == Z_STREAM_ERROR)
+            {
+                setErrorString(QStringLiteral("zlib: ошибка сжатия."));
+                return false;
+            }
+            if (!writeAllTo(d->target, buf, kOutChunk - d->zs.avail_out, &err))
+            {
+                setErrorString(err);
+                return false;
+            }
+        }
+        return true;
+    }
+#else
+        return false;
+#endif
+
+    case OutputCompression::Zstd:
+#ifdef CONTEXTMAKER_HAVE_ZSTD
+    {
+        ZSTD_inBuffer in { nullptr, 0, 0 };
+        size_t remaining = 0;
+        do
+        {
+            ZSTD_outBuffer o { buf, size_t(kOutChunk), 0 };
+            remaining = ZSTD_compressStream2(d->zc, &o, &in, ZSTD_e_end);
+            if (ZSTD_isError(remaining))
+            {
+                setErrorString(QStringLiteral("zstd: %1").arg(QString::fromLatin1(ZSTD_getErrorName(remaining))));
+                return false;
+            }
+            if (!writeAllTo(d->target, buf, qint64(o.pos), &err))
+            {
+                setErrorString(err);
+                return false;
+            }
+        } while (remaining != 0);
+        return true;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file compressedoutput.h
+ * @brief Сжатие отчёта на лету (gzip / zstd) поверх любого QIODevice.
+ */
+
+#pragma once
+
+#include <QIODevice>
+#include <QString>
+#include <memory>
+
+
+/**
+ * @brief Формат сжатия файла отчёта.
+ */
+enum class OutputCompression
+{
+    None,
+    Gzip,   ///< .gz, через zlib (CONTEXTMAKER_HAVE_ZLIB)
+    Zstd    ///< .zst, через libzstd (CONTEXTMAKER_HAVE_ZSTD)
+};
+
+/** \brief Формат поддержан этой сборкой (None — всегда). */
+bool compressionAvailable(OutputCompression c);
+
+/** \brief Формат по расширению пути: ".gz" -> Gzip, ".zst" -> Zstd, иначе None. */
+OutputCompression compressionForPath(const QString& path);
+
+/** \brief Расширение файла для формата (".gz", ".zst", пусто для None). */
+QString compressionSuffix(OutputCompression c);
+
+
+/**
+ * @brief Устройство только для записи: сжимает поток и пишет результат в target.
+ * @details Сжатие потоковое — в памяти только рабочие буферы компрессора, а не весь отчёт.
+ *          close() (или деструктор) завершает поток; ошибка записи в target видна
+ *          через errorString() и по возврату false из finish().
+ */
+class CompressedWriteDevice : public QIODevice
+{
+public:
+    /**
+     * @param target Куда писать сжатые данные (уже открыт на запись, не принадлежит нам).
+     * @param c Формат (должен быть доступен, см. compressionAvailable()).
+     * @param level Уровень сжатия; -1 — по умолчанию для формата.
+     */
+    CompressedWriteDevice(QIODevice* target, OutputCompression c, int level = -1);
+    ~CompressedWriteDevice() override;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+
+    /** \brief Дописать хвост потока. Повторный вызов ничего не делает. */
+    bool finish();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> d;
+
+    /** \brief Сбросить остаток компрессора и его завершающие данные в target. */
+    bool finishStream();
+};
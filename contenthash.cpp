@@ -0,0 +1,142 @@
+/**
+ * @file contenthash.cpp
+ * @brief Реализация XXH64 (по спецификации xxHash, без внешней зависимости).
+ */
+
+#include "contenthash.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+
+namespace {
+
+constexpr quint64 kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 kPrime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotl(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Чтение без требований к выравниванию; порядок байт — little-endian, как в эталоне.
+inline quint64 read64(const unsigned char* p)
+{
+    quint64 v;
+    std::memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+inline quint32 read32(const unsigned char* p)
+{
+    quint32 v;
+    std::memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+inline quint64 xxRound(quint64 acc, quint64 input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 val)
+{
+    acc ^= xxRound(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+
+quint64 contentHash64(const char* data, qint64 len, quint64 seed)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + len;
+    quint64 h;
+
+    if (len >= 32)
+    {
+        // Четыре независимые полосы по 8 байт — процессор считает их параллельно.
+        quint64 v1 = seed + kPrime1 + kPrime2;
+        quint64 v2 = seed + kPrime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - kPrime1;
+
+        const unsigned char* const limit = end - 32;
+        do
+        {
+            v1 = xxRound(v1, read64(p));
+            v2 = xxRound(v2, read64(p + 8));
+            v3 = xxRound(v3, read64(p + 16));
+            v4 = xxRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else
+    {
+        h = seed + kPrime5;
+    }
+
+    h += quint64(len);
+
+    while (p + 8 <= end)
+    {
+        h ^= xxRound(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= quint64(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        h ^= quint64(*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        ++p;
+    }
+
+    // Финальное перемешивание (avalanche).
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool fileContentEquals(const QString& path, const char* data, qint64 len)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly) || f.size() != len)
+        return false;
+    if (len == 0)
+        return true;
+
+    if (const uchar* mapped = f.map(0, len))
+    {
+        const bool same = std::memcmp(mapped, data, size_t(len)) == 0;
+        f.unmap(const_cast<uchar*>(mapped));
+        return same;
+    }
+
+    const QByteArray bytes = f.readAll();
+    return bytes.size() == len && std::memcmp(bytes.constData(), data, size_t(len)) == 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file direnum.cpp
+ * @brief Реализация перечисления папки: Win32 / POSIX / Qt.
+ */
+
+#include "direnum.h"
+
+#include <QtGlobal>
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <QDir>
+#elif defined(Q_OS_UNIX)
+#include <QFile>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#endif
+
+
+#if defined(Q_OS_WIN)
+
+namespace {
+
+/** \brief FILETIME (100 нс от 1601 г.) -> мс от эпохи UTC. */
+qint64 fileTimeToMs(const FILETIME& ft)
+{
+    const qint64 ticks = qint64((quint64(ft.dwHighDateTime) << 32) | ft.dwLowDateTime);
+    return (ticks - 116444736000000000LL) / 10000;
+}
+
+/** \brief Шаблон поиска "<папка>\*"; длинные пути — с префиксом \\?\. */
+QString searchPattern(const QString& dirPath)
+{
+    QString native = QDir::toNativeSeparators(dirPath);
+    if (!native.endsWith(QLatin1Char('\\')))
+        native += QLatin1Char('\\');
+
+    if (native.size() >= MAX_PATH - 2 && !native.startsWith(QStringLiteral("\\\\?\\")))
+    {
+        if (native.startsWith(QStringLiteral("\\\\")))
+            native = QStringLiteral("\\\\?\\UNC\\") + native.mid(2);
+        else
+            native = QStringLiteral("\\\\?\\") + native;
+    }
+    return native + QLatin1Char('*');
+}
+
+} // namespace
+
+
+bool enumerateDirectory(const QString& dirPath, QVector<NativeDirEntry>* out)
+{
+    out->clear();
+
+    const QString pattern = searchPattern(dirPath);
+
+    WIN32_FIND_DATAW fd;
+    // FindExInfoBasic: без короткого 8.3 имени; LARGE_FETCH: больше записей за один запрос (SMB).
+    HANDLE h = FindFirstFileExW(reinterpret_cast<LPCWSTR>(pattern.utf16()), FindExInfoBasic, &fd,
+                                FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    do
+    {
+        const wchar_t* n = fd.cFileName;
+        if (n[0] == L'.' && (n[1] == 0 || (n[1] == L'.' && n[2] == 0)))
+            continue;
+
+        NativeDirEntry e;
+        e.name = QString::fromWCharArray(n);
+        e.isDir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        e.isFile = !e.isDir;
+        // Любой reparse point (симлинк, junction, точка монтирования) — как ссылка: внутрь не заходим.
+        e.isSymLink = (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+        e.size = e.isFile ? qint64((quint64(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow) : 0;
+        e.mtimeMs = fileTimeToMs(fd.ftLastWriteTime);
+        out->push_back(std::move(e));
+    } while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+    return true;
+}
+
+#elif defined(Q_OS_UNIX)
+
+namespace {
+
+qint64 statMtimeMs(const struct stat& st)
+{
+#if defined(Q_OS_DARWIN)
+    return qint64(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+    return qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+}
+
+} // namespace
+
+
+bool enumerateDirectory(const QString& dirPath, QVector<NativeDirEntry>* out)
+{
+    out->clear();
+
+    const int dfd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0)
+        return false;
+
+    DIR* dir = ::fdopendir(dfd);   // закрывает dfd в closedir()
+    if (!dir)
+    {
+        ::close(dfd);
+        return false;
+    }
+
+    while (const dirent* d = ::readdir(dir))
+    {
+        const char* n = d->d_name;
+        if (n[0] == '.' && (n[1] == 0 || (n[1] == '.' && n[2] == 0)))
+            continue;
+
+        NativeDirEntry e;
+        e.name = QFile::decodeName(n);
+
+#ifdef DT_DIR
+        // Тип уже пришёл из getdents: для папки размер и время не нужны — без stat.
+        // DT_UNKNOWN (некоторые ФС) и ссылки идут через fstatat() ниже.
+        if (d->d_type == DT_DIR)
+        {
+            e.isDir = true;
+            out->push_back(std::move(e));
+            continue;
+        }
+#endif
+
+        // stat относительно дескриптора папки: ядро не разбирает весь путь заново.
+        struct stat st;
+        if (::fstatat(dfd, n, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;   // элемент исчез между readdir и stat
+
+        e.mtimeMs = statMtimeMs(st);
+
+        if (S_ISLNK(st.st_mode))
+        {
+            e.isSymLink = true;
+            // Тип и размер — по цели (как QFileInfo); битая ссылка — ни файл, ни папка.
+            struct stat target;
+            if (::fstatat(dfd, n, &target, 0) == 0)
+            {
+                e.isDir = S_ISDIR(target.st_mode);
+                e.isFile = S_ISREG(target.st_mode);
+                e.size = e.isFile ? qint64(target.st_size) : 0;
+            }
+        }
+        else
+        {
+            e.isDir = S_ISDIR(st.st_mode);
+            e.isFile = S_ISREG(st.st_mode);
+            e.size = e.isFile ? qint64(st.st_size) : 0;
+        }
+
+        out->push_back(std::move(e));
+    }
+
+    ::closedir(dir);
+    return true;
+}
+
+#else
+
+bool enumerateDirectory(const QString& dirPath, QVector<NativeDirEntry>* out)
+{
+    out->clear();
+
+    const QDir dir(dirPath);
+    if (!dir.exists())
+        return false;
+
+    const QFileInfoList items = dir.entryInfoList(
+        QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+        QDir::NoSort
+    );
+
+    out->reserve(items.size());
+    for (const QFileInfo& it : items)
+    {
+        NativeDirEntry e;
+        e.name = it.fileName();
+        e.isSymLink = it.isSymLink();
+        e.isDir = it.isDir();
+        e.isFile = it.isFile();
+        e.size = e.isFile ? it.size() : 0;
+        e.mtimeMs = it.lastModified().toMSecsSinceEpoch();
+        out->push_back(std::move(e));
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file direnum.h
+ * @brief Быстрое перечисление содержимого одной папки средствами ОС.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+
+/**
+ * @brief Элемент папки, как его отдала ОС (без пути).
+ */
+struct NativeDirEntry
+{
+    QString name;
+    qint64 size = 0;         ///< Размер файла в байтах (для папок 0).
+    qint64 mtimeMs = 0;      ///< Время изменения (мс от эпохи UTC); у папок на POSIX — 0.
+    bool isDir = false;      ///< Папка (для ссылки — если ссылка ведёт на папку).
+    bool isFile = false;
+    bool isSymLink = false;  ///< Симлинк / reparse point.
+};
+
+
+/**
+ * @brief Прочитать содержимое папки (без "." и "..", скрытые и системные — включая).
+ * @details
+ *  - Windows: FindFirstFileExW(FindExInfoBasic, FIND_FIRST_EX_LARGE_FETCH) — размер,
+ *    атрибуты и признак reparse point приходят вместе с именем, без отдельных запросов
+ *    на каждый элемент (на SMB это главное).
+ *  - POSIX: readdir() (поверх getdents). Папки (d_type == DT_DIR) — без stat, mtimeMs = 0;
+ *    остальное (и DT_UNKNOWN) — fstatat() относительно дескриптора папки, для ссылок —
+ *    ещё один fstatat() по цели.
+ *  - Иначе: QDir::entryInfoList().
+ * @return false если папку не удалось открыть (out пуст).
+ */
+bool enumerateDirectory(const QString& dirPath, QVector<NativeDirEntry>* out);
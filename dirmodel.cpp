@@ -0,0 +1,348 @@
+/**
+ * @file dirmodel.cpp
+ * @brief Реализация модели каталога.
+ */
+
+#include "dirmodel.h"
+#include "direnum.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+/** \brief Папка параллельного обхода: её дети и узлы обходимых подпапок. */
+struct DirModel::ScanNode
+{
+    QString absPath;
+    QVector<DirEntry> children;                  ///< Уже отфильтрованы и отсортированы.
+    std::vector<std::unique_ptr<ScanNode>> sub;  ///< По индексу ребёнка; nullptr — не обходим.
+
+    ScanNode() = default;
+    ScanNode(const ScanNode&) = delete;
+    ScanNode& operator=(const ScanNode&) = delete;
+
+    /** \brief Поддерево освобождается без рекурсии: глубина каталога не упирается в стек. */
+    ~ScanNode()
+    {
+        std::vector<std::unique_ptr<ScanNode>> rest = std::move(sub);
+        while (!rest.empty())
+        {
+            std::unique_ptr<ScanNode> node = std::move(rest.back());
+            rest.pop_back();
+            for (std::unique_ptr<ScanNode>& s : node->sub)
+            {
+                if (s)
+                    rest.push_back(std::move(s));
+            }
+            node->sub.clear();   // удаляется узел без детей — деструктор не вкладывается
+        }
+    }
+};
+
+
+bool DirModel::build(const QString& rootPath, const SkipFilter& skip, const std::atomic_bool* cancel,
+                     std::atomic<qint64>* scanned, int threads)
+{
+    m_entries.clear();
+    m_skip = skip;
+    m_cancel = cancel;
+    m_scanned = scanned;
+
+    const QFileInfo rootInfo(rootPath);
+
+    DirEntry root;
+    root.name = rootInfo.fileName();
+    root.absPath = QDir::cleanPath(rootInfo.absoluteFilePath());
+    root.isDir = rootInfo.isDir();
+    root.isSymLink = rootInfo.isSymLink();
+    m_entries.push_back(std::move(root));
+
+    if (threads > 1)
+        scanParallel(threads);
+    else
+        scanSerial();
+
+    m_skip = nullptr;
+    m_cancel = nullptr;
+    m_scanned = nullptr;
+    return !(cancel && cancel->load(std::memory_order_relaxed));
+}
+
+int DirModel::placeChildren(int index, QVector<DirEntry>& children)
+{
+    const int first = m_entries.size();
+    const int count = children.size();
+
+    m_entries[index].firstChild = count > 0 ? first : -1;
+    m_entries[index].childCount = count;
+
+    for (DirEntry& c : children)
+    {
+        c.parent = index;
+        m_entries.push_back(std::move(c));
+    }
+    children.clear();
+    return first;
+}
+
+void DirModel::scanSerial()
+{
+    // Явный стек диапазонов детей вместо рекурсии: глубина каталога не упирается в стек потока.
+    // Порядок тот же, что у рекурсивного обхода: дети папки кладутся подряд при входе в неё.
+    struct Frame
+    {
+        int next;   ///< Следующий ребёнок для обхода.
+        int end;
+    };
+    std::vector<Frame> stack;
+
+    auto enter = [this, &stack](int index) {
+        QVector<DirEntry> children = listDir(m_entries.at(index).absPath);
+        const int count = children.size();
+        const int first = placeChildren(index, children);
+        if (m_scanned)
+            m_scanned->fetch_add(count, std::memory_order_relaxed);
+        stack.push_back({ first, first + count });
+    };
+
+    if (isCanceled())
+        return;
+    enter(0);
+
+    // Важно: ссылки на элементы вектора после enter() недействительны — работаем по индексам.
+    while (!stack.empty())
+    {
+        if (isCanceled())
+            return;
+
+        Frame& top = stack.back();
+        if (top.next == top.end)
+        {
+            stack.pop_back();
+            continue;
+        }
+        const int i = top.next++;
+
+        // Чтобы не словить циклы, в симлинки не уходим.
+        if (m_entries.at(i).isDir && !m_entries.at(i).isSymLink)
+            enter(i);
+    }
+}
+
+QVector<DirEntry> DirModel::listDir(const QString& path) const
+{
+    const QString prefix = path.endsWith(QLatin1Char('/')) ? path : path + QLatin1Char('/');
+
+    // Имя, тип, размер и mtime — одним перечислением, без QFileInfo и stat на каждый элемент.
+    QVector<NativeDirEntry> items;
+    enumerateDirectory(path, &items);
+
+    QVector<DirEntry> children;
+    children.reserve(items.size());
+
+    for (NativeDirEntry& it : items)
+    {
+        DirEntry e;
+        e.absPath = prefix + it.name;
+        e.name = std::move(it.name);
+        e.isSymLink = it.isSymLink;
+        e.isDir = it.isDir;
+        e.isFile = it.isFile;
+        e.size = it.size;
+        e.mtimeMs = it.mtimeMs;
+
+        if (m_skip && m_skip(e))
+            continue;
+
+        children.push_back(std::move(e));
+    }
+
+    // Сортировка как в дереве: папки первыми, затем по имени без учёта регистра.
+    // Регистр сворачивается один раз на элемент, а не в каждом сравнении.
+    struct SortKey
+    {
+        QString folded;
+        int index;
+        bool isDir;
+    };
+    std::vector<SortKey> keys;
+    keys.reserve(size_t(children.size()));
+    for (int i = 0; i < children.size(); ++i)
+        keys.push_back({ children.at(i).name.toCaseFolded(), i, children.at(i).isDir });
+
+    std::sort(keys.begin(), keys.end(), [](const SortKey& a, const SortKey& b){
+        if (a.isDir != b.isDir)
+            return a.isDir > b.isDir;
+        if (a.folded != b.folded)
+            return a.folded < b.folded;
+        return a.index < b.index;
+    });
+
+    QVector<DirEntry> sorted;
+    sorted.reserve(children.size());
+    for (const SortKey& k : keys)
+        sorted.push_back(std::move(children[k.index]));
+    return sorted;
+}
+
+void DirModel::scanParallel(int threads)
+{
+    ScanNode root;
+    root.absPath = m_entries.at(0).absPath;
+
+    struct WorkQueue
+    {
+        QMutex mutex;
+        std::deque<ScanNode*> tasks;
+    };
+    std::vector<WorkQueue> queues(threads);
+
+    std::atomic<qint64> outstanding { 1 };   // папок поставлено, но ещё не прочитано
+    QMutex idleMutex;
+    QWaitCondition idle;
+
+    queues[0].tasks.push_back(&root);
+
+    auto take = [&](int self) -> ScanNode* {
+        {
+            WorkQueue& own = queues[self];
+            QMutexLocker lock(&own.mutex);
+            if (!own.tasks.empty())
+            {
+                ScanNode* n = own.tasks.back();
+                own.tasks.pop_back();
+                return n;
+            }
+        }
+        for (int k = 1; k < threads; ++k)
+        {
+            WorkQueue& victim = queues[(self + k) % threads];
+            QMutexLocker lock(&victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                ScanNode* n = victim.tasks.front();
+                victim.tasks.pop_front();
+                return n;
+            }
+        }
+        return nullptr;
+    };
+
+    auto worker = [&](int self) {
+        std::vector<ScanNode*> found;
+        for (;;)
+        {
+            if (isCanceled())
+                return;
+
+            ScanNode* node = take(self);
+            if (!node)
+            {
+                if (outstanding.load() == 0)
+                    return;
+                // Короткий таймаут: пропущенное пробуждение стоит не больше миллисекунды.
+                QMutexLocker lock(&idleMutex);
+                if (outstanding.load() == 0)
+                    return;
+                idle.wait(&idleMutex, 1);
+                continue;
+            }
+
+            node->children = listDir(node->absPath);
+            const int count = node->children.size();
+            if (m_scanned)
+                m_scanned->fetch_add(count, std::memory_order_relaxed);
+
+            node->sub.resize(count);
+            found.clear();
+            for (int i = 0; i < count; ++i)
+            {
+                // Чтобы не словить циклы, в симлинки не уходим.
+                const DirEntry& c = node->children.at(i);
+                if (!c.isDir || c.isSymLink)
+                    continue;
+                node->sub[i].reset(new ScanNode);
+                node->sub[i]->absPath = c.absPath;
+                found.push_back(node->sub[i].get());
+            }
+
+            if (!found.empty())
+            {
+                outstanding.fetch_add(qint64(found.size()));
+                {
+                    // В обратном порядке: первая подпапка окажется в конце деки и будет взята первой.
+                    WorkQueue& own = queues[self];
+                    QMutexLocker lock(&own.mutex);
+                    own.tasks.insert(own.tasks.end(), found.rbegin(), found.rend());
+                }
+                idle.wakeAll();
+            }
+
+            if (outstanding.fetch_sub(1) == 1)
+                idle.wakeAll();
+        }
+    };
+
+    // Один из обходчиков — текущий поток.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads - 1);
+    QVector<QFuture<void>> helpers;
+    for (int i = 1; i < threads; ++i)
+        helpers.push_back(QtConcurrent::run(&pool, [&worker, i]() { worker(i); }));
+
+    worker(0);
+    for (QFuture<void>& f : helpers)
+        f.waitForFinished();
+
+    if (isCanceled())
+        return;
+
+    assemble(root);
+}
+
+void DirModel::assemble(ScanNode& root)
+{
+    // Тот же порядок, что у scanSerial(), и тоже без рекурсии.
+    struct Frame
+    {
+        ScanNode* node;
+        int first;   ///< Индекс первого ребёнка узла в m_entries.
+        int next;    ///< Следующий ребёнок для обхода.
+    };
+    std::vector<Frame> stack;
+
+    auto enter = [this, &stack](int index, ScanNode& node) {
+        stack.push_back({ &node, placeChildren(index, node.children), 0 });
+    };
+    enter(0, root);
+
+    while (!stack.empty())
+    {
+        Frame& top = stack.back();
+        if (top.next == int(top.node->sub.size()))
+        {
+            top.node->sub.clear();   // поддеревья уже разложены и пусты
+            stack.pop_back();
+            continue;
+        }
+        const int i = top.next++;
+        if (ScanNode* child = top.node->sub[size_t(i)].get())
+            enter(top.first + i, *child);
+    }
+}
+
+bool DirModel::isCanceled() const
+{
+    return (m_cancel && m_cancel->load(std::memory_order_relaxed));
+}
@@ -0,0 +1,100 @@
+/**
+ * @file dirmodel.h
+ * @brief Модель каталога в памяти: один обход диска для дерева и для секции содержимого.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+
+/**
+ * @brief Элемент модели каталога (файл или папка).
+ * @details Все метаданные снимаются один раз при обходе, дальше генератор
+ *          работает только с этой структурой и повторно диск не опрашивает.
+ */
+struct DirEntry
+{
+    QString name;            ///< Имя файла/папки (без пути).
+    QString absPath;         ///< Абсолютный путь.
+    qint64 size = 0;         ///< Размер файла в байтах (для папок 0).
+    qint64 mtimeMs = 0;      ///< Время изменения (мс от эпохи UTC); для папок может быть 0.
+    int parent = -1;         ///< Индекс родителя в DirModel (для корня -1).
+    int firstChild = -1;     ///< Индекс первого ребёнка (дети лежат подряд).
+    int childCount = 0;      ///< Количество детей.
+    bool isDir = false;
+    bool isFile = false;
+    bool isSymLink = false;  ///< Симлинк / reparse point (внутрь не заходим).
+};
+
+
+/**
+ * @brief Плоская модель каталога: все элементы в одном векторе, корень — индекс 0.
+ * @details Дети каждой папки лежат подряд и уже отсортированы так, как их выводит дерево:
+ *          папки первыми, затем по имени без учёта регистра.
+ */
+class DirModel
+{
+public:
+    /** \brief Фильтр элементов: true — элемент пропускается (и в папку не заходим).
+     *  \note При threads > 1 вызывается из нескольких потоков одновременно.
+     */
+    using SkipFilter = std::function<bool(const DirEntry&)>;
+
+    /**
+     * @brief Обойти каталог и построить модель.
+     * @param rootPath Корневой каталог.
+     * @param skip Фильтр исключений (может быть пустым).
+     * @param cancel Флаг отмены (может быть nullptr).
+     * @param scanned Счётчик найденных элементов для прогресса (может быть nullptr).
+     * @param threads Сколько папок читать одновременно (1 = последовательно).
+     *        Параллельный обход даёт ту же модель, что и последовательный.
+     * @return false если обход прерван отменой.
+     */
+    bool build(const QString& rootPath, const SkipFilter& skip, const std::atomic_bool* cancel,
+               std::atomic<qint64>* scanned = nullptr, int threads = 1);
+
+    void clear() { m_entries.clear(); }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int size() const { return m_entries.size(); }
+
+    const DirEntry& at(int index) const { return m_entries.at(index); }
+    const QVector<DirEntry>& entries() const { return m_entries; }
+
+private:
+    QVector<DirEntry> m_entries;
+    SkipFilter m_skip;
+    const std::atomic_bool* m_cancel = nullptr;
+    std::atomic<qint64>* m_scanned = nullptr;
+
+    struct ScanNode;
+
+    /**
+     * @brief Последовательный обход от корня (индекс 0) в глубину.
+     * @details Явный стек вместо рекурсии: глубина каталога не ограничена стеком потока.
+     */
+    void scanSerial();
+
+    /** \brief Положить детей папки index подряд в конец m_entries; вернуть индекс первого. */
+    int placeChildren(int index, QVector<DirEntry>& children);
+
+    /** \brief Дети папки: перечислить, отфильтровать, отсортировать как в дереве. */
+    QVector<DirEntry> listDir(const QString& path) const;
+
+    /**
+     * @brief Параллельный обход: потоки с собственными деками задач и кражей работы.
+     * @details Каждый поток берёт свои задачи с конца деки (глубже — теплее кэш),
+     *          а когда его дека пуста — крадёт с начала чужой (там папки повыше,
+     *          в которых больше работы). Результат — дерево узлов, которое затем
+     *          раскладывается в m_entries тем же порядком, что и scanSerial().
+     */
+    void scanParallel(int threads);
+
+    /** \brief Разложить готовое дерево узлов в m_entries (как scanSerial(), без рекурсии). */
+    void assemble(ScanNode& root);
+
+    bool isCanceled() const;
+};
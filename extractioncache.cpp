@@ -0,0 +1,280 @@
+/**
+ * @file extractioncache.cpp
+ * @brief Реализация кэша извлечённого текста.
+ */
+
+#include "extractioncache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <limits>
+
+
+namespace {
+
+constexpr quint32 kMagic = 0x434D5843;       // "CMXC"
+constexpr quint32 kFormatVersion = 1;
+
+/** \brief Слишком большой текст не кэшируем (файл кэша должен оставаться разумным). */
+constexpr int kMaxTextBytes = 64 * 1024 * 1024;
+
+} // namespace
+
+
+ExtractionCache::ExtractionCache(const QString& cacheFilePath)
+    : m_path(cacheFilePath)
+{
+}
+
+ExtractionCache::~ExtractionCache()
+{
+    QMutexLocker lock(&m_mutex);
+
+    // Без commit() новый файл отбрасывается (QSaveFile сам удалит временный файл).
+    m_stream.setDevice(nullptr);
+    if (m_out)
+        m_out->cancelWriting();
+    m_out.reset();
+
+    closeOldLocked();
+}
+
+QString ExtractionCache::fileForRoot(const QString& rootAbs, const QString& cacheDir)
+{
+    QString dir = cacheDir;
+    if (dir.isEmpty())
+    {
+        QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (base.isEmpty())
+            base = QDir::tempPath();
+        dir = QDir(base).filePath(QStringLiteral("extract-cache"));
+    }
+
+    QString key = QDir::cleanPath(rootAbs);
+#ifdef Q_OS_WIN
+    key = key.toLower(); // пути в Windows без учёта регистра
+#endif
+
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(dir).filePath(QString::fromLatin1(hash) + QStringLiteral(".cache"));
+}
+
+void ExtractionCache::open()
+{
+    QMutexLocker lock(&m_mutex);
+
+    closeOldLocked();
+
+    m_oldFile.setFileName(m_path);
+    if (!m_oldFile.exists() || !m_oldFile.open(QIODevice::ReadOnly))
+        return;
+
+    m_mapSize = m_oldFile.size();
+    if (m_mapSize <= 0 || m_mapSize > std::numeric_limits<int>::max())
+    {
+        closeOldLocked();
+        return;
+    }
+
+    m_map = m_oldFile.map(0, m_mapSize);
+    if (!m_map)
+    {
+        closeOldLocked();
+        return;
+    }
+
+    // Читаем только индекс: текст пропускаем, запоминая смещение.
+    const QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char*>(m_map), (int)m_mapSize);
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kFormatVersion)
+    {
+        closeOldLocked();
+        return;
+    }
+
+    while (!in.atEnd())
+    {
+        QString path;
+        Record r;
+        quint32 len = 0;
+        in >> path >> r.size >> r.mtimeMs >> r.extractor >> r.param >> len;
+        if (in.status() != QDataStream::Ok)
+            break;
+
+        r.textOffset = in.device()->pos();
+        r.textLen = len;
+        if (r.textOffset + (qint64)len > m_mapSize)
+            break; // обрезанный хвост (например, прерванная запись) — игнорируем
+
+        if (in.skipRawData((int)len) != (int)len)
+            break;
+
+        m_index.insert(path, r);
+    }
+}
+
+bool ExtractionCache::lookup(const Key& key, QString* textOut)
+{
+    const char* text = nullptr;
+    quint32 len = 0;
+
+    {
+        QMutexLocker lock(&m_mutex);
+
+        const auto it = m_index.constFind(key.absPath);
+        if (it == m_index.constEnd()
+            || it->size != key.size
+            || it->mtimeMs != key.mtimeMs
+            || it->extractor != key.extractor
+            || it->param != key.param)
+        {
+            ++m_misses;
+            return false;
+        }
+
+        text = reinterpret_cast<const char*>(m_map + it->textOffset);
+        len = it->textLen;
+
+        // Совпавшая запись переезжает в новый файл как есть, без перекодирования.
+        if (!m_written.contains(key.absPath) && ensureOutLocked())
+            writeRecordLocked(key.absPath, it->size, it->mtimeMs, it->extractor, it->param, text, len);
+
+        ++m_hits;
+    }
+
+    // Отображение живёт до commit(), который вызывается после завершения всех рабочих потоков.
+    if (textOut)
+        *textOut = QString::fromUtf8(text, (int)len);
+    return true;
+}
+
+void ExtractionCache::store(const Key& key, const QString& text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    if (utf8.size() > kMaxTextBytes)
+        return;
+
+    QMutexLocker lock(&m_mutex);
+
+    if (m_written.contains(key.absPath) || !ensureOutLocked())
+        return;
+
+    writeRecordLocked(key.absPath, key.size, key.mtimeMs, key.extractor, key.param,
+                      utf8.constData(), (quint32)utf8.size());
+}
+
+bool ExtractionCache::commit(bool complete, QString* errorOut)
+{
+    QMutexLocker lock(&m_mutex);
+
+    // Ни одного обращения к кэшу — старый файл остаётся как есть.
+    if (!m_out && !m_outFailed)
+    {
+        closeOldLocked();
+        return true;
+    }
+
+    // Прогон прерван: переносим записи, до которых не дошли, чтобы не потерять их.
+    if (!complete && m_out)
+    {
+        for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it)
+        {
+            if (m_written.contains(it.key()))
+                continue;
+
+            const Record& r = it.value();
+            writeRecordLocked(it.key(), r.size, r.mtimeMs, r.extractor, r.param,
+                              reinterpret_cast<const char*>(m_map + r.textOffset), r.textLen);
+        }
+    }
+
+    // В Windows нельзя заменить файл, пока он открыт/отображён.
+    closeOldLocked();
+
+    bool ok = false;
+    if (m_out)
+    {
+        const bool streamOk = !m_outFailed && m_stream.status() == QDataStream::Ok;
+        m_stream.setDevice(nullptr);
+
+        if (streamOk)
+        {
+            ok = m_out->commit();
+            if (!ok && errorOut)
+                *errorOut = QStringLiteral("Не удалось записать кэш: %1").arg(m_out->errorString());
+        }
+        else
+        {
+            m_out->cancelWriting();
+            if (errorOut)
+                *errorOut = QStringLiteral("Ошибка записи кэша: %1").arg(m_out->errorString());
+        }
+        m_out.reset();
+    }
+    else if (errorOut)
+    {
+        *errorOut = QStringLiteral("Не удалось создать файл кэша: %1").arg(m_path);
+    }
+
+    m_written.clear();
+    return ok;
+}
+
+bool ExtractionCache::ensureOutLocked()
+{
+    if (m_out)
+        return !m_outFailed;
+    if (m_outFailed)
+        return false;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    m_out.reset(new QSaveFile(m_path));
+    if (!m_out->open(QIODevice::WriteOnly))
+    {
+        m_out.reset();
+        m_outFailed = true;
+        return false;
+    }
+
+    m_stream.setDevice(m_out.get());
+    m_stream.setVersion(QDataStream::Qt_5_12);
+    m_stream << kMagic << kFormatVersion;
+    return true;
+}
+
+void ExtractionCache::writeRecordLocked(const QString& path, qint64 size, qint64 mtimeMs,
+                                        const QString& extractor, qint64 param,
+                                        const char* text, quint32 len)
+{
+    if (m_outFailed || !m_out)
+        return;
+
+    m_stream << path << size << mtimeMs << extractor << param << len;
+    if (len > 0 && m_stream.writeRawData(text, (int)len) != (int)len)
+        m_outFailed = true;
+    if (m_stream.status() != QDataStream::Ok)
+        m_outFailed = true;
+
+    m_written.insert(path, true);
+}
+
+void ExtractionCache::closeOldLocked()
+{
+    if (m_map)
+        m_oldFile.unmap(const_cast<uchar*>(m_map));
+    m_map = nullptr;
+    m_mapSize = 0;
+
+    if (m_oldFile.isOpen())
+        m_oldFile.close();
+
+    m_index.clear();
+}
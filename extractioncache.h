@@ -0,0 +1,112 @@
+/**
+ * @file extractioncache.h
+ * @brief Кэш извлечённого текста документов (PDF/DOCX/XLSX) на диске.
+ */
+
+#pragma once
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QSaveFile>
+#include <memory>
+
+
+/**
+ * @brief Кэш текста, извлечённого из документов, — один файл на корневой каталог.
+ * @details
+ *  Ключ записи: абсолютный путь + размер + mtime + версия экстрактора (+ параметр экстрактора).
+ *  Старый файл кэша отображается в память (QFile::map), при открытии читается только индекс,
+ *  текст декодируется лишь при попадании.
+ *
+ *  Новый файл пишется по ходу генерации (QSaveFile): в него сразу попадают совпавшие
+ *  записи и свежеизвлечённый текст, поэтому память не растёт с числом документов.
+ *  commit() атомарно заменяет старый файл новым.
+ *
+ *  Потокобезопасен: lookup()/store() можно вызывать из рабочих потоков.
+ */
+class ExtractionCache
+{
+public:
+    /** \brief Ключ записи кэша. */
+    struct Key
+    {
+        QString absPath;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        QString extractor;   ///< Имя и версия экстрактора, например "pdf/1".
+        qint64 param = 0;    ///< Параметр, влияющий на результат (например, лимит для XLSX).
+    };
+
+    explicit ExtractionCache(const QString& cacheFilePath);
+    ~ExtractionCache();
+
+    ExtractionCache(const ExtractionCache&) = delete;
+    ExtractionCache& operator=(const ExtractionCache&) = delete;
+
+    /**
+     * @brief Путь файла кэша для корневого каталога.
+     * @param rootAbs Абсолютный путь корня.
+     * @param cacheDir Папка кэша; пусто = QStandardPaths::CacheLocation/extract-cache.
+     */
+    static QString fileForRoot(const QString& rootAbs, const QString& cacheDir = QString());
+
+    /**
+     * @brief Открыть кэш: прочитать индекс существующего файла (если он есть).
+     * @details Отсутствующий или повреждённый файл — не ошибка, кэш просто пустой.
+     */
+    void open();
+
+    /**
+     * @brief Найти текст по ключу.
+     * @return true если запись есть и совпадает по размеру, mtime и экстрактору.
+     */
+    bool lookup(const Key& key, QString* textOut);
+
+    /** \brief Сохранить извлечённый текст (до обрезки по лимиту вывода). */
+    void store(const Key& key, const QString& text);
+
+    /**
+     * @brief Записать новый файл кэша вместо старого.
+     * @param complete true — прогон прошёл по всем файлам: записи, которые не понадобились,
+     *                 удаляются; false (отмена) — они переносятся как есть.
+     */
+    bool commit(bool complete, QString* errorOut = nullptr);
+
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+
+private:
+    struct Record
+    {
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        QString extractor;
+        qint64 param = 0;
+        qint64 textOffset = 0;   ///< Смещение UTF-8 текста в отображённом файле.
+        quint32 textLen = 0;
+    };
+
+    QString m_path;
+    QFile m_oldFile;
+    const uchar* m_map = nullptr;
+    qint64 m_mapSize = 0;
+    QHash<QString, Record> m_index;     ///< Записи старого файла (ключ — путь).
+    QHash<QString, bool> m_written;     ///< Пути, уже записанные в новый файл.
+
+    std::unique_ptr<QSaveFile> m_out;
+    QDataStream m_stream;
+    bool m_outFailed = false;
+
+    QMutex m_mutex;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+
+    bool ensureOutLocked();
+    void writeRecordLocked(const QString& path, qint64 size, qint64 mtimeMs,
+                           const QString& extractor, qint64 param,
+                           const char* text, quint32 len);
+    void closeOldLocked();
+};
@@ -0,0 +1,437 @@
+/**
+ * @file jobpreset.cpp
+ * @brief Реализация чтения и записи пресетов заданий.
+ */
+
+#include "jobpreset.h"
+#include "optionparse.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+using Options = ReportGenerator::Options;
+
+/** \brief Разбор полей одного задания; ошибка — с именем поля. */
+class JobReader
+{
+public:
+    JobReader(const QJsonObject& obj, QString* errorOut) : m_obj(obj), m_error(errorOut) {}
+
+    bool ok() const { return m_ok; }
+
+    bool has(const char* key) const { return m_obj.contains(QLatin1String(key)); }
+
+    void readString(const char* key, QString* out)
+    {
+        if (!has(key))
+            return;
+        const QJsonValue v = m_obj.value(QLatin1String(key));
+        if (!v.isString())
+            return fail(key, QStringLiteral("ожидается строка"));
+        *out = v.toString();
+    }
+
+    void readStrings(const char* key, QStringList* out)
+    {
+        if (!has(key))
+            return;
+        const QJsonValue v = m_obj.value(QLatin1String(key));
+        QStringList list;
+        if (v.isString())
+        {
+            list << v.toString();
+        }
+        else if (v.isArray())
+        {
+            for (const QJsonValue& item : v.toArray())
+            {
+                if (!item.isString())
+                    return fail(key, QStringLiteral("ожидается массив строк"));
+                list << item.toString();
+            }
+        }
+        else
+        {
+            return fail(key, QStringLiteral("ожидается массив строк"));
+        }
+        *out = list;
+    }
+
+    void readBool(const char* key, bool* out)
+    {
+        if (!has(key))
+            return;
+        const QJsonValue v = m_obj.value(QLatin1String(key));
+        if (!v.isBool())
+            return fail(key, QStringLiteral("ожидается true или false"));
+        *out = v.toBool();
+    }
+
+    void readInt(const char* key, int* out)
+    {
+        if (!has(key))
+            return;
+        const QJsonValue v = m_obj.value(QLatin1String(key));
+        const double d = v.toDouble(-1);
+        if (!v.isDouble() || d < 0 || d > 1e9 || d != double(int(d)))
+            return fail(key, QStringLiteral("ожидается целое число >= 0"));
+        *out = int(d);
+    }
+
+    /** \brief Размер: "1MB" или число байт; allowZero — 0 означает "без лимита". */
+    void readSize(const char* key, bool allowZero, qint64* out)
+    {
+        if (!has(key))
+            return;
+        const QJsonValue v = m_obj.value(QLatin1String(key));
+        QString text;
+        if (v.isDouble())
+            text = QString::number(qint64(v.toDouble()));
+        else if (v.isString())
+            text = v.toString();
+        else
+            return fail(key, QStringLiteral("ожидается размер (\"1MB\" или число)"));
+
+        QString err;
+        const bool parsed = allowZero ? parseHumanSizeToBytesAllowZero(text, out, &err)
+                                      : parseHumanSizeToBytes(text, out, &err);
+        if (!parsed)
+            fail(key, err);
+    }
+
+    /** \brief Строковое значение из перечня: индекс в names или -1, если поля нет. */
+    int readChoice(const char* key, const QStringList& names)
+    {
+        if (!has(key))
+            return -1;
+        const int i = names.indexOf(m_obj.value(QLatin1String(key)).toString().trimmed().toLower());
+        if (i < 0)
+            fail(key, QStringLiteral("ожидается одно из: %1").arg(names.join(QStringLiteral(", "))));
+        return i;
+    }
+
+private:
+    const QJsonObject& m_obj;
+    QString* m_error;
+    bool m_ok = true;
+
+    void fail(const char* key, const QString& text)
+    {
+        if (m_ok && m_error)
+            *m_error = QStringLiteral("поле \"%1\": %2").arg(QLatin1String(key), text);
+        m_ok = false;
+    }
+};
+
+QString resolvePath(const QDir& base, const QString& path)
+{
+    return path.isEmpty() ? path : QDir::cleanPath(base.absoluteFilePath(path));
+}
+
+/** \brief Размер для записи: точное число в самых крупных целых единицах ("1MB", "512KB"). */
+QString exactSize(qint64 bytes)
+{
+    static const char* const kUnits[] = { "TB", "GB", "MB", "KB" };
+    for (int i = 0; i < 4; ++i)
+    {
+        const qint64 unit = qint64(1) << (10 * (4 - i));
+        if (bytes > 0 && bytes % unit == 0)
+            return QString::number(bytes / unit) + QLatin1String(kUnits[i]);
+    }
+    return QString::number(bytes);
+}
+
+const QStringList& treeStyleNames()
+{
+    static const QStringList names { QStringLiteral("unicode"), QStringLiteral("ascii") };
+    return names;
+}
+
+const QStringList& encodingNames()
+{
+    static const QStringList names { QStringLiteral("auto"), QStringLiteral("ansi") };
+    return names;
+}
+
+const QStringList& budgetOrderNames()
+{
+    static const QStringList names { QStringLiteral("path"), QStringLiteral("small"), QStringLiteral("new") };
+    return names;
+}
+
+bool readJob(const QJsonObject& obj, const QDir& base, const Options& defaults, JobPreset* job, QString* errorOut)
+{
+    JobReader r(obj, errorOut);
+    Options& opt = job->options;
+    opt = defaults;
+
+    r.readString("name", &job->name);
+    r.readStrings("roots", &job->roots);
+    r.readString("out", &job->outPath);
+    r.readString("outDir", &job->outDir);
+
+    QStringList list;
+    if (r.has("includeExt"))
+    {
+        r.readStrings("includeExt", &list);
+        opt.includeExt = parseUserList(list.join(QLatin1Char(',')), true, true);
+    }
+    if (r.has("excludeDirs"))
+    {
+        r.readStrings("excludeDirs", &list);
+        opt.excludeDirNames = parseUserList(list.join(QLatin1Char(',')), false, true);
+    }
+
+    r.readSize("maxBytes", false, &opt.maxBytes);
+    r.readSize("maxOutChars", true, &opt.maxOutChars);
+    r.readSize("budget", true, &opt.reportBudgetChars);
+
+    r.readBool("treeOnly", &opt.treeOnly);
+    r.readInt("treeDepth", &opt.treeMaxDepth);
+    r.readInt("treeMaxEntries", &opt.treeMaxEntriesPerDir);
+    r.readBool("treeIncludedOnly", &opt.treeOnlyIncludedDirs);
+    r.readBool("anyText", &opt.includeAnyText);
+    r.readBool("dedup", &opt.dedupContent);
+    r.readInt("pdfMaxPages", &opt.pdfMaxPages);
+    r.readInt("pdfTimeoutMs", &opt.pdfTimeoutMs);
+    r.readBool("cmdTree", &opt.useCmdTree);
+    r.readInt("cmdTreeTimeoutMs", &opt.cmdTreeTimeoutMs);
+    r.readStrings("priority", &opt.priorityRules);
+
+    const int style = r.readChoice("treeStyle", treeStyleNames());
+    if (style >= 0)
+        opt.treeStyle = Options::TreeStyle(style);
+    const int encoding = r.readChoice("encoding", encodingNames());
+    if (encoding >= 0)
+        opt.noBomEncodingMode = encoding == 1 ? Options::NoBomEncodingMode::ForceAnsi
+                                              : Options::NoBomEncodingMode::AutoUtf8ThenAnsi;
+    const int order = r.readChoice("budgetOrder", budgetOrderNames());
+    if (order >= 0)
+        opt.budgetOrder = Options::BudgetOrder(order);
+
+    if (!r.ok())
+        return false;
+
+    // Как --priority в CLI: маска=вес, вес — целое число.
+    for (const QString& rule : std::as_const(opt.priorityRules))
+    {
+        const int eq = rule.lastIndexOf(QLatin1Char('='));
+        bool weightOk = false;
+        if (eq > 0)
+            rule.mid(eq + 1).trimmed().toInt(&weightOk);
+        if (!weightOk)
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("поле \"priority\": ожидается маска=вес, получено \"%1\"").arg(rule);
+            return false;
+        }
+    }
+
+    if (job->roots.isEmpty())
+    {
+        if (errorOut) *errorOut = QStringLiteral("не задан ни один каталог (roots)");
+        return false;
+    }
+    if (!job->outPath.isEmpty() && job->roots.size() > 1)
+    {
+        if (errorOut) *errorOut = QStringLiteral("out задаёт один файл; для нескольких каталогов используйте outDir");
+        return false;
+    }
+
+    for (QString& root : job->roots)
+        root = resolvePath(base, root);
+    job->outPath = resolvePath(base, job->outPath);
+    job->outDir = resolvePath(base, job->outDir);
+    return true;
+}
+
+QJsonObject writeJob(const JobPreset& job)
+{
+    const Options& opt = job.options;
+
+    QJsonObject obj;
+    if (!job.name.isEmpty())
+        obj.insert(QStringLiteral("name"), job.name);
+    obj.insert(QStringLiteral("roots"), QJsonArray::fromStringList(job.roots));
+    if (!job.outPath.isEmpty())
+        obj.insert(QStringLiteral("out"), job.outPath);
+    if (!job.outDir.isEmpty())
+        obj.insert(QStringLiteral("outDir"), job.outDir);
+
+    obj.insert(QStringLiteral("includeExt"), QJsonArray::fromStringList(opt.includeExt));
+    obj.insert(QStringLiteral("excludeDirs"), QJsonArray::fromStringList(opt.excludeDirNames));
+    obj.insert(QStringLiteral("maxBytes"), exactSize(opt.maxBytes));
+    obj.insert(QStringLiteral("maxOutChars"), exactSize(opt.maxOutChars));
+    obj.insert(QStringLiteral("budget"), exactSize(opt.reportBudgetChars));
+    obj.insert(QStringLiteral("budgetOrder"), budgetOrderNames().at(int(opt.budgetOrder)));
+    obj.insert(QStringLiteral("priority"), QJsonArray::fromStringList(opt.priorityRules));
+    obj.insert(QStringLiteral("treeOnly"), opt.treeOnly);
+    obj.insert(QStringLiteral("treeStyle"), treeStyleNames().at(int(opt.treeStyle)));
+    obj.insert(QStringLiteral("treeDepth"), opt.treeMaxDepth);
+    obj.insert(QStringLiteral("treeMaxEntries"), opt.treeMaxEntriesPerDir);
+    obj.insert(QStringLiteral("treeIncludedOnly"), opt.treeOnlyIncludedDirs);
+    obj.insert(QStringLiteral("encoding"),
+               encodingNames().at(opt.noBomEncodingMode == Options::NoBomEncodingMode::ForceAnsi ? 1 : 0));
+    obj.insert(QStringLiteral("anyText"), opt.includeAnyText);
+    obj.insert(QStringLiteral("dedup"), opt.dedupContent);
+    obj.insert(QStringLiteral("pdfMaxPages"), opt.pdfMaxPages);
+    obj.insert(QStringLiteral("pdfTimeoutMs"), opt.pdfTimeoutMs);
+    obj.insert(QStringLiteral("cmdTree"), opt.useCmdTree);
+    obj.insert(QStringLiteral("cmdTreeTimeoutMs"), opt.cmdTreeTimeoutMs);
+    return obj;
+}
+
+/** \brief Имя задания из файла: поле name, иначе имя папки первого корня (как в loadJobPresets()). */
+QString jobName(const QJsonObject& obj)
+{
+    const QString name = obj.value(QStringLiteral("name")).toString();
+    if (!name.isEmpty())
+        return name;
+    const QJsonValue roots = obj.value(QStringLiteral("roots"));
+    const QString first = roots.isArray() ? roots.toArray().at(0).toString() : roots.toString();
+    return QFileInfo(QDir::cleanPath(first)).fileName();
+}
+
+bool writePresetFile(const QString& path, const QJsonArray& jobs, QString* errorOut)
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), kFormatVersion);
+    root.insert(QStringLiteral("jobs"), jobs);
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось записать пресеты %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+bool loadJobPresets(const QString& path, const ReportGenerator::Options& defaults,
+                    QVector<JobPreset>* presetsOut, QString* errorOut)
+{
+    presetsOut->clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось открыть %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseErr;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseErr);
+    if (!doc.isObject())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("%1: неверный JSON (%2, смещение %3)")
+                            .arg(path, parseErr.errorString())
+                            .arg(parseErr.offset);
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    const int version = root.value(QStringLiteral("version")).toInt(kFormatVersion);
+    if (version > kFormatVersion)
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("%1: версия формата %2 не поддерживается").arg(path).arg(version);
+        return false;
+    }
+
+    const QJsonArray jobs = root.value(QStringLiteral("jobs")).toArray();
+    if (jobs.isEmpty())
+    {
+        if (errorOut) *errorOut = QStringLiteral("%1: нет ни одного задания (jobs)").arg(path);
+        return false;
+    }
+
+    const QDir base = QFileInfo(path).absoluteDir();
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        JobPreset job;
+        QString err;
+        if (!jobs.at(i).isObject() || !readJob(jobs.at(i).toObject(), base, defaults, &job, &err))
+        {
+            if (err.isEmpty())
+                err = QStringLiteral("ожидается объект");
+            if (errorOut)
+                *errorOut = QStringLiteral("%1: задание %2: %3").arg(path).arg(i + 1).arg(err);
+            return false;
+        }
+        if (job.name.isEmpty())
+            job.name = QFileInfo(job.roots.first()).fileName();
+        presetsOut->push_back(job);
+    }
+    return true;
+}
+
+bool saveJobPresets(const QString& path, const QVector<JobPreset>& presets, QString* errorOut)
+{
+    QJsonArray jobs;
+    for (const JobPreset& job : presets)
+        jobs.push_back(writeJob(job));
+    return writePresetFile(path, jobs, errorOut);
+}
+
+bool saveJobPreset(const QString& path, const JobPreset& preset, QString* errorOut)
+{
+    QJsonArray jobs;
+    QFile file(path);
+    if (file.exists())
+    {
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            if (errorOut) *errorOut = QStringLiteral("Не удалось открыть %1: %2").arg(path, file.errorString());
+            return false;
+        }
+
+        // Чужой или испорченный файл не перезаписываем.
+        QJsonParseError parseErr;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseErr);
+        if (!doc.isObject())
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("%1: неверный JSON (%2, смещение %3)")
+                                .arg(path, parseErr.errorString())
+                                .arg(parseErr.offset);
+            return false;
+        }
+        const int version = doc.object().value(QStringLiteral("version")).toInt(kFormatVersion);
+        if (version > kFormatVersion)
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("%1: версия формата %2 не поддерживается").arg(path).arg(version);
+            return false;
+        }
+        jobs = doc.object().value(QStringLiteral("jobs")).toArray();
+    }
+
+    // Остальные задания остаются как были: с относительными путями и без лишних полей.
+    const QJsonObject written = writeJob(preset);
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        if (jobName(jobs.at(i).toObject()) == preset.name)
+        {
+            jobs.replace(i, written);
+            return writePresetFile(path, jobs, errorOut);
+        }
+    }
+    jobs.push_back(written);
+    return writePresetFile(path, jobs, errorOut);
+}
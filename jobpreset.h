@@ -0,0 +1,57 @@
+/**
+ * @file jobpreset.h
+ * @brief Пресеты заданий: корни, вывод и параметры генератора в JSON-файле.
+ */
+
+#pragma once
+
+#include "reportgenerator.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * @brief Одно сохранённое задание: какие каталоги, куда писать и с какими параметрами.
+ * @details
+ *  Файл пресетов — JSON вида { "version": 1, "jobs": [ {...}, ... ] }. Поля задания:
+ *   - name, roots (массив путей), out (файл, для одного корня) или outDir (папка);
+ *   - includeExt, excludeDirs (массивы строк);
+ *   - maxBytes, maxOutChars, budget — размер строкой ("1MB") или числом;
+ *   - treeOnly, treeStyle (unicode|ascii), treeDepth, treeMaxEntries, treeIncludedOnly;
+ *   - encoding (auto|ansi), anyText, dedup, pdfMaxPages, budgetOrder (path|small|new);
+ *   - priority — массив правил "маска=вес", как --priority;
+ *   - pdfTimeoutMs, cmdTree, cmdTreeTimeoutMs (таймауты в мс, 0 = без ограничения).
+ *  Отсутствующее поле берётся из умолчаний вызывающего (например, из параметров командной
+ *  строки). Относительные пути отсчитываются от папки файла пресетов.
+ */
+struct JobPreset
+{
+    QString name;
+    QStringList roots;
+    QString outPath;    ///< Файл отчёта (только для одного корня).
+    QString outDir;     ///< Папка отчётов: <имя корня>.md на каждый корень.
+    ReportGenerator::Options options;   ///< Параметры генератора; rootPath не используется.
+};
+
+/**
+ * @brief Прочитать задания из файла пресетов.
+ * @param defaults Значения параметров, не заданных в задании.
+ * @param errorOut (опционально) сообщение об ошибке: файл, задание и поле.
+ */
+bool loadJobPresets(const QString& path, const ReportGenerator::Options& defaults,
+                    QVector<JobPreset>* presetsOut, QString* errorOut = nullptr);
+
+/**
+ * @brief Записать задания в файл пресетов (через QSaveFile).
+ * @details Пишутся все поля из списка выше, пути — как заданы.
+ */
+bool saveJobPresets(const QString& path, const QVector<JobPreset>& presets, QString* errorOut = nullptr);
+
+/**
+ * @brief Добавить задание в файл пресетов или заменить задание с тем же именем.
+ * @details Остальные задания файла переписываются как были. Нет файла — он создаётся;
+ *          файл с неверным JSON не трогается (ошибка).
+ */
+bool saveJobPreset(const QString& path, const JobPreset& preset, QString* errorOut = nullptr);
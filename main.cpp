@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "cli.h"
 
 #include <QApplication>
 #include <QLocale>
@@ -101,6 +102,10 @@ static void applyWindowsTheme(QApplication& app)
 
 int main(int argc, char *argv[])
 {
+    // Консольный режим: без QApplication и окон (скрипты сборки, CI).
+    if (isCliInvocation(argc, argv))
+        return runCli(argc, argv);
+
     QApplication a(argc, argv);
 
 
@@ -1,6 +1,10 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 #include "reportgenerator.h"
+#include "optionparse.h"
+#include "reportwriter.h"
+#include "compressedoutput.h"
+#include "reportmanifest.h"
 #include <QFileDialog>
 #include <QFile>
 #include <QMenu>
@@ -16,170 +20,10 @@
 #include <QGuiApplication>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QProgressDialog>
-
-
-
-
-
-/**
- * @brief Парсит строку размера (например: "1MB", "512KB", "2.5MiB") в байты.
- * @details
- *  Используются бинарные множители как в PowerShell (1MB = 1024*1024).
- *  Поддерживаемые суффиксы (без учёта регистра):
- *   - B (или без суффикса) -> байты
- *   - K, KB, KiB -> 1024
- *   - M, MB, MiB -> 1024^2
- *   - G, GB, GiB -> 1024^3
- *   - T, TB, TiB -> 1024^4
- *
- * @param text Входной текст.
- * @param bytesOut Результат в байтах.
- * @param errorOut (опционально) текст ошибки.
- * @return true если распознано.
- */
-static bool parseHumanSizeToBytes(QString text, qint64* bytesOut, QString* errorOut = nullptr)
-{
-    if (bytesOut) *bytesOut = 0;
-
-    text = text.trimmed();
-    if (text.isEmpty())
-    {
-        if (errorOut) *errorOut = QStringLiteral("пустая строка");
-        return false;
-    }
-
-    // Для русской раскладки: "1,5MB" -> "1.5MB"
-    text.replace(',', '.');
-
-    const QRegularExpression re(QStringLiteral(R"(^\s*([0-9]+(?:\.[0-9]+)?)\s*([A-Za-z]*)\s*$)"));
-    const auto m = re.match(text);
-    if (!m.hasMatch())
-    {
-        if (errorOut) *errorOut = QStringLiteral("неверный формат. Пример: 1MB, 512KB, 2.5MiB");
-        return false;
-    }
-
-    bool ok = false;
-    const double value = m.captured(1).toDouble(&ok);
-    if (!ok || value <= 0.0)
-    {
-        if (errorOut) *errorOut = QStringLiteral("число должно быть > 0");
-        return false;
-    }
-
-    QString suf = m.captured(2).trimmed().toLower();
-
-    long double mul = 1.0L;
-    if (suf.isEmpty() || suf == "b" || suf == "byte" || suf == "bytes")
-        mul = 1.0L;
-    else if (suf == "k" || suf == "kb" || suf == "kib")
-        mul = 1024.0L;
-    else if (suf == "m" || suf == "mb" || suf == "mib")
-        mul = 1024.0L * 1024.0L;
-    else if (suf == "g" || suf == "gb" || suf == "gib")
-        mul = 1024.0L * 1024.0L * 1024.0L;
-    else if (suf == "t" || suf == "tb" || suf == "tib")
-        mul = 1024.0L * 1024.0L * 1024.0L * 1024.0L;
-    else
-    {
-        if (errorOut) *errorOut = QStringLiteral("неизвестный суффикс: %1").arg(suf);
-        return false;
-    }
-
-    const long double bytesLd = (long double)value * mul;
-
-    if (bytesLd > (long double)std::numeric_limits<qint64>::max())
-    {
-        if (errorOut) *errorOut = QStringLiteral("слишком большое значение");
-        return false;
-    }
-
-    // Округляем до ближайшего целого байта.
-    const qint64 bytes = (qint64)(bytesLd + 0.5L);
-    if (bytes <= 0)
-    {
-        if (errorOut) *errorOut = QStringLiteral("получилось <= 0 байт");
-        return false;
-    }
-
-    if (bytesOut) *bytesOut = bytes;
-    return true;
-}
-
-
-/**
- * @brief Разбирает пользовательский список из текстового поля.
- * @details
- *  Разделители: перевод строки, пробелы/табы, запятая, точка с запятой.
- *  Пустые элементы игнорируются, дубликаты убираются (с сохранением порядка).
- *
- * @param text Исходный текст из QPlainTextEdit/QTextEdit.
- * @param forceDotPrefix Если true — для элементов будет гарантирована точка в начале (для расширений).
- * @param toLower Если true — приводим к нижнему регистру (удобно для сравнения как в PowerShell).
- */
-static QStringList parseUserList(const QString& text, bool forceDotPrefix, bool toLower)
-{
-    const QStringList tokens = text.split(QRegularExpression(QStringLiteral(R"([\s,;]+)")),
-                                          Qt::SkipEmptyParts);
-
-    QStringList out;
-    QSet<QString> seen;
-
-    for (QString t : tokens)
-    {
-        t = t.trimmed();
-        if (t.isEmpty())
-            continue;
-
-        if (forceDotPrefix && !t.startsWith('.'))
-            t.prepend('.');
-
-        if (toLower)
-            t = t.toLower();
-
-        if (!seen.contains(t))
-        {
-            seen.insert(t);
-            out.push_back(t);
-        }
-    }
-    return out;
-}
-
-
-/**
- * @brief Список расширений, как в исходном PowerShell-скрипте.
- */
-static QStringList defaultIncludeExt()
-{
-    return {
-        // Документы
-        ".doc",".docx",".pdf",
-        // Excel
-        ".xls",".xlsx",".xlsm",
-        // Qt Designer
-        ".ui", ".qrc", ".ts", ".qss", ".pri", ".pro",
-        // Скрипты/текст
-        ".ps1",".psm1",".psd1",".bat",".cmd",
-        ".txt",".md",".json",".xml",".yaml",".yml",".csv",".ini",".config",
-        ".cs",".vb",".fs",".cpp",".hpp",".c",".h",
-        ".py",".rb",".go",".tsx",".js",".jsx",".html",".css"
-
-    };
-}
-
-
-/**
- * @brief Список папок-исключений, как в исходном PowerShell-скрипте.
- */
-static QStringList defaultExcludeDirs()
-{
-    return {
-        ".git","node_modules","bin","obj",".vs",".vscode",".idea",".venv","venv",
-        "dist","build",".terraform",".cache",".pytest_cache"
-    };
-}
-
+#include <QDateTime>
+#include <QSaveFile>
+#include <QTextEdit>
+#include <algorithm>
 
 
 
@@ -192,10 +36,11 @@ MainWindow::MainWindow(QWidget *parent)
     setWindowTitle(tr("ContextMaker"));
 
 
-    ui->teReprt->setReadOnly(true);
+    // Просмотр постраничный: в QTextEdit грузится только текущая страница отчёта.
+    QTextEdit* const reportText = ui->teReprt->textView();
 
     // Небольшой стиль для ``` блоков (работает при setMarkdown)
-    ui->teReprt->document()->setDefaultStyleSheet(
+    reportText->document()->setDefaultStyleSheet(
         "code, pre { font-family: Consolas, 'Courier New', monospace; }"
         "pre { background-color: rgba(127,127,127,0.15); padding: 6px; }"
         );
@@ -233,22 +78,38 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->pbSave, &QPushButton::clicked, this, &MainWindow::onSaveClicked);
 
     // Контекстное меню для QTextEdit (ПКМ -> Копировать).
-    ui->teReprt->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(ui->teReprt, &QTextEdit::customContextMenuRequested,
+    reportText->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(reportText, &QTextEdit::customContextMenuRequested,
             this, &MainWindow::onReportContextMenuRequested);
 
     refreshUiState();
     setStatus(QStringLiteral("Выберите каталог и нажмите «Собрать отчёт»."));
 
     connect(&m_buildWatcher,
-            &QFutureWatcher<QPair<QString, QString>>::finished,
+            &QFutureWatcher<BuildResult>::finished,
             this,
             &MainWindow::onBuildFinished);
 
+    connect(ui->cbWatch, &QCheckBox::toggled, this, &MainWindow::onWatchToggled);
+    connect(&m_reportWatcher, &ReportWatcher::changed, this, &MainWindow::onWatchChanged);
+
+    connect(&m_saveWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::onSaveFinished);
+
+    m_progressTimer.setInterval(200);
+    connect(&m_progressTimer, &QTimer::timeout, this, &MainWindow::onProgressTick);
+
 }
 
 MainWindow::~MainWindow()
 {
+    // Генератор пишет в счётчики и читает флаг отмены окна — ждём его до разрушения полей.
+    // Пересборка по слежению идёт без диалога, и окно можно закрыть прямо во время неё.
+    m_reportWatcher.stop();
+    m_cancelRequested.store(true, std::memory_order_relaxed);
+    m_buildWatcher.waitForFinished();
+
+    // Начатое сохранение доводим до конца: иначе файл не появится (QSaveFile без commit()).
+    m_saveWatcher.waitForFinished();
     delete ui;
 }
 
@@ -268,14 +129,14 @@ void MainWindow::refreshUiState()
     /** \brief Во время генерации блокируем кнопки, чтобы не было гонок. */
     ui->pbOpen->setEnabled(!m_buildInProgress);
     ui->pbBuild->setEnabled(!m_buildInProgress && hasDir);
-    ui->pbSave->setEnabled(!m_buildInProgress && hasReport);
+    ui->pbSave->setEnabled(!m_buildInProgress && !m_saveInProgress && hasReport);
 
     // (Опционально) Можно ещё блокировать поля настроек:
     ui->leMaxBytes->setEnabled(!m_buildInProgress);
     ui->leMaxOutChars->setEnabled(!m_buildInProgress);
     ui->pteIncludeExt->setEnabled(!m_buildInProgress);
     ui->pteExcludeDir->setEnabled(!m_buildInProgress);
-    ui->cbUseCmdTree->setEnabled(!m_buildInProgress);
+    ui->cbAsciiTree->setEnabled(!m_buildInProgress);
     ui->cbTreeOnly->setEnabled(!m_buildInProgress);
     ui->cbEncodingMode->setEnabled(!m_buildInProgress);
 }
@@ -302,22 +163,15 @@ void MainWindow::onOpenClicked()
     if (dir.isEmpty())
         return;
 
+    if (QDir::cleanPath(dir) != m_rootDir)
+        stopWatching();
+
     m_rootDir = QDir::cleanPath(dir);
     setStatus(QStringLiteral("Каталог выбран: %1").arg(m_rootDir));
     refreshUiState();
 }
 
 
-static bool parseHumanSizeToBytesAllowZero(QString text, qint64* out, QString* err=nullptr)
-{
-    const QString t = text.trimmed();
-    if (t == "0" || t.compare("0B", Qt::CaseInsensitive) == 0)
-    {
-        if (out) *out = 0;
-        return true;
-    }
-    return parseHumanSizeToBytes(text, out, err);
-}
 
 void MainWindow::onBuildClicked()
 {
@@ -332,20 +186,28 @@ void MainWindow::onBuildClicked()
         return;
     }
 
-    // =========================
-    //  1) Считываем параметры UI
-    // =========================
-    ReportGenerator::Options opt;
+    startBuild(/*silent*/false);
+}
+
+bool MainWindow::readOptions(ReportGenerator::Options* optOut, bool interactive)
+{
+    auto fail = [this, interactive](const QString& title, const QString& text) {
+        if (interactive)
+            QMessageBox::warning(this, title, text);
+        else
+            setStatus(QStringLiteral("%1: %2").arg(title, text));
+        return false;
+    };
+
+    ReportGenerator::Options& opt = *optOut;
 
     qint64 maxOutChars = 0;
     QString outErr;
     if (!parseHumanSizeToBytesAllowZero(ui->leMaxOutChars->text(), &maxOutChars, &outErr))
     {
-        QMessageBox::warning(this,
-                             QStringLiteral("Неверный лимит вывода"),
-                             QStringLiteral("Не удалось разобрать лимит вывода: %1\nПример: 200KB, 1MB, 5MB")
-                                 .arg(outErr));
-        return;
+        return fail(QStringLiteral("Неверный лимит вывода"),
+                    QStringLiteral("Не удалось разобрать лимит вывода: %1\nПример: 200KB, 1MB, 5MB")
+                        .arg(outErr));
     }
     opt.maxOutChars = maxOutChars;
 
@@ -361,11 +223,9 @@ void MainWindow::onBuildClicked()
     QString sizeErr;
     if (!parseHumanSizeToBytes(ui->leMaxBytes->text(), &maxBytes, &sizeErr))
     {
-        QMessageBox::warning(this,
-                             QStringLiteral("Неверный MaxBytes"),
-                             QStringLiteral("Не удалось разобрать MaxBytes: %1\nПример: 1MB, 512KB, 2.5MiB")
-                                 .arg(sizeErr));
-        return;
+        return fail(QStringLiteral("Неверный MaxBytes"),
+                    QStringLiteral("Не удалось разобрать MaxBytes: %1\nПример: 1MB, 512KB, 2.5MiB")
+                        .arg(sizeErr));
     }
     opt.maxBytes = maxBytes;
 
@@ -381,13 +241,42 @@ void MainWindow::onBuildClicked()
     if (opt.excludeDirNames.isEmpty())
         opt.excludeDirNames = defaultExcludeDirs();
 
-    opt.useCmdTree = ui->cbUseCmdTree->isChecked();
+    opt.treeStyle = ui->cbAsciiTree->isChecked() ? ReportGenerator::Options::TreeStyle::Ascii
+                                                  : ReportGenerator::Options::TreeStyle::Unicode;
+    return true;
+}
+
+void MainWindow::startBuild(bool silent)
+{
+    // =========================
+    //  1) Считываем параметры UI
+    // =========================
+    ReportGenerator::Options opt;
+    if (!readOptions(&opt, !silent))
+        return;
+
+    // В режиме слежения отчёт пишется в файл с манифестом: следующая пересборка
+    // возьмёт из него блоки неизменённых файлов и прочитает только изменённые.
+    QString reportPath;
+    if (ui->cbWatch->isChecked())
+    {
+        if (!m_watchDir)
+            m_watchDir.reset(new QTemporaryDir());
+
+        if (m_watchDir->isValid())
+        {
+            reportPath = m_watchDir->filePath(QStringLiteral("report-%1.md").arg(m_watchBuildCount % 2));
+            opt.manifestPath = ReportManifest::pathForReport(reportPath);
+            opt.previousReportPath = m_watchReportPath;
+        }
+    }
 
     // =========================
     //  2) Запускаем асинхронно
     // =========================
 
     m_buildInProgress = true;
+    m_silentBuild = silent;
     m_cancelRequested.store(false, std::memory_order_relaxed);
     refreshUiState();
 
@@ -399,40 +288,83 @@ void MainWindow::onBuildClicked()
         m_progress = nullptr;
     }
 
-    /** \brief Спиннер/диалог прогресса с кнопкой отмены. */
-    m_progress = new QProgressDialog(tr("Генерация отчёта…"),
-                                     tr("Отмена"),
-                                     0, 0,
-                                     this);
-    m_progress->setWindowModality(Qt::WindowModal);
-    m_progress->setMinimumDuration(0);
-    m_progress->setAutoClose(false);
-    m_progress->setAutoReset(false);
-
-    connect(m_progress, &QProgressDialog::canceled, this, [this]() {
-        /** \brief Кооперативная отмена — генератор периодически проверяет флаг. */
-        m_cancelRequested.store(true, std::memory_order_relaxed);
-        setStatus(QStringLiteral("Отмена…"));
-    });
-
-    m_progress->show();
+    if (!silent)
+    {
+        /** \brief Диалог прогресса с кнопкой отмены (спиннер, пока число файлов неизвестно). */
+        m_progress = new QProgressDialog(tr("Генерация отчёта…"),
+                                         tr("Отмена"),
+                                         0, 0,
+                                         this);
+        m_progress->setWindowModality(Qt::WindowModal);
+        m_progress->setMinimumDuration(0);
+        m_progress->setAutoClose(false);
+        m_progress->setAutoReset(false);
+
+        connect(m_progress, &QProgressDialog::canceled, this, [this]() {
+            /** \brief Кооперативная отмена — генератор периодически проверяет флаг. */
+            m_cancelRequested.store(true, std::memory_order_relaxed);
+            setStatus(QStringLiteral("Отмена…"));
+        });
+
+        m_progress->show();
+    }
 
-    // Передаём генератору флаг отмены (важно: указатель должен жить дольше генерации)
+    // Передаём генератору флаг отмены и счётчики (важно: указатели должны жить дольше генерации)
     opt.cancelRequested = &m_cancelRequested;
 
-    setStatus(QStringLiteral("Генерация отчёта…"));
-    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_progressStats.reset();
+    opt.progress = &m_progressStats;
 
-    using Result = QPair<QString, QString>; // (report, error)
+    if (!silent)
+    {
+        m_progressTimer.start();
+        setStatus(QStringLiteral("Генерация отчёта…"));
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+    }
 
     /** \brief Фоновая генерация отчёта.
      *  \details opt копируется по значению, внутри будет создаваться ReportGenerator.
      */
-    auto future = QtConcurrent::run([opt]() -> Result {
-        ReportGenerator gen(opt);
-        QString error;
-        const QString report = gen.generate(&error);
-        return qMakePair(report, error);
+    auto future = QtConcurrent::run([opt, reportPath]() -> BuildResult {
+        BuildResult r;
+        r.reportPath = reportPath;
+
+        ReportGenerator::Options o = opt;
+        o.dependenciesOut = &r.deps;
+        ReportGenerator gen(o);
+
+        if (reportPath.isEmpty())
+        {
+            r.report = gen.generate(&r.error);
+            return r;
+        }
+
+        // Прошлый отчёт лежит в другом файле (чередование) и читается по ходу записи нового.
+        QSaveFile file(reportPath);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            r.error = QStringLiteral("Не удалось создать временный отчёт: %1").arg(file.errorString());
+            return r;
+        }
+        if (!gen.generateToDevice(&file, &r.error))
+        {
+            file.cancelWriting();
+            return r;
+        }
+        if (!file.commit())
+        {
+            r.error = QStringLiteral("Не удалось записать временный отчёт: %1").arg(file.errorString());
+            return r;
+        }
+
+        QFile in(reportPath);
+        if (!in.open(QIODevice::ReadOnly))
+        {
+            r.error = QStringLiteral("Не удалось прочитать временный отчёт: %1").arg(in.errorString());
+            return r;
+        }
+        r.report = QString::fromUtf8(in.readAll());
+        return r;
     });
 
     /** \brief Завершение обработается в onBuildFinished() (через QFutureWatcher::finished). */
@@ -446,7 +378,7 @@ void MainWindow::onSaveClicked()
 {
     //const QString text = ui->teReprt->toPlainText();
     const QString text = m_reportMarkdown.isEmpty()
-                             ? ui->teReprt->toPlainText()
+                             ? ui->teReprt->textView()->toPlainText()
                              : m_reportMarkdown;
 
     if (text.isEmpty())
@@ -465,11 +397,18 @@ void MainWindow::onSaveClicked()
             suggested = QDir::home().filePath("report.md");
     }
 
+    QString filters = QStringLiteral("Markdown (*.md);;Text (*.txt)");
+    if (compressionAvailable(OutputCompression::Gzip))
+        filters += QStringLiteral(";;Markdown, gzip (*.md.gz)");
+    if (compressionAvailable(OutputCompression::Zstd))
+        filters += QStringLiteral(";;Markdown, zstd (*.md.zst)");
+    filters += QStringLiteral(";;All Files (*.*)");
+
     QString fileName = QFileDialog::getSaveFileName(
         this,
         QStringLiteral("Сохранить отчёт"),
         suggested,
-        QStringLiteral("Markdown (*.md);;Text (*.txt);;All Files (*.*)")
+        filters
         );
 
     if (fileName.isEmpty())
@@ -479,39 +418,60 @@ void MainWindow::onSaveClicked()
     if (QFileInfo(fileName).suffix().isEmpty())
         fileName += ".md";
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    startSave(fileName, text);
+}
+
+void MainWindow::startSave(const QString& fileName, const QString& text)
+{
+    m_saveInProgress = true;
+    // Файл может лежать в наблюдаемом каталоге: своё сохранение — не изменение.
+    m_ignoreSaveEventsUntilMs = std::numeric_limits<qint64>::max();
+    m_savingPath = fileName;
+    refreshUiState();
+    setStatus(QStringLiteral("Сохранение: %1…").arg(fileName));
+
+    /** \brief Кодирование и запись — в фоне, кусками: окно не замирает, второй копии отчёта нет.
+     *  \details text — неявно разделяемая копия QString, данные не копируются.
+     *           Пишем UTF-8 с BOM (чаще удобнее для Windows/Notepad).
+     */
+    m_saveWatcher.setFuture(QtConcurrent::run([text, fileName]() -> QString {
+        QString error;
+        saveReportToFile(text, fileName, /*withBom*/true, &error);
+        return error;
+    }));
+}
+
+void MainWindow::onSaveFinished()
+{
+    const QString error = m_saveWatcher.result();
+    m_saveInProgress = false;
+    // События о записи файла приходят с задержкой (и ещё ждут паузу серии).
+    m_ignoreSaveEventsUntilMs = QDateTime::currentMSecsSinceEpoch() + 3000;
+    refreshUiState();
+
+    if (!error.isEmpty())
     {
-        QMessageBox::critical(this, QStringLiteral("Ошибка сохранения"),
-                              QStringLiteral("Не удалось открыть файл для записи:\n%1").arg(file.errorString()));
+        setStatus(QStringLiteral("Ошибка сохранения."));
+        QMessageBox::critical(this, QStringLiteral("Ошибка сохранения"), error);
         return;
     }
 
-    // Пишем UTF-8 с BOM (чаще удобнее для Windows/Notepad).
-    QByteArray out;
-    out.append(char(0xEF));
-    out.append(char(0xBB));
-    out.append(char(0xBF));
-    out.append(text.toUtf8());
-
-    file.write(out);
-    file.close();
-
-    m_lastSavePath = fileName;
-    setStatus(QStringLiteral("Сохранено: %1").arg(fileName));
+    m_lastSavePath = m_savingPath;
+    setStatus(QStringLiteral("Сохранено: %1").arg(m_savingPath));
 }
 
 void MainWindow::onReportContextMenuRequested(const QPoint& pos)
 {
     QMenu menu(this);
+    QTextEdit* const reportText = ui->teReprt->textView();
 
     QAction* copyAction = menu.addAction(QStringLiteral("Копировать"));
-    copyAction->setEnabled(ui->teReprt->textCursor().hasSelection());
-    connect(copyAction, &QAction::triggered, ui->teReprt, &QTextEdit::copy);
+    copyAction->setEnabled(reportText->textCursor().hasSelection());
+    connect(copyAction, &QAction::triggered, reportText, &QTextEdit::copy);
 
     // (Опционально) можно добавить "Выделить всё" — обычно удобно.
     QAction* selectAllAction = menu.addAction(QStringLiteral("Выделить всё"));
-    connect(selectAllAction, &QAction::triggered, ui->teReprt, &QTextEdit::selectAll);
+    connect(selectAllAction, &QAction::triggered, reportText, &QTextEdit::selectAll);
 
     QAction* copyMdAction = menu.addAction(QStringLiteral("Копировать (Markdown)"));
     copyMdAction->setEnabled(!m_reportMarkdown.isEmpty());
@@ -520,12 +480,68 @@ void MainWindow::onReportContextMenuRequested(const QPoint& pos)
     });
     menu.addSeparator();
 
-    menu.exec(ui->teReprt->mapToGlobal(pos));
+    menu.exec(reportText->mapToGlobal(pos));
+}
+
+void MainWindow::onProgressTick()
+{
+    if (!m_progress)
+        return;
+
+    const ReportProgress& p = m_progressStats;
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const qint64 startedMs = p.startedMs.load(std::memory_order_relaxed);
+    const double elapsedSec = (startedMs > 0) ? (nowMs - startedMs) / 1000.0 : 0.0;
+
+    switch (p.phase.load(std::memory_order_relaxed))
+    {
+    case ReportProgress::Contents:
+    {
+        const qint64 total = p.filesSelected.load(std::memory_order_relaxed);
+        const qint64 done = p.filesDone.load(std::memory_order_relaxed);
+        const qint64 bytes = p.bytesRead.load(std::memory_order_relaxed);
+
+        m_progress->setMaximum((int)qMin<qint64>(total, std::numeric_limits<int>::max()));
+        m_progress->setValue((int)qMin<qint64>(done, std::numeric_limits<int>::max()));
+
+        qint64 sinceMs = 0;
+        const QString current = p.currentFile(&sinceMs);
+        const double mbPerSec = (elapsedSec > 0.0) ? bytes / (1024.0 * 1024.0) / elapsedSec : 0.0;
+
+        QString text = tr("Содержимое файлов: %1 из %2 (прочитано %3, %4 МБ/с)")
+                           .arg(done)
+                           .arg(total)
+                           .arg(p.filesExtracted.load(std::memory_order_relaxed))
+                           .arg(mbPerSec, 0, 'f', 1);
+
+        if (!current.isEmpty())
+        {
+            const qint64 stallSec = (sinceMs > 0) ? (nowMs - sinceMs) / 1000 : 0;
+            text += QStringLiteral("\n") + QDir::toNativeSeparators(QFileInfo(current).fileName());
+            if (stallSec >= 2)
+                text += tr(" (%1 с)").arg(stallSec);
+        }
+
+        m_progress->setLabelText(text);
+        break;
+    }
+    case ReportProgress::Scanning:
+        m_progress->setMaximum(0);
+        m_progress->setLabelText(tr("Обход каталога: %1 элементов…")
+                                     .arg(p.entriesScanned.load(std::memory_order_relaxed)));
+        break;
+    default:
+        break;
+    }
 }
 
 void MainWindow::onBuildFinished()
 {
-    QApplication::restoreOverrideCursor();
+    const bool silent = m_silentBuild;
+    if (!silent)
+        QApplication::restoreOverrideCursor();
+    m_progressTimer.stop();
 
     if (m_progress)
     {
@@ -535,10 +551,13 @@ void MainWindow::onBuildFinished()
     }
 
     m_buildInProgress = false;
+    m_silentBuild = false;
+
+    const BuildResult result = m_buildWatcher.result();
+    const QString& report = result.report;
+    const QString& error = result.error;
 
-    const auto result = m_buildWatcher.result();
-    const QString report = result.first;
-    const QString error  = result.second;
+    const bool watching = ui->cbWatch->isChecked();
 
     if (report.isEmpty() && !error.isEmpty())
     {
@@ -547,6 +566,11 @@ void MainWindow::onBuildFinished()
         {
             setStatus(QStringLiteral("Отменено пользователем."));
         }
+        else if (silent)
+        {
+            // Пересборка по слежению окно не открывает: прошлый отчёт остаётся на экране.
+            setStatus(QStringLiteral("Пересборка не удалась: %1").arg(error));
+        }
         else
         {
             QMessageBox::critical(this, QStringLiteral("Ошибка"), error);
@@ -554,21 +578,122 @@ void MainWindow::onBuildFinished()
         }
 
         refreshUiState();
+        if (watching && m_watchRebuildPending)
+        {
+            m_watchRebuildPending = false;
+            startBuild(/*silent*/true);
+        }
         return;
     }
 
+    QString status;
     if (!error.isEmpty())
-        setStatus(QStringLiteral("Отчёт сгенерирован с предупреждением: %1").arg(error));
+        status = QStringLiteral("Отчёт сгенерирован с предупреждением: %1").arg(error);
     else
-        setStatus(QStringLiteral("Отчёт готов."));
+    {
+        const qint64 startedMs = m_progressStats.startedMs.load(std::memory_order_relaxed);
+        const double elapsedSec = (startedMs > 0) ? (QDateTime::currentMSecsSinceEpoch() - startedMs) / 1000.0 : 0.0;
+        status = QStringLiteral("%1: %2 файлов (прочитано %3, %4 МБ) за %5 с.")
+                     .arg(silent ? QStringLiteral("Отчёт обновлён %1").arg(QTime::currentTime().toString(QStringLiteral("HH:mm:ss")))
+                                 : QStringLiteral("Отчёт готов"))
+                     .arg(m_progressStats.filesDone.load(std::memory_order_relaxed))
+                     .arg(m_progressStats.filesExtracted.load(std::memory_order_relaxed))
+                     .arg(m_progressStats.bytesRead.load(std::memory_order_relaxed) / (1024.0 * 1024.0), 0, 'f', 1)
+                     .arg(elapsedSec, 0, 'f', 1);
+    }
 
+    const bool changed = (report != m_reportMarkdown);
     m_reportMarkdown = report;
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    ui->teReprt->setMarkdown(m_reportMarkdown);
-#else
-    ui->teReprt->setPlainText(m_reportMarkdown);
-#endif
+    // Вёрстка только видимой страницы — GUI не замирает даже на отчётах в десятки МБ.
+    // Пересборка по слежению оставляет просмотр на том же месте.
+    if (!silent || changed)
+        ui->teReprt->setReport(m_reportMarkdown, /*keepPosition*/silent);
+
+    if (watching && !result.reportPath.isEmpty())
+    {
+        m_watchReportPath = result.reportPath;
+        ++m_watchBuildCount;
+
+        const int unwatched = m_reportWatcher.watch(result.deps.dirs, result.deps.files);
+        if (unwatched > 0)
+            status += QStringLiteral(" Слежение: %1 путей сверх лимита не отслеживаются.").arg(unwatched);
 
+        // Сохранённый файл держим в актуальном состоянии (если отчёт действительно изменился).
+        if (silent && changed && !m_lastSavePath.isEmpty() && !m_saveInProgress)
+            startSave(m_lastSavePath, m_reportMarkdown);
+    }
+
+    setStatus(status);
     refreshUiState();
+
+    if (watching && m_watchRebuildPending)
+    {
+        m_watchRebuildPending = false;
+        startBuild(/*silent*/true);
+    }
+}
+
+void MainWindow::onWatchToggled(bool on)
+{
+    if (!on)
+    {
+        stopWatching();
+        setStatus(QStringLiteral("Слежение выключено."));
+        return;
+    }
+
+    // База для инкрементальных пересборок — отчёт с манифестом; строим её сразу, если отчёт уже есть.
+    if (m_rootDir.isEmpty() || m_reportMarkdown.isEmpty())
+    {
+        setStatus(QStringLiteral("Слежение начнётся после сборки отчёта."));
+        return;
+    }
+    if (m_buildInProgress)
+    {
+        m_watchRebuildPending = true;
+        return;
+    }
+    setStatus(QStringLiteral("Слежение: сборка отчёта…"));
+    startBuild(/*silent*/true);
+}
+
+void MainWindow::onWatchChanged(const QStringList& paths)
+{
+    if (!ui->cbWatch->isChecked() || m_rootDir.isEmpty())
+        return;
+
+    // Своё сохранение отчёта в наблюдаемый каталог — не повод пересобирать (иначе цикл).
+    const QString savePath = m_saveInProgress ? m_savingPath : m_lastSavePath;
+    if (!savePath.isEmpty() && QDateTime::currentMSecsSinceEpoch() < m_ignoreSaveEventsUntilMs)
+    {
+        const QString saveFile = QDir::cleanPath(QFileInfo(savePath).absoluteFilePath());
+        const QString saveDir = QFileInfo(saveFile).absolutePath();
+        const bool onlyOwnSave = std::all_of(paths.cbegin(), paths.cend(), [&](const QString& p) {
+            const QString clean = QDir::cleanPath(p);
+            return clean == saveFile || clean == saveDir;
+        });
+        if (onlyOwnSave)
+            return;
+    }
+
+    if (m_buildInProgress)
+    {
+        m_watchRebuildPending = true;
+        return;
+    }
+
+    setStatus(QStringLiteral("Изменения в каталоге (%1) — пересборка…").arg(paths.size()));
+    startBuild(/*silent*/true);
+}
+
+void MainWindow::stopWatching()
+{
+    m_reportWatcher.stop();
+    m_watchRebuildPending = false;
+    m_watchReportPath.clear();
+
+    // Идущая сборка может писать в эту папку — тогда папку оставляем до следующего раза.
+    if (!m_buildInProgress)
+        m_watchDir.reset();
 }
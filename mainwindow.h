@@ -5,7 +5,13 @@
 #include <QFutureWatcher>
 #include <QPair>
 #include <QPointer>
+#include <QTemporaryDir>
+#include <QTimer>
 #include <atomic>
+#include <memory>
+
+#include "reportgenerator.h"
+#include "reportwatcher.h"
 
 class QProgressDialog;
 
@@ -16,6 +22,15 @@ class MainWindow;
 }
 QT_END_NAMESPACE
 
+/** \brief Результат фоновой генерации. */
+struct BuildResult
+{
+    QString report;
+    QString error;
+    QString reportPath;        ///< Файл отчёта в режиме слежения (пусто — отчёт только в памяти).
+    ReportDependencies deps;   ///< Папки и файлы, за которыми следить после сборки.
+};
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -30,6 +45,10 @@ private slots:
     void onSaveClicked();
     void onReportContextMenuRequested(const QPoint& pos);
     void onBuildFinished();
+    void onSaveFinished();
+    void onProgressTick();
+    void onWatchToggled(bool on);
+    void onWatchChanged(const QStringList& paths);
 
 
 private:
@@ -39,15 +58,52 @@ private:
     QString m_lastSavePath;     ///< Последний путь сохранения (для удобства).
     QString m_reportMarkdown; ///< Исходный markdown отчёта (для сохранения в файл).
     bool m_buildInProgress = false; ///< Идёт ли сейчас генерация отчёта.
+    bool m_saveInProgress = false;  ///< Идёт ли сейчас сохранение (в фоне).
+    QString m_savingPath;           ///< Куда идёт текущее сохранение.
 
     std::atomic_bool m_cancelRequested { false }; ///< Флаг отмены для генератора.
 
-    /** \brief Результат фоновой генерации: (report, error). */
-    QFutureWatcher<QPair<QString, QString>> m_buildWatcher;
+    bool m_silentBuild = false;     ///< Текущая сборка запущена слежением (без диалога прогресса).
 
-    /** \brief Диалог прогресса (спиннер) на время генерации. */
+    /** \brief Результат фоновой генерации. */
+    QFutureWatcher<BuildResult> m_buildWatcher;
+
+    /** \brief Результат фонового сохранения: текст ошибки (пусто = успех). */
+    QFutureWatcher<QString> m_saveWatcher;
+
+    /** \brief Диалог прогресса на время генерации. */
     QPointer<QProgressDialog> m_progress;
 
+    ReportProgress m_progressStats;  ///< Счётчики, которые пишет генератор.
+    QTimer m_progressTimer;          ///< Опрос счётчиков для обновления диалога.
+
+    /** \brief Режим слежения: изменения в каталоге пересобирают отчёт. */
+    ReportWatcher m_reportWatcher;
+    /** \brief Отчёты и манифесты режима слежения (во временной папке, не в каталоге). */
+    std::unique_ptr<QTemporaryDir> m_watchDir;
+    QString m_watchReportPath;        ///< Последний отчёт слежения: из него берутся неизменённые блоки.
+    int m_watchBuildCount = 0;        ///< Отчёты чередуются между двумя файлами (прошлый читается при записи нового).
+    bool m_watchRebuildPending = false; ///< Изменения пришли во время сборки — пересобрать после неё.
+    qint64 m_ignoreSaveEventsUntilMs = 0; ///< До этого момента события от своего сохранения не считаются изменениями.
+
+    /**
+     * @brief Считать параметры генератора из полей окна.
+     * @param interactive Ошибки показывать окном (иначе — в статус-баре).
+     */
+    bool readOptions(ReportGenerator::Options* opt, bool interactive);
+
+    /**
+     * @brief Запустить генерацию в фоне.
+     * @param silent Пересборка по слежению: без диалога прогресса, позиция просмотра сохраняется.
+     */
+    void startBuild(bool silent);
+
+    /** \brief Сохранить текст отчёта в файл в фоне. */
+    void startSave(const QString& fileName, const QString& text);
+
+    /** \brief Выключить слежение и забыть базу инкрементальной пересборки. */
+    void stopWatching();
+
     /**
      * @brief Включить/выключить кнопки в зависимости от состояния.
      */
@@ -0,0 +1,168 @@
+/**
+ * @file optionparse.cpp
+ * @brief Реализация разбора пользовательского ввода настроек.
+ */
+
+#include "optionparse.h"
+
+#include <QRegularExpression>
+#include <QSet>
+#include <limits>
+
+
+bool parseHumanSizeToBytes(QString text, qint64* bytesOut, QString* errorOut)
+{
+    if (bytesOut) *bytesOut = 0;
+
+    text = text.trimmed();
+    if (text.isEmpty())
+    {
+        if (errorOut) *errorOut = QStringLiteral("пустая строка");
+        return false;
+    }
+
+    // Для русской раскладки: "1,5MB" -> "1.5MB"
+    text.replace(',', '.');
+
+    const QRegularExpression re(QStringLiteral(R"(^\s*([0-9]+(?:\.[0-9]+)?)\s*([A-Za-z]*)\s*$)"));
+    const auto m = re.match(text);
+    if (!m.hasMatch())
+    {
+        if (errorOut) *errorOut = QStringLiteral("неверный формат. Пример: 1MB, 512KB, 2.5MiB");
+        return false;
+    }
+
+    bool ok = false;
+    const double value = m.captured(1).toDouble(&ok);
+    if (!ok || value <= 0.0)
+    {
+        if (errorOut) *errorOut = QStringLiteral("число должно быть > 0");
+        return false;
+    }
+
+    QString suf = m.captured(2).trimmed().toLower();
+
+    long double mul = 1.0L;
+    if (suf.isEmpty() || suf == "b" || suf == "byte" || suf == "bytes")
+        mul = 1.0L;
+    else if (suf == "k" || suf == "kb" || suf == "kib")
+        mul = 1024.0L;
+    else if (suf == "m" || suf == "mb" || suf == "mib")
+        mul = 1024.0L * 1024.0L;
+    else if (suf == "g" || suf == "gb" || suf == "gib")
+        mul = 1024.0L * 1024.0L * 1024.0L;
+    else if (suf == "t" || suf == "tb" || suf == "tib")
+        mul = 1024.0L * 1024.0L * 1024.0L * 1024.0L;
+    else
+    {
+        if (errorOut) *errorOut = QStringLiteral("неизвестный суффикс: %1").arg(suf);
+        return false;
+    }
+
+    const long double bytesLd = (long double)value * mul;
+
+    if (bytesLd > (long double)std::numeric_limits<qint64>::max())
+    {
+        if (errorOut) *errorOut = QStringLiteral("слишком большое значение");
+        return false;
+    }
+
+    // Округляем до ближайшего целого байта.
+    const qint64 bytes = (qint64)(bytesLd + 0.5L);
+    if (bytes <= 0)
+    {
+        if (errorOut) *errorOut = QStringLiteral("получилось <= 0 байт");
+        return false;
+    }
+
+    if (bytesOut) *bytesOut = bytes;
+    return true;
+}
+
+
+QString formatHumanSize(qint64 bytes)
+{
+    static const char* const kUnits[] = { "KB", "MB", "GB", "TB" };
+
+    if (bytes < 1024)
+        return QStringLiteral("%1 B").arg(bytes);
+
+    double v = double(bytes) / 1024.0;
+    int unit = 0;
+    while (v >= 1024.0 && unit < 3)
+    {
+        v /= 1024.0;
+        ++unit;
+    }
+    return QStringLiteral("%1 %2").arg(v, 0, 'f', v < 10.0 ? 1 : 0).arg(QLatin1String(kUnits[unit]));
+}
+
+
+QStringList parseUserList(const QString& text, bool forceDotPrefix, bool toLower)
+{
+    const QStringList tokens = text.split(QRegularExpression(QStringLiteral(R"([\s,;]+)")),
+                                          Qt::SkipEmptyParts);
+
+    QStringList out;
+    QSet<QString> seen;
+
+    for (QString t : tokens)
+    {
+        t = t.trimmed();
+        if (t.isEmpty())
+            continue;
+
+        if (forceDotPrefix && !t.startsWith('.'))
+            t.prepend('.');
+
+        if (toLower)
+            t = t.toLower();
+
+        if (!seen.contains(t))
+        {
+            seen.insert(t);
+            out.push_back(t);
+        }
+    }
+    return out;
+}
+
+
+QStringList defaultIncludeExt()
+{
+    return {
+        // Документы
+        ".doc",".docx",".pdf",
+        // Excel
+        ".xls",".xlsx",".xlsm",
+        // Qt Designer
+        ".ui", ".qrc", ".ts", ".qss", ".pri", ".pro",
+        // Скрипты/текст
+        ".ps1",".psm1",".psd1",".bat",".cmd",
+        ".txt",".md",".json",".xml",".yaml",".yml",".csv",".ini",".config",
+        ".cs",".vb",".fs",".cpp",".hpp",".c",".h",
+        ".py",".rb",".go",".tsx",".js",".jsx",".html",".css"
+
+    };
+}
+
+
+QStringList defaultExcludeDirs()
+{
+    return {
+        ".git","node_modules","bin","obj",".vs",".vscode",".idea",".venv","venv",
+        "dist","build",".terraform",".cache",".pytest_cache"
+    };
+}
+
+
+bool parseHumanSizeToBytesAllowZero(QString text, qint64* out, QString* err)
+{
+    const QString t = text.trimmed();
+    if (t == "0" || t.compare("0B", Qt::CaseInsensitive) == 0)
+    {
+        if (out) *out = 0;
+        return true;
+    }
+    return parseHumanSizeToBytes(text, out, err);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file optionparse.h
+ * @brief Разбор пользовательского ввода настроек (размеры, списки) — общий для GUI и CLI.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Парсит строку размера (например: "1MB", "512KB", "2.5MiB") в байты.
+ * @details
+ *  Используются бинарные множители как в PowerShell (1MB = 1024*1024).
+ *  Поддерживаемые суффиксы (без учёта регистра):
+ *   - B (или без суффикса) -> байты
+ *   - K, KB, KiB -> 1024
+ *   - M, MB, MiB -> 1024^2
+ *   - G, GB, GiB -> 1024^3
+ *   - T, TB, TiB -> 1024^4
+ *
+ * @param text Входной текст.
+ * @param bytesOut Результат в байтах.
+ * @param errorOut (опционально) текст ошибки.
+ * @return true если распознано.
+ */
+bool parseHumanSizeToBytes(QString text, qint64* bytesOut, QString* errorOut = nullptr);
+
+/**
+ * @brief Как parseHumanSizeToBytes(), но "0" / "0B" допустимы (0 = без лимита).
+ */
+bool parseHumanSizeToBytesAllowZero(QString text, qint64* out, QString* err = nullptr);
+
+/**
+ * @brief Размер в байтах для показа человеку: "512 B", "3.4 KB", "1.2 GB" (множители 1024).
+ */
+QString formatHumanSize(qint64 bytes);
+
+/**
+ * @brief Разбирает пользовательский список из текстового поля.
+ * @details
+ *  Разделители: перевод строки, пробелы/табы, запятая, точка с запятой.
+ *  Пустые элементы игнорируются, дубликаты убираются (с сохранением порядка).
+ *
+ * @param text Исходный текст из QPlainTextEdit/QTextEdit.
+ * @param forceDotPrefix Если true — для элементов будет гарантирована точка в начале (для расширений).
+ * @param toLower Если true — приводим к нижнему регистру (удобно для сравнения как в PowerShell).
+ */
+QStringList parseUserList(const QString& text, bool forceDotPrefix, bool toLower);
+
+/**
+ * @brief Список расширений, как в исходном PowerShell-скрипте.
+ */
+QStringList defaultIncludeExt();
+
+/**
+ * @brief Список папок-исключений, как в исходном PowerShell-скрипте.
+ */
+QStringList defaultExcludeDirs();
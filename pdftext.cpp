@@ -0,0 +1,377 @@
+/**
+ * @file pdftext.cpp
+ * @brief Реализация извлечения текста из PDF.
+ * @details
+ *  pdftotext обрабатывает один документ за запуск и не умеет работать как сервер,
+ *  поэтому "пул долгоживущих процессов" для него невозможен. Когда при сборке найден
+ *  poppler-cpp, документы разбираются прямо в процессе (без запуска процесса и загрузки
+ *  DLL на каждый файл). Иначе остаётся pdftotext, но с таймаутом и ранней остановкой.
+ *
+ *  Вызов Poppler в процессе прервать нельзя: load_from_raw_data() или page->text() на битом
+ *  файле может работать сколько угодно. Поэтому при заданном таймауте, если pdftotext
+ *  найден, PDF идёт через него — процесс по таймауту убивается.
+ */
+
+#include "pdftext.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QStringList>
+#include <algorithm>
+#include <limits>
+
+#ifdef CONTEXTMAKER_HAVE_POPPLER_CPP
+#include <QFile>
+#include <memory>
+#include <poppler-document.h>
+#include <poppler-global.h>
+#include <poppler-page.h>
+#endif
+
+
+namespace {
+
+/** \brief Убрать разрывы страниц и привести переводы строк к LF. */
+void normalizePdfText(QString& t)
+{
+    /** \brief pdftotext вставляет 0x0C между страницами — в QTextEdit это "квадратик". */
+    t.replace(QChar(0x000C), QLatin1Char('\n'));
+    t.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+}
+
+QString pageLimitNote(int maxPages)
+{
+    return QStringLiteral("\n[ОБРЕЗАНО: выведены первые %1 стр.]").arg(maxPages);
+}
+
+bool isCanceled(const PdfTextLimits& limits)
+{
+    return limits.cancelRequested && limits.cancelRequested->load();
+}
+
+QString locatePdfToTextExe()
+{
+#ifdef Q_OS_WIN
+    const QDir appDir(QCoreApplication::applicationDirPath());
+
+    // 1) Вариант "положили прямо рядом с ContextMaker.exe" (не лучший, но пусть будет)
+    const QString flat = appDir.filePath(QStringLiteral("pdftotext.exe"));
+    if (QFileInfo::exists(flat))
+        return flat;
+
+    // 2) РЕКОМЕНДУЕМЫЙ вариант для деплоя:
+    // <рядом с exe>/tools/poppler/pdftotext.exe
+    const QString toolsPoppler = appDir.filePath(QStringLiteral("tools/poppler/pdftotext.exe"));
+    if (QFileInfo::exists(toolsPoppler))
+        return toolsPoppler;
+
+    // 3) Альтернатива: <рядом с exe>/poppler/pdftotext.exe
+    const QString poppler = appDir.filePath(QStringLiteral("poppler/pdftotext.exe"));
+    if (QFileInfo::exists(poppler))
+        return poppler;
+#endif
+
+    // 4) Если пользователь установил pdftotext в систему и добавил в PATH
+    const QString inPath = QStandardPaths::findExecutable(QStringLiteral("pdftotext"));
+    if (!inPath.isEmpty())
+        return inPath;
+
+    return {};
+}
+
+#ifdef CONTEXTMAKER_HAVE_POPPLER_CPP
+
+/** \brief Сообщения Poppler об ошибках в PDF не печатаем (их тысячи на битых файлах). */
+void silentPopplerDebug(const std::string&, void*)
+{
+}
+
+QString extractWithPopplerCpp(const QString& pdfPath, const PdfTextLimits& limits, QString* errorOut)
+{
+    static const bool silenced = [] {
+        poppler::set_debug_error_function(&silentPopplerDebug, nullptr);
+        return true;
+    }();
+    Q_UNUSED(silenced);
+
+    // Данные отдаются Poppler из отображения файла: и без копии, и без проблем с
+    // не-ASCII путями (load_from_file() на Windows принимает путь в ANSI).
+    QFile f(pdfPath);
+    if (!f.open(QIODevice::ReadOnly))
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось открыть PDF: %1").arg(f.errorString());
+        return {};
+    }
+    if (f.size() > std::numeric_limits<int>::max())
+    {
+        if (errorOut) *errorOut = QStringLiteral("PDF слишком большой.");
+        return {};
+    }
+
+    QByteArray fallback;
+    const char* data = reinterpret_cast<const char*>(f.map(0, f.size()));
+    if (!data)
+    {
+        fallback = f.readAll();
+        data = fallback.constData();
+    }
+    const int len = int(f.size());
+
+    const std::unique_ptr<poppler::document> doc(poppler::document::load_from_raw_data(data, len));
+    if (!doc)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Poppler не смог открыть PDF (файл повреждён?).");
+        return {};
+    }
+    if (doc->is_locked())
+    {
+        if (errorOut) *errorOut = QStringLiteral("PDF защищён паролем.");
+        return {};
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    const int pageCount = doc->pages();
+    const int lastPage = (limits.maxPages > 0) ? std::min(pageCount, limits.maxPages) : pageCount;
+
+    QString out;
+    for (int i = 0; i < lastPage; ++i)
+    {
+        if (isCanceled(limits))
+        {
+            if (errorOut) *errorOut = QStringLiteral("Извлечение PDF отменено.");
+            return {};
+        }
+        if (limits.timeoutMs > 0 && clock.elapsed() > limits.timeoutMs)
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("PDF не разобран за %1 с (остановлено на стр. %2 из %3).")
+                                .arg(limits.timeoutMs / 1000).arg(i + 1).arg(pageCount);
+            return {};
+        }
+
+        const std::unique_ptr<poppler::page> page(doc->create_page(i));
+        if (!page)
+            continue;
+
+        const poppler::byte_array utf8 = page->text(poppler::rectf(), poppler::page::physical_layout).to_utf8();
+        QString pageText = QString::fromUtf8(utf8.data(), int(utf8.size()));
+        normalizePdfText(pageText);
+
+        if (i > 0)
+            out += QLatin1Char('\n');
+        out += pageText;
+
+        // Остальное всё равно отрежет лимит вывода.
+        if (limits.maxChars > 0 && out.size() > limits.maxChars)
+            return out.trimmed();
+    }
+
+    out = out.trimmed();
+    if (lastPage < pageCount)
+        out += pageLimitNote(limits.maxPages);
+    return out;
+}
+
+#endif // CONTEXTMAKER_HAVE_POPPLER_CPP
+
+/** \brief Позиция n-го (с 1) разрыва страницы или -1. */
+int nthFormFeed(const QByteArray& bytes, int n)
+{
+    int pos = -1;
+    for (int k = 0; k < n; ++k)
+    {
+        pos = bytes.indexOf('\f', pos + 1);
+        if (pos < 0)
+            return -1;
+    }
+    return pos;
+}
+
+/** \brief После позиции есть что-то кроме пробелов и разрывов страниц. */
+bool hasTextAfter(const QByteArray& bytes, int pos)
+{
+    for (int i = pos; i < bytes.size(); ++i)
+    {
+        const char c = bytes.at(i);
+        if (c != '\f' && c != '\n' && c != '\r' && c != ' ' && c != '\t')
+            return true;
+    }
+    return false;
+}
+
+QString extractWithPdfToText(const QString& pdfPath, const PdfTextLimits& limits, QString* errorOut)
+{
+    const QString exe = findPdfToTextExe();
+    if (exe.isEmpty())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral(
+                "Не найден pdftotext.exe. "
+                "Положите Poppler в <папка_приложения>/tools/poppler/pdftotext.exe "
+                "или установите pdftotext в систему (PATH).");
+
+        return {};
+    }
+
+    QProcess proc;
+    // stderr — отдельно: предупреждения Poppler не должны попадать в текст документа.
+    proc.setProcessChannelMode(QProcess::SeparateChannels);
+    proc.setProgram(exe);
+
+    // pdftotext [options] PDF-file [text-file], text-file "-" -> stdout
+    // -enc UTF-8, -layout см. manpage
+    QStringList args { QStringLiteral("-enc"), QStringLiteral("UTF-8"), QStringLiteral("-layout") };
+
+    // На страницу больше лимита: по её началу видно, что документ длиннее.
+    if (limits.maxPages > 0)
+        args << QStringLiteral("-l") << QString::number(qint64(limits.maxPages) + 1);
+
+    args << pdfPath << QStringLiteral("-");
+    proc.setArguments(args);
+
+    proc.setWorkingDirectory(QFileInfo(exe).absolutePath());
+    proc.start();
+    if (!proc.waitForStarted())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось запустить pdftotext: %1").arg(proc.errorString());
+        return {};
+    }
+
+    auto stop = [&proc] {
+        proc.kill();
+        proc.waitForFinished(2000);
+    };
+
+    // Проверка лимита символов: после ~4 байт на символ — декодируем и считаем точно,
+    // дальше — при каждом удвоении вывода.
+    const qint64 firstCheck = (limits.maxChars > 0) ? (limits.maxChars + 1) * 4 + 4 : 0;
+    qint64 nextCheck = firstCheck;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    QByteArray outBytes;
+    QByteArray errBytes;
+    bool stoppedEarly = false;   // Процесс остановлен нами: код выхода не проверяем.
+    int pageCut = -1;            // Где обрезать по лимиту страниц.
+
+    for (;;)
+    {
+        const bool running = proc.state() != QProcess::NotRunning;
+        if (running)
+            proc.waitForReadyRead(100);
+
+        outBytes += proc.readAllStandardOutput();
+        if (errBytes.size() < 64 * 1024)
+            errBytes += proc.readAllStandardError();
+
+        if (limits.maxPages > 0)
+        {
+            const int ff = nthFormFeed(outBytes, limits.maxPages);
+            if (ff >= 0 && hasTextAfter(outBytes, ff + 1))
+            {
+                pageCut = ff;
+                stoppedEarly = true;
+                break;
+            }
+        }
+
+        if (nextCheck > 0 && outBytes.size() >= nextCheck)
+        {
+            QString t = QString::fromUtf8(outBytes);
+            normalizePdfText(t);
+            if (t.trimmed().size() > limits.maxChars)
+            {
+                stoppedEarly = true;
+                break;
+            }
+            nextCheck = qint64(outBytes.size()) * 2;
+        }
+
+        if (!running)
+            break;
+
+        if (isCanceled(limits))
+        {
+            stop();
+            if (errorOut) *errorOut = QStringLiteral("Извлечение PDF отменено.");
+            return {};
+        }
+        if (limits.timeoutMs > 0 && clock.elapsed() > limits.timeoutMs)
+        {
+            stop();
+            if (errorOut)
+                *errorOut = QStringLiteral("pdftotext не уложился в %1 с — файл пропущен.")
+                                .arg(limits.timeoutMs / 1000);
+            return {};
+        }
+    }
+
+    if (stoppedEarly && proc.state() != QProcess::NotRunning)
+        stop();
+
+    if (pageCut >= 0)
+        outBytes.truncate(pageCut);
+
+    QString t = QString::fromUtf8(outBytes);
+    normalizePdfText(t);
+
+    if (!stoppedEarly && (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0))
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("pdftotext завершился с ошибкой (exitCode=%1). Вывод: %2")
+                            .arg(proc.exitCode())
+                            .arg(QString::fromLocal8Bit(errBytes).trimmed());
+        return {};
+    }
+
+    t = t.trimmed();
+    if (pageCut >= 0)
+        t += pageLimitNote(limits.maxPages);
+    return t;
+}
+
+/** \brief Разбирать в процессе (poppler-cpp) или через pdftotext. */
+bool usePopplerCpp(int timeoutMs)
+{
+#ifdef CONTEXTMAKER_HAVE_POPPLER_CPP
+    // Таймаут внутри вызова Poppler не сработает — нужен процесс, который можно убить.
+    return timeoutMs <= 0 || findPdfToTextExe().isEmpty();
+#else
+    Q_UNUSED(timeoutMs);
+    return false;
+#endif
+}
+
+} // namespace
+
+
+QString findPdfToTextExe()
+{
+    // Поиск по диску и PATH — один раз, а не на каждый PDF.
+    static const QString exe = locatePdfToTextExe();
+    return exe;
+}
+
+const char* pdfTextBackendId(int timeoutMs)
+{
+    return usePopplerCpp(timeoutMs) ? "poppler-cpp" : "pdftotext";
+}
+
+QString extractPdfText(const QString& pdfPath, const PdfTextLimits& limits, QString* errorOut)
+{
+#ifdef CONTEXTMAKER_HAVE_POPPLER_CPP
+    if (usePopplerCpp(limits.timeoutMs))
+        return extractWithPopplerCpp(pdfPath, limits, errorOut);
+#endif
+    return extractWithPdfToText(pdfPath, limits, errorOut);
+}
@@ -0,0 +1,50 @@
+/**
+ * @file pdftext.h
+ * @brief Извлечение текста из PDF: Poppler в процессе (poppler-cpp) или внешний pdftotext.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+
+/**
+ * @brief Ограничения извлечения одного PDF.
+ */
+struct PdfTextLimits
+{
+    int maxPages = 0;        ///< Сколько первых страниц извлекать (0 = все).
+    qint64 maxChars = 0;     ///< Остановиться, как только текста больше этого (0 = без лимита).
+    int timeoutMs = 0;       ///< Время на один файл (0 = без ограничения).
+    std::atomic_bool* cancelRequested = nullptr; ///< Отмена генерации (может быть nullptr).
+};
+
+/**
+ * @brief Извлечь текст PDF.
+ * @details
+ *  - Сборка с poppler-cpp (CONTEXTMAKER_HAVE_POPPLER_CPP) и timeoutMs == 0 (или pdftotext
+ *    не найден): документ разбирается в процессе, постранично; лимиты, отмена и таймаут
+ *    проверяются только между страницами — зависший разбор одной страницы не прерывается.
+ *  - Иначе: pdftotext (-enc UTF-8 -layout) на каждый файл. Вывод читается по мере готовности;
+ *    процесс завершается, как только набрано maxChars символов или maxPages страниц,
+ *    по таймауту и по отмене.
+ *  Если страниц больше maxPages, в конец добавляется пометка об обрезке.
+ *  Разрывы страниц (\f) заменяются переводами строк, CRLF — на LF.
+ * @param errorOut Сообщение об ошибке (нет Poppler, таймаут, ошибка разбора).
+ * @return Текст (trimmed) или пустая строка при ошибке.
+ */
+QString extractPdfText(const QString& pdfPath, const PdfTextLimits& limits, QString* errorOut = nullptr);
+
+/**
+ * @brief Идентификатор бэкенда для ключа кэша: тексты poppler-cpp и pdftotext отличаются.
+ * @param timeoutMs PdfTextLimits::timeoutMs: от него зависит, какой бэкенд выбран.
+ */
+const char* pdfTextBackendId(int timeoutMs);
+
+/**
+ * @brief Путь к pdftotext (рядом с приложением, tools/poppler, poppler, PATH); пусто — не найден.
+ * @details Поиск выполняется один раз за запуск программы.
+ */
+QString findPdfToTextExe();
@@ -4,6 +4,15 @@
  */
 
 #include "reportgenerator.h"
+#include "reportwriter.h"
+#include "zipreader.h"
+#include "extractioncache.h"
+#include "reportmanifest.h"
+#include "utf8codec.h"
+#include "pdftext.h"
+#include "contenthash.h"
+#include "textsniff.h"
+#include "optionparse.h"
 
 #include <QDir>
 #include <QFile>
@@ -11,13 +20,20 @@
 #include <QtGlobal>
 #include <algorithm>
 #include <utility>
-#include <QTemporaryDir>
 #include <QXmlStreamReader>
 #include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QHash>
-#include <QMap>
-#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QQueue>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
 #include <limits>
+#include <memory>
+#include <vector>
+#include <functional>
 
 #ifdef Q_OS_WIN
 #ifndef NOMINMAX
@@ -100,15 +116,19 @@ static QString decodeOem(const QByteArray& bytes)
 #endif
 
 
-static QString makeMarkdownFence(const QString& text)
+/**
+ * @brief Утилита: максимальная длина подряд идущих ` в тексте.
+ */
+static int longestBacktickRun(const QString& text)
 {
-    // Найдём максимальную длину подряд идущих ` в тексте
     int maxRun = 0;
     int run = 0;
 
-    for (QChar ch : text)
+    const QChar* p = text.constData();
+    const QChar* const end = p + text.size();
+    for (; p != end; ++p)
     {
-        if (ch == QLatin1Char('`'))
+        if (*p == QLatin1Char('`'))
         {
             ++run;
             if (run > maxRun) maxRun = run;
@@ -118,18 +138,51 @@ static QString makeMarkdownFence(const QString& text)
             run = 0;
         }
     }
+    return maxRun;
+}
 
+static QString makeMarkdownFence(int maxRun)
+{
     // Делаем fence строго длиннее любого run в контенте (минимум 3)
     const int fenceLen = std::max(3, maxRun + 1);
     return QString(fenceLen, QLatin1Char('`'));
 }
 
 /**
- * @brief Утилита: безопасно получить имя директории по абсолютному пути.
+ * @brief Утилита: расширение по имени файла (как QFileInfo::suffix(), без обращения к диску).
+ */
+static QString entrySuffix(const QString& fileName)
+{
+    const int dot = fileName.lastIndexOf(QLatin1Char('.'));
+    return (dot < 0) ? QString() : fileName.mid(dot + 1);
+}
+
+/**
+ * @brief Утилита: упорядочить индексы файлов модели по полному пути без учёта регистра.
+ * @details Путь в свёрнутом регистре строится один раз на файл; дальше сортировка
+ *          сравнивает готовые ключи, а не сворачивает обе строки в каждом сравнении.
  */
-static QString dirNameFromPath(const QString& absPath)
+static void sortByPath(const DirModel& model, QVector<int>& files)
 {
-    return QFileInfo(absPath).fileName();
+    struct Keyed
+    {
+        QString key;
+        int index;
+    };
+    std::vector<Keyed> keyed;
+    keyed.reserve(size_t(files.size()));
+    for (int i : files)
+        keyed.push_back({ model.at(i).absPath.toCaseFolded(), i });
+
+    // При равных ключах — порядок модели: результат не зависит от реализации sort.
+    std::sort(keyed.begin(), keyed.end(), [](const Keyed& a, const Keyed& b){
+        if (a.key != b.key)
+            return a.key < b.key;
+        return a.index < b.index;
+    });
+
+    for (int i = 0; i < files.size(); ++i)
+        files[i] = keyed[size_t(i)].index;
 }
 
 ReportGenerator::ReportGenerator(const Options& opt)
@@ -146,11 +199,73 @@ ReportGenerator::ReportGenerator(const Options& opt)
 
     for (const QString& name : std::as_const(m_opt.excludeDirNames))
     {
-        const QString n = name.trimmed();
-        if (!n.isEmpty())
+        QString n = name.trimmed();
+        n.replace(QLatin1Char('\\'), QLatin1Char('/'));
+        while (n.startsWith(QStringLiteral("./")))
+            n.remove(0, 2);
+        while (n.startsWith(QLatin1Char('/')))
+            n.remove(0, 1);
+        while (n.endsWith(QLatin1Char('/')))
+            n.chop(1);
+
+        if (n.isEmpty())
+            continue;
+
+        const bool isPath = n.contains(QLatin1Char('/'));
+        const bool isGlob = n.contains(QLatin1Char('*')) || n.contains(QLatin1Char('?')) || n.contains(QLatin1Char('['));
+
+        // Обычное имя — O(1) поиск по набору.
+        if (!isPath && !isGlob)
+        {
             m_excludeSet.insert(n.toLower());  // <-- лучше сразу lower, как PowerShell (case-insensitive)
+            continue;
+        }
+
+        const QRegularExpression re(
+            QRegularExpression::anchoredPattern(QRegularExpression::wildcardToRegularExpression(n)),
+            QRegularExpression::CaseInsensitiveOption);
+
+        if (!re.isValid())
+        {
+            // Кривая маска — считаем её просто именем.
+            if (!isPath)
+                m_excludeSet.insert(n.toLower());
+            continue;
+        }
+
+        if (isPath)
+            m_excludePathGlobs.push_back(re);
+        else
+            m_excludeNameGlobs.push_back(re);
     }
 
+    m_rootAbs = QDir::cleanPath(QFileInfo(m_opt.rootPath).absoluteFilePath());
+
+    // Правила приоритета для бюджета: "маска=вес".
+    for (const QString& item : std::as_const(m_opt.priorityRules))
+    {
+        const int eq = item.lastIndexOf(QLatin1Char('='));
+        if (eq <= 0)
+            continue;
+
+        bool ok = false;
+        const int weight = item.mid(eq + 1).trimmed().toInt(&ok);
+        QString mask = item.left(eq).trimmed();
+        mask.replace(QLatin1Char('\\'), QLatin1Char('/'));
+        while (mask.startsWith(QStringLiteral("./")))
+            mask.remove(0, 2);
+        if (!ok || mask.isEmpty())
+            continue;
+
+        PriorityRule rule;
+        rule.re = QRegularExpression(
+            QRegularExpression::anchoredPattern(QRegularExpression::wildcardToRegularExpression(mask)),
+            QRegularExpression::CaseInsensitiveOption);
+        rule.isPath = mask.contains(QLatin1Char('/'));
+        rule.weight = weight;
+        if (rule.re.isValid())
+            m_priorityRules.push_back(rule);
+    }
 }
 
 
@@ -161,12 +276,54 @@ const bool onWindows = false;
 #endif
 
 
+// Бюджет отчёта (символы).
+static const qint64 kBudgetSummaryReserve = 4096;   ///< Под сводку "Не вошли в бюджет".
+static const qint64 kBlockOverheadChars = 128;      ///< Fence, заголовки BEGIN/END (кроме путей), переводы строк.
+static const qint64 kBudgetFenceChars = 32;         ///< Строки fence вокруг payload.
+static const qint64 kBudgetNoteChars = 64;          ///< Пометка об обрезке по лимиту вывода.
+static const qint64 kBudgetMinContentChars = 256;   ///< Меньше — файл не выводим вовсе, а не огрызком.
+
+
 QString ReportGenerator::generate(QString* errorOut) const
+{
+    QString out;
+    StringReportSink sink(&out);
+
+    if (!generate(sink, errorOut))
+        return {};
+
+    return out;
+}
+
+bool ReportGenerator::generateToDevice(QIODevice* device, QString* errorOut) const
+{
+    // QFile, открытый на запись поверх прошлого отчёта, уже обнулил его — сращивать нечего.
+    const QFile* file = qobject_cast<QFile*>(device);
+    if (file && !m_opt.previousReportPath.isEmpty()
+        && QFileInfo(file->fileName()) == QFileInfo(m_opt.previousReportPath))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Отчёт нельзя записывать поверх прошлого отчёта напрямую.");
+        return false;
+    }
+
+    DeviceReportSink sink(device);
+
+    const bool ok = generate(sink, errorOut);
+    if (!sink.flush())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Ошибка записи отчёта: %1").arg(sink.errorString());
+        return false;
+    }
+    return ok;
+}
+
+bool ReportGenerator::generate(ReportSink& sink, QString* errorOut) const
 {
     if (m_opt.rootPath.trimmed().isEmpty())
     {
         if (errorOut) *errorOut = QStringLiteral("Не задан корневой каталог.");
-        return {};
+        return false;
     }
 
     const QString root = QDir::cleanPath(m_opt.rootPath);
@@ -174,45 +331,105 @@ QString ReportGenerator::generate(QString* errorOut) const
     if (!QFileInfo::exists(root) || !QFileInfo(root).isDir())
     {
         if (errorOut) *errorOut = QStringLiteral("Каталог не найден: %1").arg(root);
-        return {};
+        return false;
     }
 
 
     if (isCanceled())
     {
         if (errorOut) *errorOut = QStringLiteral("Отменено пользователем.");
-        return {};
+        return false;
     }
 
 
-    QStringList lines;
-    lines << QStringLiteral("# Отчёт по каталогу: %1").arg(root);
-    lines << QStringLiteral("## 1. Дерево каталогов и файлов");
-    lines << QStringLiteral("```text");
+    if (m_opt.dependenciesOut)
+        *m_opt.dependenciesOut = ReportDependencies();
+
+    ReportProgress* const progress = m_opt.progress;
+    if (progress)
+        progress->startedMs = QDateTime::currentMSecsSinceEpoch();
+
+    // Профиль: свой объект, если раздел профиля нужен, а вызывающий объект не передал.
+    ReportProfile localProfile;
+    ReportProfile* const profile = m_opt.profile ? m_opt.profile
+                                                 : (m_opt.profileAppendix ? &localProfile : nullptr);
+    if (profile)
+        profile->start();
+    const ReportProfile::Scope generateScope(profile, QStringLiteral("generate"));
+
+    // На любом выходе отмечаем, что генерация закончилась.
+    struct FinishedMark
+    {
+        ReportProgress* p;
+        ~FinishedMark() { if (p) p->phase = ReportProgress::Finished; }
+    } finishedMark { progress };
+
+    ReportWriter w(sink);
+    w.line(QStringLiteral("# Отчёт по каталогу: %1").arg(root));
+    w.line(QStringLiteral("## 1. Дерево каталогов и файлов"));
+    w.line(QStringLiteral("```text"));
 
     // Если корневая папка сама в списке исключений — отчёт будет пустым (как в PS-скрипте).
     const QString rootName = QFileInfo(root).fileName();
-    const bool rootExcluded = m_excludeSet.contains(rootName.toLower());
+    const bool rootExcluded = isExcludedDirName(rootName);
+
 
+    // Модель каталога строится один раз: из неё рисуется дерево и берётся список файлов секции 2.
+    DirModel model;
+    const DirModel::SkipFilter skip = [this](const DirEntry& e) { return isExcludedDir(e); };
+
+    auto ensureModel = [&]() -> bool {
+        if (!model.isEmpty())
+            return true;
+        if (progress)
+            progress->phase = ReportProgress::Scanning;
+        const ReportProfile::Scope scanScope(profile, QStringLiteral("scan"));
+        if (model.build(root, skip, m_opt.cancelRequested, progress ? &progress->entriesScanned : nullptr,
+                        scanThreadCount()))
+        {
+            if (m_opt.dependenciesOut)
+            {
+                for (const DirEntry& e : model.entries())
+                {
+                    if (e.isDir)
+                        m_opt.dependenciesOut->dirs << e.absPath;
+                }
+            }
+            return true;
+        }
+        if (errorOut) *errorOut = QStringLiteral("Отменено пользователем.");
+        return false;
+    };
 
     if (!rootExcluded)
     {
         if (m_opt.useCmdTree && onWindows)
         {
             QString treeErr;
-            const QString treeOut = runCmdTree(&treeErr);
-            const QString treeOutTrim = treeOut.trimmed();
+            bool treeWritten = false;
+            bool treeOk = false;
+            {
+                const ReportProfile::Scope cmdTreeScope(profile, QStringLiteral("cmd-tree"));
+                treeOk = runCmdTree(w, &treeWritten, &treeErr);
+            }
 
-            if (!treeOutTrim.isEmpty())
+            if (treeWritten)
             {
-                lines << treeOutTrim;
+                // Часть дерева уже в отчёте — откатываться поздно, дописываем причину обрыва.
+                if (!treeOk)
+                {
+                    w.line(QStringLiteral("[ДЕРЕВО ПРЕРВАНО: %1]").arg(treeErr));
+                    if (errorOut) *errorOut = treeErr;
+                }
             }
             else
             {
                 // Фолбэк на внутренний генератор дерева.
-                QStringList treeLines;
-                showTreeRec(root, QString(), treeLines);
-                lines << treeLines;
+                if (!ensureModel())
+                    return false;
+
+                const ReportProfile::Scope treeScope(profile, QStringLiteral("tree"));
+                writeTree(model, w);
 
                 if (errorOut && !treeErr.isEmpty())
                     *errorOut = treeErr;
@@ -221,38 +438,323 @@ QString ReportGenerator::generate(QString* errorOut) const
         else
         {
             // Встроенное дерево (без внешних утилит)
-            QStringList treeLines;
-            showTreeRec(root, QString(), treeLines);
-            lines << treeLines;
+            if (!ensureModel())
+                return false;
+
+            const ReportProfile::Scope treeScope(profile, QStringLiteral("tree"));
+            writeTree(model, w);
         }
     }
 
-    lines << QStringLiteral("```");
+    w.line(QStringLiteral("```"));
 
-    // Если включён режим "только дерево" — возвращаем отчёт прямо тут
+    // Если включён режим "только дерево" — заканчиваем отчёт прямо тут
     if (m_opt.treeOnly)
-        return lines.join('\n');
+    {
+        writeProfileAppendix(w, profile);
+        return finishWrite(w, errorOut);
+    }
 
 
-    lines << QString(); // пустая строка
+    w.line(QString()); // пустая строка
 
-    lines << QStringLiteral("## 2. Содержимое файлов (отфильтровано)");
-    lines << QStringLiteral("*(выводятся только текстовые файлы из IncludeExt и не больше %1 байт)*").arg(m_opt.maxBytes);
-    lines << QString();
+    w.line(QStringLiteral("## 2. Содержимое файлов (отфильтровано)"));
+    if (m_opt.includeAnyText)
+        w.line(QStringLiteral("*(выводятся текстовые файлы любых расширений (по содержимому) и не больше %1 байт)*").arg(m_opt.maxBytes));
+    else
+        w.line(QStringLiteral("*(выводятся только текстовые файлы из IncludeExt и не больше %1 байт)*").arg(m_opt.maxBytes));
+    if (m_opt.changedOnly)
+        w.line(QStringLiteral("*(только новые и изменённые файлы относительно прошлого отчёта)*"));
+    w.line(QString());
 
     if (!rootExcluded)
     {
-        QVector<QFileInfo> files;
-        collectFilesRec(root, files);
+        // Для режима cmd tree модель ещё не строилась.
+        if (!ensureModel())
+            return false;
+
+        const qint64 selectStartUs = profile ? profile->nowUs() : 0;
+
+        QVector<int> files;
+        collectFiles(model, files);
+
+        if (m_opt.dependenciesOut)
+        {
+            m_opt.dependenciesOut->files.reserve(files.size());
+            for (int idx : std::as_const(files))
+                m_opt.dependenciesOut->files << model.at(idx).absPath;
+        }
+
+        if (progress)
+        {
+            progress->filesSelected = files.size();
+            progress->phase = ReportProgress::Contents;
+        }
 
         // Сортировка по полному пути.
-        std::sort(files.begin(), files.end(), [](const QFileInfo& a, const QFileInfo& b){
-            return a.absoluteFilePath().compare(b.absoluteFilePath(), Qt::CaseInsensitive) < 0;
-        });
+        sortByPath(model, files);
 
         const QDir rootDir(root);
 
-        for (const QFileInfo& f : std::as_const(files))
+        /**
+         * @details
+         *  Извлечение (pdftotext, распаковка DOCX/XLSX, чтение текста) идёт параллельно
+         *  в отдельном пуле, а вывод — строго в порядке отсортированного списка.
+         *  Окно ограничено (2 задачи на поток), чтобы готовые, но ещё не выведенные
+         *  результаты не копились в памяти.
+         */
+        struct Extracted
+        {
+            QString content;
+            QString error;
+            bool canceled = false;
+            int duplicateOf = -1;   ///< Индекс файла модели с тем же содержимым (текст не читался).
+            bool binary = false;    ///< Содержимое двоичное (тело файла не читалось).
+            int backtickRun = 0;    ///< longestBacktickRun(content): считается в потоке извлечения.
+        };
+
+        // Инкрементальный режим: манифест прошлого прогона и сам прошлый отчёт.
+        const QString fingerprint = blockFingerprint();
+        ReportManifest previous;
+        bool canSplice = false;
+        if (!m_opt.previousReportPath.isEmpty()
+            && previous.load(ReportManifest::pathForReport(m_opt.previousReportPath)))
+        {
+            // Для режима "только изменённые" достаточно размеров и mtime, текст блоков не нужен.
+            canSplice = !m_opt.changedOnly
+                        && previous.fingerprint() == fingerprint
+                        && previous.attachReport(m_opt.previousReportPath);
+        }
+
+        QSet<QString> seen;   // пути всех файлов секции 2 (для списка удалённых)
+
+        // Бюджет отчёта: файлы отбираются до чтения, по оценке размера блока.
+        const bool hasBudget = m_opt.reportBudgetChars > 0;
+        const qint64 budgetEnd = m_opt.reportBudgetChars - kBudgetSummaryReserve;
+        QVector<int> overBudget;
+        bool budgetCut = false;   // блок обрезан по бюджету — в манифест не попадает
+
+        if (hasBudget)
+        {
+            // Сверху: символов не больше, чем байт (UTF-8/ANSI), и не больше лимита вывода.
+            auto costOf = [&](int fileIndex) -> qint64 {
+                const DirEntry& f = model.at(fileIndex);
+                const QString rel = QDir::toNativeSeparators(rootDir.relativeFilePath(f.absPath));
+
+                const ReportManifest::Block* old = previous.find(rel);
+                const bool unchanged = old && old->size == f.size && old->mtimeMs == f.mtimeMs;
+                if (unchanged && m_opt.changedOnly)
+                    return 0;
+                if (unchanged && canSplice)
+                    return old->chars;
+
+                qint64 content = f.size;
+                if (m_opt.maxOutChars > 0)
+                    content = std::min(content, m_opt.maxOutChars + kBudgetNoteChars);
+                return content + 2 * qint64(rel.size()) + kBlockOverheadChars;
+            };
+
+            const int total = files.size();
+            files = selectWithinBudget(model, files, costOf, budgetEnd - w.charsWritten(), &overBudget);
+
+            // Не вошедшие файлы не удалены — для "только изменённых" это важно.
+            for (int idx : std::as_const(overBudget))
+                seen.insert(QDir::toNativeSeparators(rootDir.relativeFilePath(model.at(idx).absPath)));
+
+            if (progress)
+                progress->filesSelected = files.size();
+
+            w.line(QStringLiteral("*(бюджет отчёта: %1 символов; в него вошли %2 из %3 файлов)*")
+                       .arg(m_opt.reportBudgetChars).arg(files.size()).arg(total));
+            w.line(QString());
+        }
+
+        if (profile)
+            profile->addPhase(QStringLiteral("select"), selectStartUs);
+
+        const bool writeManifest = !m_opt.manifestPath.isEmpty() && !m_opt.changedOnly && w.bytePos() >= 0;
+        ReportManifest current;
+        current.setFingerprint(fingerprint);
+
+        std::unique_ptr<ExtractionCache> cache;
+        if (m_opt.useExtractionCache)
+        {
+            const ReportProfile::Scope cacheScope(profile, QStringLiteral("cache-open"));
+            cache.reset(new ExtractionCache(ExtractionCache::fileForRoot(m_rootAbs, m_opt.cacheDir)));
+            cache->open();
+        }
+        ExtractionCache* cachePtr = cache.get();
+
+        /**
+         * @details Дедупликация: хэшируются только файлы с неуникальным размером — по байтам,
+         *  которые чтение для вывода уже отобразило в память. Реестр хранит для содержимого
+         *  самый ранний по порядку вывода файл; файл, у которого в реестре есть более ранний
+         *  двойник с теми же байтами, не декодируется.
+         */
+        struct DedupKey
+        {
+            qint64 size = 0;
+            quint64 hash = 0;
+            bool operator==(const DedupKey& o) const { return size == o.size && hash == o.hash; }
+        };
+        struct DedupFirst
+        {
+            int order = 0;       // позиция в порядке вывода
+            int fileIndex = -1;
+        };
+        struct DedupRegistry
+        {
+            QMutex mutex;
+            QHash<quint64, QVector<QPair<DedupKey, DedupFirst>>> byHash;
+
+            /**
+             * @brief Зарегистрировать файл; вернуть индекс более раннего двойника или -1.
+             * @param sameContent Совпадают ли байты с файлом fileIndex: равный хэш — ещё не
+             *        равное содержимое. Сравнение идёт без блокировки реестра.
+             */
+            int add(const DedupKey& key, const DedupFirst& me, const std::function<bool(int)>& sameContent)
+            {
+                QVector<QPair<int, int>> candidates;   // (позиция в корзине, файл)
+                {
+                    QMutexLocker lock(&mutex);
+                    const auto& bucket = byHash[key.hash];
+                    for (int i = 0; i < bucket.size(); ++i)
+                    {
+                        if (bucket.at(i).first == key)
+                            candidates.push_back({ i, bucket.at(i).second.fileIndex });
+                    }
+                }
+
+                for (const auto& c : std::as_const(candidates))
+                {
+                    if (!sameContent(c.second))
+                        continue;   // коллизия хэша: другое содержимое
+
+                    // Запись могла смениться, но только на файл с тем же содержимым.
+                    QMutexLocker lock(&mutex);
+                    auto& item = byHash[key.hash][c.first];
+                    if (item.second.order < me.order)
+                        return item.second.fileIndex;
+                    item.second = me;   // более ранний файл пришёл позже (параллельное извлечение)
+                    return -1;
+                }
+
+                // Новое содержимое. Одинаковый файл, добавленный другим потоком между проверкой
+                // и этой строкой, просто не будет заменён ссылкой.
+                QMutexLocker lock(&mutex);
+                byHash[key.hash].push_back({ key, me });
+                return -1;
+            }
+        };
+
+        DedupRegistry dedup;
+        QSet<qint64> dupSizes;   // размеры, встречающиеся больше одного раза
+        if (m_opt.dedupContent)
+        {
+            QSet<qint64> sizes;
+            for (int idx : std::as_const(files))
+            {
+                const qint64 size = model.at(idx).size;
+                if (size > 0 && !sizes.contains(size))
+                    sizes.insert(size);
+                else if (size > 0)
+                    dupSizes.insert(size);
+            }
+        }
+
+        // Извлечение файла в профиль; вызывается из рабочих потоков (QDir — свой на вызов).
+        auto profileFile = [profile, &root](const DirEntry& f, ReportProfile::Extractor extractor,
+                                            const Extracted& r, qint64 startUs) {
+            ReportProfile::FileSpan span;
+            span.path = QDir::toNativeSeparators(QDir(root).relativeFilePath(f.absPath));
+            span.extractor = extractor;
+            span.bytesIn = f.size;
+            span.charsOut = r.content.size();
+            span.startUs = startUs;
+            span.durUs = profile->nowUs() - startUs;
+            span.error = !r.error.isEmpty();
+            profile->addFile(std::move(span));
+        };
+
+        auto extract = [this, &model, cachePtr, progress, profile, &profileFile, &dedup, &dupSizes](int fileIndex, int order) -> Extracted {
+            Extracted r;
+            if (isCanceled())
+            {
+                r.canceled = true;
+                return r;
+            }
+
+            const DirEntry& f = model.at(fileIndex);
+            if (progress)
+                progress->setCurrentFile(f.absPath, QDateTime::currentMSecsSinceEpoch());
+            const qint64 startUs = profile ? profile->nowUs() : 0;
+
+            // Хэшируются байты, которые readFileForReport() и так читает; совпадение хэша
+            // проверяется сравнением с файлом первого вхождения.
+            RawContentCheck checkDuplicate;
+            if (dupSizes.contains(f.size))
+            {
+                checkDuplicate = [&](const char* data, qint64 len) {
+                    const DedupKey key{ len, contentHash64(data, len) };
+                    r.duplicateOf = dedup.add(key, { order, fileIndex }, [&](int other) {
+                        return fileContentEquals(model.at(other).absPath, data, len);
+                    });
+                    return r.duplicateOf >= 0;
+                };
+            }
+
+            ReportProfile::Extractor extractor = ReportProfile::Extractor::Text;
+            r.content = readFileForReport(f, &r.error, cachePtr, &r.binary, &extractor, checkDuplicate);
+            if (r.duplicateOf >= 0)
+            {
+                r.content.clear();
+                r.error.clear();
+                if (progress)
+                    progress->bytesRead.fetch_add(f.size, std::memory_order_relaxed);
+                if (profile)
+                    profileFile(f, ReportProfile::Extractor::Duplicate, r, startUs);
+                return r;
+            }
+            r.backtickRun = longestBacktickRun(r.content);
+            if (profile)
+                profileFile(f, extractor, r, startUs);
+
+            if (progress)
+            {
+                progress->filesExtracted.fetch_add(1, std::memory_order_relaxed);
+                progress->bytesRead.fetch_add(f.size, std::memory_order_relaxed);
+            }
+            return r;
+        };
+
+        const int workers = extractionThreadCount();
+        const int window = workers * 2;
+
+        QThreadPool localPool;
+        QThreadPool* const pool = m_opt.threadPool ? m_opt.threadPool : &localPool;
+        if (!m_opt.threadPool)
+            localPool.setMaxThreadCount(workers);
+
+        /** \brief Очередной файл вывода: либо готовый блок из прошлого отчёта, либо задача извлечения. */
+        struct Pending
+        {
+            int fileIndex = -1;
+            QString rel;
+            QByteArray spliced;
+            qint64 splicedChars = 0;   ///< Символов UTF-16 в spliced (бюджет считается в символах).
+            QFuture<Extracted> future;
+        };
+
+        const qint64 contentsStartUs = profile ? profile->nowUs() : 0;
+
+        QQueue<Pending> pending;
+        QString block;           // буфер блока файла, ёмкость переиспользуется между файлами
+        QSet<int> writtenFull;   // файлы, выведенные целиком (на них можно ссылаться как на двойник)
+        int duplicates = 0;
+        int nextToSubmit = 0;
+        int inFlight = 0;
+
+        while (nextToSubmit < files.size() || !pending.isEmpty())
         {
 
             if (isCanceled())
@@ -261,104 +763,436 @@ QString ReportGenerator::generate(QString* errorOut) const
                 break; // выходим аккуратно, Markdown останется валидным
             }
 
-            const QString abs = f.absoluteFilePath();
-            QString rel = rootDir.relativeFilePath(abs);
-            rel = QDir::toNativeSeparators(rel);
+            // Приёмник больше не принимает данные (диск полон, pipe закрыт) — читать дальше бессмысленно.
+            if (!w.ok())
+                break;
+
+            // Окно ограничивает только задачи извлечения; готовые блоки ничего не стоят.
+            while (nextToSubmit < files.size() && inFlight < window)
+            {
+                Pending p;
+                p.fileIndex = files.at(nextToSubmit++);
+
+                const DirEntry& f = model.at(p.fileIndex);
+                p.rel = QDir::toNativeSeparators(rootDir.relativeFilePath(f.absPath));
+
+                const ReportManifest::Block* old = previous.find(p.rel);
+                const bool unchanged = old && old->size == f.size && old->mtimeMs == f.mtimeMs;
+                seen.insert(p.rel);
+
+                if (unchanged && m_opt.changedOnly)
+                {
+                    if (progress)
+                        progress->filesDone.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (unchanged && canSplice)
+                {
+                    p.spliced = previous.blockBytes(*old);
+                    p.splicedChars = old->chars;
+                }
+
+                if (p.spliced.isEmpty())
+                {
+                    const int idx = p.fileIndex;
+                    const int order = nextToSubmit;
+                    p.future = QtConcurrent::run(pool, [extract, idx, order]() { return extract(idx, order); });
+                    ++inFlight;
+                }
+                pending.enqueue(std::move(p));
+            }
+
+            if (pending.isEmpty())
+                break;
 
-            QString readErr;
-            QString content = readFileForReport(f, &readErr);
+            Pending p = pending.dequeue();
+            const DirEntry& f = model.at(p.fileIndex);
+            const qint64 blockBegin = w.bytePos();
+            const qint64 blockCharsBegin = w.charsWritten();
+            bool hadError = false;
 
-            QString payload;
-            payload.reserve(256 + content.size());
-            payload += QStringLiteral("----- BEGIN FILE: %1 [%2 bytes] ----\n").arg(rel).arg(f.size());
+            budgetCut = false;
+            bool isDuplicate = false;
 
-            if (!readErr.isEmpty())
-                payload += QStringLiteral("[ОШИБКА ЧТЕНИЯ: %1]\n").arg(readErr);
+            if (!p.spliced.isEmpty())
+            {
+                // Блок прошлого отчёта не режется: не помещается — файл не выводится.
+                if (hasBudget && w.charsWritten() + p.splicedChars > budgetEnd)
+                {
+                    overBudget.push_back(p.fileIndex);
+                    if (progress)
+                        progress->filesDone.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                w.rawBlock(p.rel, p.spliced);
+            }
             else
-                payload += content + QLatin1Char('\n');
+            {
+                --inFlight;
+                Extracted ex = p.future.result();
+                if (ex.canceled)
+                {
+                    if (errorOut) *errorOut = QStringLiteral("Отменено пользователем.");
+                    break;
+                }
+
+                // Двойник, на который ссылаемся, должен быть выведен целиком; иначе (ошибка чтения,
+                // не вошёл в бюджет) — читаем файл сами, это редкий случай.
+                QString duplicateNote;
+                if (ex.duplicateOf >= 0)
+                {
+                    if (writtenFull.contains(ex.duplicateOf))
+                    {
+                        duplicateNote = QStringLiteral("[ДУБЛИКАТ: содержимое совпадает с %1]").arg(
+                            QDir::toNativeSeparators(rootDir.relativeFilePath(model.at(ex.duplicateOf).absPath)));
+                        isDuplicate = true;
+                        ++duplicates;
+                    }
+                    else
+                    {
+                        const qint64 startUs = profile ? profile->nowUs() : 0;
+                        ReportProfile::Extractor extractor = ReportProfile::Extractor::Text;
+                        ex.content = readFileForReport(f, &ex.error, cachePtr, &ex.binary, &extractor);
+                        ex.backtickRun = longestBacktickRun(ex.content);
+                        if (profile)
+                            profileFile(f, extractor, ex, startUs);
+                    }
+                }
+
+                // Двоичный файл, взятый только "по содержимому", в отчёт не выводим вовсе.
+                if (ex.binary && !matchesIncludeExt(f))
+                {
+                    if (progress)
+                        progress->filesDone.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                const QString& rel = p.rel;
+                const QString& readErr = ex.error;
+                QString content = duplicateNote.isEmpty() ? std::move(ex.content) : duplicateNote;
+                int contentRun = duplicateNote.isEmpty() ? ex.backtickRun : longestBacktickRun(duplicateNote);
+                hadError = !readErr.isEmpty();
 
-            payload += QStringLiteral("----- END FILE:   %1 ----\n").arg(rel);
+                const QString head = QStringLiteral("----- BEGIN FILE: %1 [%2 bytes] ----\n").arg(rel).arg(f.size);
+                const QString tail = QStringLiteral("----- END FILE:   %1 ----\n").arg(rel);
+
+                // Оценка могла ошибиться (PDF/DOCX/XLSX без лимита вывода) — режем по остатку бюджета.
+                if (hasBudget && !hadError)
+                {
+                    const qint64 left = budgetEnd - w.charsWritten()
+                                        - head.size() - tail.size() - kBudgetFenceChars;
+                    if (content.size() > left)
+                    {
+                        if (left < kBudgetMinContentChars)
+                        {
+                            overBudget.push_back(p.fileIndex);
+                            if (progress)
+                                progress->filesDone.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        truncateWithNote(content, left, QStringLiteral("[ОБРЕЗАНО: исчерпан бюджет отчёта]"));
+                        contentRun = longestBacktickRun(content);
+                        budgetCut = true;
+                    }
+                }
+
+                // Безопасный fence: длиннее любого run в блоке. Части блока разделены не-` символами,
+                // поэтому run блока — максимум по частям; тело уже посчитано при извлечении.
+                const int run = std::max(longestBacktickRun(rel),
+                                         hadError ? longestBacktickRun(readErr) : contentRun);
+                const QString fence = makeMarkdownFence(run);
+
+                // Блок собирается в один буфер и уходит в writer одной строкой.
+                // Вывод тот же, что у строк fence+"text", payload, fence, "".
+                block.resize(0);
+                block.reserve(2 * fence.size() + head.size() + tail.size() + content.size() + readErr.size() + 64);
+                block += fence;
+                block += QLatin1String("text\n");
+                block += head;
+
+                if (hadError)
+                {
+                    block += QStringLiteral("[ОШИБКА ЧТЕНИЯ: ");
+                    block += readErr;
+                    block += QLatin1String("]\n");
+                }
+                else
+                {
+                    block += content;
+                    block += QLatin1Char('\n');
+                }
+
+                block += tail;
+                block += fence;
+                block += QLatin1Char('\n');
+
+                w.block(rel, block);
+            }
+
+            if (!hadError && !budgetCut && !isDuplicate)
+                writtenFull.insert(p.fileIndex);
+
+            // Блок с ошибкой чтения в манифест не попадает — в следующий раз файл прочитается заново.
+            // Обрезанный по бюджету — тоже: при другом бюджете он был бы другим.
+            // Ссылка на двойник — тоже: двойник к следующему разу может измениться.
+            if (writeManifest && !hadError && !budgetCut && !isDuplicate)
+            {
+                ReportManifest::Block b;
+                b.relPath = p.rel;
+                b.size = f.size;
+                b.mtimeMs = f.mtimeMs;
+                b.offset = blockBegin;
+                b.length = w.bytePos() - blockBegin;
+                b.chars = w.charsWritten() - blockCharsBegin;
+                current.add(b);
+            }
+
+            if (progress)
+                progress->filesDone.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // При отмене дожидаемся уже запущенных задач (они быстро выходят по флагу).
+        // Пул может быть общим, поэтому ждём только свои задачи, а не весь пул.
+        for (Pending& p : pending)
+            p.future.waitForFinished();
+
+        if (profile)
+            profile->addPhase(QStringLiteral("contents"), contentsStartUs);
+
+        // Ошибка записи кэша на отчёт не влияет.
+        if (cache)
+        {
+            const ReportProfile::Scope cacheScope(profile, QStringLiteral("cache-commit"));
+            cache->commit(!isCanceled() && w.ok());
+        }
+
+        const bool complete = !isCanceled() && w.ok() && nextToSubmit == files.size() && pending.isEmpty();
+
+        if (duplicates > 0 && !isCanceled())
+        {
+            w.line(QStringLiteral("*(дубликатов по содержимому: %1 — выведены ссылками на первое вхождение)*")
+                       .arg(duplicates));
+            w.line(QString());
+        }
+
+        if (hasBudget && !overBudget.isEmpty() && !isCanceled())
+        {
+            sortByPath(model, overBudget);
+
+            w.line(QStringLiteral("### Не вошли в бюджет отчёта"));
+            w.line(QStringLiteral("*(файлов: %1)*").arg(overBudget.size()));
+
+            // Список — в пределах резерва под сводку.
+            qint64 listChars = 0;
+            int listed = 0;
+            for (int idx : std::as_const(overBudget))
+            {
+                const QString item = QStringLiteral("- %1").arg(
+                    QDir::toNativeSeparators(rootDir.relativeFilePath(model.at(idx).absPath)));
+                if (listChars + item.size() + 1 > kBudgetSummaryReserve - 256)
+                    break;
+                w.line(item);
+                listChars += item.size() + 1;
+                ++listed;
+            }
+            if (listed < overBudget.size())
+                w.line(QStringLiteral("- … и ещё %1").arg(overBudget.size() - listed));
+            w.line(QString());
+        }
+
+        if (m_opt.changedOnly && complete)
+        {
+            QStringList removed;
+            for (const ReportManifest::Block& b : previous.blocks())
+            {
+                if (!seen.contains(b.relPath))
+                    removed << QStringLiteral("- %1").arg(b.relPath);
+            }
 
-            // Выбираем безопасный fence под конкретный payload
-            const QString fence = makeMarkdownFence(payload);
+            if (!removed.isEmpty())
+            {
+                w.line(QStringLiteral("### Удалённые файлы"));
+                w.lines(removed);
+                w.line(QString());
+            }
+        }
 
-            lines << (fence + QStringLiteral("text"));
-            lines << payload.trimmed();
-            lines << fence;
-            lines << QString();
+        previous.detachReport();
 
+        // Частичный отчёт манифестом не описываем — следующий прогон будет полным.
+        if (writeManifest && complete)
+        {
+            const ReportProfile::Scope manifestScope(profile, QStringLiteral("manifest"));
+            QString manifestErr;
+            if (!current.save(m_opt.manifestPath, &manifestErr) && errorOut && errorOut->isEmpty())
+                *errorOut = manifestErr;
         }
     }
 
-    return lines.join('\n');
+    writeProfileAppendix(w, profile);
+    return finishWrite(w, errorOut);
+}
+
+void ReportGenerator::writeProfileAppendix(ReportWriter& w, const ReportProfile* profile) const
+{
+    if (!profile || !m_opt.profileAppendix || isCanceled() || !w.ok())
+        return;
+
+    w.line(QString());
+    w.lines(profile->toMarkdown(m_opt.profileSlowestFiles));
+    w.line(QString());
 }
 
-/*bool ReportGenerator::isUnderExcluded(const QFileInfo& item) const
+int ReportGenerator::priorityWeight(const DirEntry& file) const
 {
-    // Берём директорию: для файла — его папка, для папки — она сама.
-    QDir dir = item.isDir() ? QDir(item.absoluteFilePath()) : item.dir();
+    if (m_priorityRules.isEmpty())
+        return 0;
 
-    while (true)
+    const int prefix = m_rootAbs.endsWith(QLatin1Char('/')) ? m_rootAbs.size() : m_rootAbs.size() + 1;
+    const QString rel = file.absPath.mid(prefix);
+
+    for (const PriorityRule& rule : m_priorityRules)
     {
-        const QString name = dirNameFromPath(dir.absolutePath()).toLower();
-        if (!name.isEmpty() && m_excludeSet.contains(name))
-            return true;
+        if (rule.re.match(rule.isPath ? rel : file.name).hasMatch())
+            return rule.weight;
+    }
+    return 0;
+}
 
-        const QString before = dir.absolutePath();
-        if (!dir.cdUp())
-            break;
+QVector<int> ReportGenerator::selectWithinBudget(const DirModel& model,
+                                                 const QVector<int>& files,
+                                                 const std::function<qint64(int)>& costOf,
+                                                 qint64 budget,
+                                                 QVector<int>* skipped) const
+{
+    struct Candidate
+    {
+        int pos = 0;        // позиция в files
+        int weight = 0;
+        qint64 cost = 0;
+    };
 
-        if (dir.absolutePath() == before)
-            break;
+    QVector<Candidate> cand;
+    cand.reserve(files.size());
+    for (int i = 0; i < files.size(); ++i)
+        cand.push_back({ i, priorityWeight(model.at(files.at(i))), costOf(files.at(i)) });
+
+    const Options::BudgetOrder order = m_opt.budgetOrder;
+    std::stable_sort(cand.begin(), cand.end(), [&](const Candidate& a, const Candidate& b) {
+        if (a.weight != b.weight)
+            return a.weight > b.weight;
+
+        const DirEntry& fa = model.at(files.at(a.pos));
+        const DirEntry& fb = model.at(files.at(b.pos));
+        if (order == Options::BudgetOrder::SmallestFirst && fa.size != fb.size)
+            return fa.size < fb.size;
+        if (order == Options::BudgetOrder::NewestFirst && fa.mtimeMs != fb.mtimeMs)
+            return fa.mtimeMs > fb.mtimeMs;
+        return a.pos < b.pos;
+    });
+
+    QVector<char> taken(files.size(), 0);
+    qint64 left = budget;
+    for (const Candidate& c : std::as_const(cand))
+    {
+        if (c.cost <= left)
+        {
+            taken[c.pos] = 1;
+            left -= c.cost;
+        }
     }
+
+    QVector<int> selected;
+    selected.reserve(files.size());
+    for (int i = 0; i < files.size(); ++i)
+    {
+        if (taken.at(i))
+            selected.push_back(files.at(i));
+        else if (skipped)
+            skipped->push_back(files.at(i));
+    }
+    return selected;
+}
+
+bool ReportGenerator::finishWrite(ReportWriter& w, QString* errorOut) const
+{
+    if (w.ok() && w.sink().flush())
+        return true;
+
+    if (errorOut)
+        *errorOut = QStringLiteral("Ошибка записи отчёта: %1").arg(w.sink().errorString());
     return false;
-}*/
-bool ReportGenerator::isUnderExcluded(const QFileInfo& item) const
+}
+
+
+bool ReportGenerator::isExcludedDirName(const QString& name) const
 {
-    const QString rootAbs = QDir::cleanPath(QFileInfo(m_opt.rootPath).absoluteFilePath());
+    if (name.isEmpty())
+        return false;
 
-    QDir dir = item.isDir() ? QDir(item.absoluteFilePath()) : item.dir();
+    if (m_excludeSet.contains(name.toLower()))
+        return true;
 
-    while (true)
+    for (const QRegularExpression& re : m_excludeNameGlobs)
     {
-        const QString curAbs = QDir::cleanPath(dir.absolutePath());
-        const QString name = dirNameFromPath(curAbs).toLower();
-
-        if (!name.isEmpty() && m_excludeSet.contains(name))
+        if (re.match(name).hasMatch())
             return true;
+    }
+    return false;
+}
 
-        ///** \brief Не поднимаемся выше выбранного root. */
-        if (curAbs.compare(rootAbs, Qt::CaseInsensitive) == 0)
-            break;
+bool ReportGenerator::isExcludedDir(const DirEntry& item) const
+{
+    // Файлы сами по себе не исключаются: если мы до них дошли, их папка уже прошла проверку.
+    if (!item.isDir)
+        return false;
 
-        const QString before = curAbs;
-        if (!dir.cdUp())
-            break;
+    if (isExcludedDirName(item.name))
+        return true;
 
-        if (QDir::cleanPath(dir.absolutePath()) == before)
-            break;
-    }
+    if (m_excludePathGlobs.isEmpty())
+        return false;
 
+    // Относительный путь от корня (с '/'), строим только если есть маски путей.
+    const int prefix = m_rootAbs.endsWith(QLatin1Char('/')) ? m_rootAbs.size() : m_rootAbs.size() + 1;
+    const QString rel = item.absPath.mid(prefix);
+
+    for (const QRegularExpression& re : m_excludePathGlobs)
+    {
+        if (re.match(rel).hasMatch())
+            return true;
+    }
     return false;
 }
 
 
-bool ReportGenerator::shouldIncludeFile(const QFileInfo& file) const
+bool ReportGenerator::shouldIncludeFile(const DirEntry& file) const
 {
-    if (!file.isFile())
+    if (!file.isFile)
         return false;
 
     // Максимальный размер.
-    if (file.size() > m_opt.maxBytes)
+    if (file.size > m_opt.maxBytes)
         return false;
 
+    // Любой текст: содержимое проверяется при чтении.
+    if (m_opt.includeAnyText)
+        return true;
+
+    return matchesIncludeExt(file);
+}
+
+bool ReportGenerator::matchesIncludeExt(const DirEntry& file) const
+{
     // Расширение (как в PowerShell FileInfo.Extension: только последняя часть).
-    const QString suffix = file.suffix();
+    const QString suffix = entrySuffix(file.name);
     const QString ext = suffix.isEmpty() ? QString() : QStringLiteral(".%1").arg(suffix);
     return m_includeSet.contains(ext.toLower());
 }
 
-QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) const
+QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut, qint64 maxChars,
+                                       bool* binaryOut, const RawContentCheck& beforeDecode) const
 {
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly))
@@ -367,17 +1201,71 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
         return {};
     }
 
-    const QByteArray bytes = f.readAll();
-    if (bytes.isEmpty())
+    // Файл отображается в память (без копии в QByteArray); не вышло — читаем как раньше.
+    // Отображение снимается при закрытии QFile.
+    QByteArray readBuf;
+    const char* data = nullptr;
+    qint64 len = f.size();
+
+    const uchar* mapped = (len > 0) ? f.map(0, len) : nullptr;
+    if (mapped)
+    {
+        data = reinterpret_cast<const char*>(mapped);
+    }
+    else
+    {
+        // Сначала только начало: двоичный файл дальше него не читаем.
+        if (binaryOut)
+        {
+            readBuf = f.read(kTextSniffBytes);
+            if (looksBinary(readBuf.constData(), readBuf.size()))
+            {
+                *binaryOut = true;
+                return QString();
+            }
+        }
+        readBuf += f.readAll();
+        data = readBuf.constData();
+        len = readBuf.size();
+    }
+
+    if (len <= 0)
+        return QString();
+
+    // С отображением затронуты только первые страницы файла
+    // (без отображения начало уже проверено выше).
+    if (binaryOut && mapped && looksBinary(data, len))
+    {
+        *binaryOut = true;
+        return QString();
+    }
+
+    // Байты всего файла уже в памяти — дедупликация хэширует их здесь, до декодирования.
+    if (beforeDecode && beforeDecode(data, len))
         return QString();
 
+    /**
+     * @details
+     *  Из файла нужно не больше maxChars + 1 символов: дальше всё равно обрежет
+     *  truncateWithNote(), ей достаточно знать, что лимит превышен. В любой из
+     *  кодировок символ (единица UTF-16) занимает не больше 4 байт, поэтому
+     *  декодируется только этот префикс (+4 байта на разрезанный символ в конце —
+     *  он лежит за лимитом и в вывод не попадает).
+     */
+    const qint64 budget = (maxChars > 0 && maxChars < len) ? qMin(len, (maxChars + 1) * 4 + 4) : len;
+
+    // Префикс полезных данных после BOM длиной skip (без копирования).
+    auto head = [&](int skip) -> QByteArray {
+        return QByteArray::fromRawData(data + skip, (int)(budget - skip));
+    };
+
     // --- BOM detection ---
     auto startsWith = [&](std::initializer_list<unsigned char> sig) -> bool {
-        if (bytes.size() < (int)sig.size()) return false;
+        if (len < (qint64)sig.size()) return false;
         int i = 0;
         for (unsigned char b : sig)
         {
-            if ((unsigned char)bytes.at(i) != b) return false;
+            if ((unsigned char)data[i] != b) return false;
             ++i;
         }
         return true;
@@ -385,12 +1273,12 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
 
     // UTF-8 BOM
     if (startsWith({0xEF, 0xBB, 0xBF}))
-        return QString::fromUtf8(bytes.constData() + 3, bytes.size() - 3);
+        return QString::fromUtf8(data + 3, (int)(budget - 3));
 
     // UTF-32 LE BOM: FF FE 00 00
     if (startsWith({0xFF, 0xFE, 0x00, 0x00}))
     {
-        const QByteArray payload = bytes.mid(4);
+        const QByteArray payload = head(4);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         QVector<char32_t> cps;
@@ -430,7 +1318,7 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
     // UTF-32 BE BOM: 00 00 FE FF
     if (startsWith({0x00, 0x00, 0xFE, 0xFF}))
     {
-        const QByteArray payload = bytes.mid(4);
+        const QByteArray payload = head(4);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         QVector<char32_t> cps;
@@ -471,7 +1359,7 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
     // UTF-16 LE BOM: FF FE
     if (startsWith({0xFF, 0xFE}))
     {
-        const QByteArray payload = bytes.mid(2);
+        const QByteArray payload = head(2);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         QVector<char16_t> u16;
@@ -508,7 +1396,7 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
     // UTF-16 BE BOM: FE FF
     if (startsWith({0xFE, 0xFF}))
     {
-        const QByteArray payload = bytes.mid(2);
+        const QByteArray payload = head(2);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         QVector<char16_t> u16;
@@ -543,70 +1431,244 @@ QString ReportGenerator::readTextSmart(const QString& path, QString* errorOut) c
 
     // --- Режим "принудительно ANSI" применяется только если BOM не найден ---
     if (m_opt.noBomEncodingMode == Options::NoBomEncodingMode::ForceAnsi)
-        return QString::fromLocal8Bit(bytes);
+        return QString::fromLocal8Bit(data, (int)budget);
+
+    // --- UTF-8 без BOM (строго): проверка и декодирование за один проход ---
+    // Выбор кодировки по-прежнему зависит от всего файла: хвост за префиксом только проверяется.
+    // Префикс режем по началу символа, чтобы не разрезать последовательность.
+    qint64 cut = budget;
+    while (cut < len && cut > budget - 3 && (static_cast<unsigned char>(data[cut]) & 0xC0) == 0x80)
+        --cut;
 
-    // --- UTF-8 без BOM (строго) ---
-    if (isValidUtf8(bytes))
-        return QString::fromUtf8(bytes);
+    QString utf8Text;
+    if (utf8IsValid(data + cut, len - cut) && utf8DecodeStrict(data, cut, &utf8Text))
+        return utf8Text;
 
     // --- Фолбэк: системная ANSI ---
-    return QString::fromLocal8Bit(bytes);
+    return QString::fromLocal8Bit(data, (int)budget);
 }
 
-void ReportGenerator::showTreeRec(const QString& path, const QString& indent, QStringList& outLines) const
+/** \brief Итоги по скрытой части дерева (для строки-сводки). */
+struct TreeStats
 {
+    qint64 files = 0;
+    qint64 dirs = 0;
+    qint64 bytes = 0;
 
-    if (isCanceled())
-        return;
+    void addEntry(const DirEntry& e, const TreeStats& subtree)
+    {
+        if (e.isDir)
+            ++dirs;
+        else if (e.isFile)
+            ++files;
+        bytes += e.size;
+
+        files += subtree.files;
+        dirs += subtree.dirs;
+        bytes += subtree.bytes;
+    }
+};
+
+/** \brief "… ещё файлов: 48213, папок: 3 (1.2 GB)". */
+static QString treeSummary(const TreeStats& s)
+{
+    QStringList parts;
+    if (s.files > 0)
+        parts << QStringLiteral("файлов: %1").arg(s.files);
+    if (s.dirs > 0)
+        parts << QStringLiteral("папок: %1").arg(s.dirs);
+
+    QString out = QStringLiteral("… ещё ") + parts.join(QStringLiteral(", "));
+    if (s.bytes > 0)
+        out += QStringLiteral(" (%1)").arg(formatHumanSize(s.bytes));
+    return out;
+}
+
+void ReportGenerator::writeTree(const DirModel& model, ReportWriter& w) const
+{
+    static const int kChunkChars = 64 * 1024;
+
+    const bool ascii = (m_opt.treeStyle == TreeStyle::Ascii);
 
-    QDir dir(path);
+    const QString branchMid = ascii ? QStringLiteral("+---") : QStringLiteral("├── ");
+    const QString branchLast = ascii ? QStringLiteral("\\---") : QStringLiteral("└── ");
+    const QString indentMid = ascii ? QStringLiteral("|   ") : QStringLiteral("│   ");
+    const QString indentLast = QStringLiteral("    ");
 
-    QFileInfoList items = dir.entryInfoList(
-        QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
-        QDir::NoSort
-    );
+    const int maxDepth = m_opt.treeMaxDepth;
+    const int maxEntries = m_opt.treeMaxEntriesPerDir;
 
-    // Фильтрация по исключаемым папкам (на любом уровне).
-    QFileInfoList filtered;
-    filtered.reserve(items.size());
-    for (const QFileInfo& it : std::as_const(items))
+    // Для лимитов — итоги по поддеревьям, для фильтра — видимость. Один проход с конца:
+    // дети в модели всегда лежат после родителя, поэтому к родителю они приходят готовыми.
+    QVector<TreeStats> stats;
+    QVector<char> visible;
+    if (maxDepth > 0 || maxEntries > 0 || m_opt.treeOnlyIncludedDirs)
     {
-        if (isUnderExcluded(it))
-            continue;
+        const int n = model.size();
+        stats.resize(n);
+        visible.fill(m_opt.treeOnlyIncludedDirs ? 0 : 1, n);
 
-        filtered.push_back(it);
+        for (int i = n - 1; i > 0; --i)
+        {
+            const DirEntry& e = model.at(i);
+            if (m_opt.treeOnlyIncludedDirs && e.isFile && shouldIncludeFile(e))
+                visible[i] = 1;
+            if (!visible.at(i))
+                continue;
+
+            visible[e.parent] = 1;
+            stats[e.parent].addEntry(e, stats.at(i));
+        }
     }
 
-    // Сортировка: папки первыми, затем по имени.
-    std::sort(filtered.begin(), filtered.end(), [](const QFileInfo& a, const QFileInfo& b){
-        if (a.isDir() != b.isDir())
-            return a.isDir() > b.isDir();
-        return a.fileName().compare(b.fileName(), Qt::CaseInsensitive) < 0;
-    });
+    auto isVisible = [&visible](int i) { return visible.isEmpty() || visible.at(i); };
+
+    // Исключения и сортировка (папки первыми, затем по имени) уже применены при построении модели.
+    // Стиль tree /F /A выводит сначала файлы, потом папки: обходим детей со сдвигом на число папок.
+    struct Frame
+    {
+        int first;      ///< Первый ребёнок папки в модели.
+        int count;      ///< Сколько детей.
+        int rot;        ///< Сдвиг порядка обхода (0 или число папок среди детей).
+        int next;       ///< Позиция следующего видимого ребёнка (или count).
+        int shown;      ///< Сколько детей уже выведено.
+        bool hasDirs;   ///< Есть видимые подпапки (для стиля ASCII).
+    };
+    auto childAt = [](const Frame& f, int pos) { return f.first + (f.rot + pos) % f.count; };
+    auto seekVisible = [&](const Frame& f, int pos) {
+        while (pos < f.count && !isVisible(childAt(f, pos)))
+            ++pos;
+        return pos;
+    };
+    auto makeFrame = [&](const DirEntry& dir) {
+        Frame f { dir.firstChild, dir.childCount, 0, 0, 0, false };
+        if (ascii)
+        {
+            int dirs = 0;
+            while (dirs < f.count && model.at(f.first + dirs).isDir)
+            {
+                f.hasDirs = f.hasDirs || isVisible(f.first + dirs);
+                ++dirs;
+            }
+            f.rot = (dirs < f.count) ? dirs : 0;
+        }
+        f.next = seekVisible(f, 0);
+        return f;
+    };
+    QVector<Frame> stack;
+    QString prefix;   // отступы текущего уровня: по 4 символа на каждую папку стека, кроме корня
+
+    QString chunk;
+    chunk.reserve(kChunkChars + 1024);
+
+    auto emitLine = [&](const QString& branch, const QString& text) {
+        if (!chunk.isEmpty())
+            chunk += QLatin1Char('\n');
+        chunk += prefix;
+        chunk += branch;
+        chunk += text;
+    };
 
-    for (int i = 0; i < filtered.size(); ++i)
+    const DirEntry& root = model.at(0);
+    if (root.childCount > 0)
+        stack.push_back(makeFrame(root));
+
+    while (!stack.isEmpty())
     {
         if (isCanceled())
-            return;
+            break;
 
-        const QFileInfo item = filtered.at(i);
-        const bool isLast = (i == filtered.size() - 1);
+        Frame& top = stack.last();
+        if (top.next == top.count)
+        {
+            stack.removeLast();
+            prefix.chop(indentMid.size());
+            continue;
+        }
+
+        // Лимит элементов папки: остаток — одной строкой, сам остаток не выводим.
+        if (maxEntries > 0 && top.shown == maxEntries)
+        {
+            TreeStats rest;
+            for (int pos = top.next; pos < top.count; ++pos)
+            {
+                const int j = childAt(top, pos);
+                if (isVisible(j))
+                    rest.addEntry(model.at(j), stats.at(j));
+            }
+            emitLine(branchLast, treeSummary(rest));
+            top.next = top.count;
+            continue;
+        }
+
+        const int childIndex = childAt(top, top.next);
+        top.next = seekVisible(top, top.next + 1);
+        ++top.shown;
+
+        const DirEntry& item = model.at(childIndex);
+        const bool isLast = (top.next == top.count);
+        const int depth = stack.size();
 
-        const QString branch = isLast ? QStringLiteral("└── ") : QStringLiteral("├── ");
-        outLines << indent + branch + item.fileName();
+        if (ascii && !item.isDir)
+        {
+            // Файлы идут без ветки, под ними — отбивка; '|' продолжает линию к подпапкам.
+            emitLine(top.hasDirs ? indentMid : indentLast, item.name);
+            if (isLast || model.at(childAt(top, top.next)).isDir)
+            {
+                QString gap = prefix + (top.hasDirs ? QStringLiteral("|") : QString());
+                while (!gap.isEmpty() && gap.back() == QLatin1Char(' '))
+                    gap.chop(1);
+                if (!gap.isEmpty())
+                {
+                    chunk += QLatin1Char('\n');
+                    chunk += gap;
+                }
+            }
+        }
+        else
+        {
+            emitLine(isLast ? branchLast : branchMid, item.name);
+        }
 
         // Важно: чтобы не словить циклы, в симлинки не уходим.
-        if (item.isDir() && !item.isSymLink())
+        if (item.isDir && !item.isSymLink && item.childCount > 0)
+        {
+            const Frame child = makeFrame(item);
+            if (child.next < child.count)
+            {
+                prefix += isLast ? indentLast : indentMid;
+                if (maxDepth > 0 && depth >= maxDepth)
+                {
+                    emitLine(branchLast, treeSummary(stats.at(childIndex)));
+                    prefix.chop(indentMid.size());
+                }
+                else
+                {
+                    stack.push_back(child);
+                }
+            }
+        }
+
+        // Кусок заканчивается на границе строки: w.line() сам поставит '\n' перед следующим.
+        if (chunk.size() >= kChunkChars)
         {
-            const QString nextIndent = indent + (isLast ? QStringLiteral("    ") : QStringLiteral("│   "));
-            showTreeRec(item.absoluteFilePath(), nextIndent, outLines);
+            w.line(chunk);
+            chunk.resize(0);
         }
     }
+
+    if (!chunk.isEmpty())
+        w.line(chunk);
 }
 
-QString ReportGenerator::runCmdTree(QString* errorOut) const
+bool ReportGenerator::runCmdTree(ReportWriter& w, bool* wroteOut, QString* errorOut) const
 {
+    *wroteOut = false;
+
 #ifdef Q_OS_WIN
+    /** \brief Столько символов вывода придерживаем: сообщение об ошибке tree короче. */
+    static const int kHoldChars = 4096;
+
     QProcess proc;
     proc.setProcessChannelMode(QProcess::MergedChannels);
 
@@ -618,224 +1680,175 @@ QString ReportGenerator::runCmdTree(QString* errorOut) const
      *  КРИТИЧНО: используем setNativeArguments(), чтобы Qt не экранировал двойные кавычки как \".
      *  Иначе cmd получает \"C:\...\" и tree видит путь \C:\... (Invalid path).
      */
-    // const QString cmdLine =
-    //     QStringLiteral("/c chcp 65001>nul & tree \"%1\" /F /A").arg(rootNative);
     const QString cmdLine =
         QStringLiteral("/c tree \"%1\" /F /A").arg(rootNative);
 
-
     proc.setNativeArguments(cmdLine);
     proc.start(QStringLiteral("cmd.exe"));
 
     if (!proc.waitForStarted())
     {
         if (errorOut) *errorOut = QStringLiteral("Не удалось запустить cmd.exe для выполнения tree.");
-        return {};
+        return false;
     }
 
-    proc.waitForFinished(-1);
+    QByteArray raw;        // хвост без '\n' ждёт следующего куска
+    QStringList held;      // первые строки, пока не ясно, дерево ли это
+    int heldChars = 0;
+    int blankLines = 0;    // пустые строки между непустыми (хвостовые не выводятся)
+    bool seenText = false;
 
-    // const QByteArray outBytes = proc.readAll();
-    // const QString outText = QString::fromUtf8(outBytes);
+    auto emitLine = [&](const QString& line) {
+        if (!*wroteOut)
+        {
+            held << line;
+            heldChars += line.size() + 1;
+            if (heldChars < kHoldChars)
+                return;
+            w.lines(held);
+            held.clear();
+            *wroteOut = true;
+            return;
+        }
+        w.line(line);
+    };
 
-    const QByteArray outBytes = proc.readAll();
+    // OEM-кодировки tree однобайтовые или DBCS — режем только по '\n', символ не разорвётся.
+    auto drain = [&](bool final) {
+        const int cut = final ? raw.size() : raw.lastIndexOf('\n') + 1;
+        if (cut <= 0)
+            return;
+        const QString text = decodeOem(raw.left(cut));
+        raw.remove(0, cut);
 
-    QString outText;
-#ifdef Q_OS_WIN
-    outText = decodeOem(outBytes);
-#else
-    outText = QString::fromUtf8(outBytes);
-#endif
+        QStringList lines = text.split(QLatin1Char('\n'));
+        if (!final || text.endsWith(QLatin1Char('\n')))
+            lines.removeLast();
 
+        for (QString& line : lines)
+        {
+            if (line.endsWith(QLatin1Char('\r')))
+                line.chop(1);
+            if (line.trimmed().isEmpty())
+            {
+                if (seenText)
+                    ++blankLines;
+                continue;
+            }
+            for (; blankLines > 0; --blankLines)
+                emitLine(QString());
+            emitLine(line);
+            seenText = true;
+        }
+    };
 
+    QElapsedTimer clock;
+    clock.start();
+    QString failure;
 
+    while (proc.state() != QProcess::NotRunning)
+    {
+        if (isCanceled())
+        {
+            failure = QStringLiteral("Отменено пользователем.");
+            break;
+        }
+        if (m_opt.cmdTreeTimeoutMs > 0 && clock.elapsed() > m_opt.cmdTreeTimeoutMs)
+        {
+            failure = QStringLiteral("Команда tree не завершилась за %1 с.").arg(m_opt.cmdTreeTimeoutMs / 1000);
+            break;
+        }
+
+        proc.waitForReadyRead(100);
+        raw += proc.readAll();
+        drain(false);
+    }
+
+    if (!failure.isEmpty())
+    {
+        proc.kill();
+        proc.waitForFinished(1000);
+        if (errorOut) *errorOut = failure;
+        return false;
+    }
+
+    raw += proc.readAll();
+    drain(true);
 
     if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)
     {
         if (errorOut)
             *errorOut = QStringLiteral("Команда tree завершилась с ошибкой (exitCode=%1). Вывод: %2")
                             .arg(proc.exitCode())
-                            .arg(outText.trimmed());
-        return {};
+                            .arg(held.join(QLatin1Char('\n')).trimmed());
+        return false;
     }
 
-    if (outText.trimmed().isEmpty())
+    if (!*wroteOut && held.isEmpty())
     {
         if (errorOut) *errorOut = QStringLiteral("Команда tree не вернула полезного вывода.");
-        return {};
+        return false;
     }
 
-    return outText;
+    if (!held.isEmpty())
+    {
+        w.lines(held);
+        *wroteOut = true;
+    }
+    return true;
 #else
+    Q_UNUSED(w);
     if (errorOut) *errorOut = QStringLiteral("useCmdTree доступен только в Windows.");
-    return {};
+    return false;
 #endif
 }
 
 
-void ReportGenerator::collectFilesRec(const QString& dirPath, QVector<QFileInfo>& outFiles) const
+void ReportGenerator::collectFiles(const DirModel& model, QVector<int>& outFiles) const
 {
-    if (isCanceled())
-        return;
-
-    QDir dir(dirPath);
-
-    QFileInfoList entries = dir.entryInfoList(
-        QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
-        QDir::NoSort
-    );
-
     // Сортировка не нужна на этом этапе — отсортируем общий список в generate().
-    for (const QFileInfo& it : std::as_const(entries))
+    const QVector<DirEntry>& entries = model.entries();
+    for (int i = 0; i < entries.size(); ++i)
     {
-        if (isCanceled())
-            return;
-        // Пропуск: всё, что находится под исключаемыми папками.
-        if (isUnderExcluded(it))
-            continue;
+        const DirEntry& it = entries.at(i);
 
         // Пропуск reparse point / symlink (как -Attributes !ReparsePoint в PS).
-        if (it.isSymLink())
-            continue;
-
-        if (it.isDir())
-        {
-            collectFilesRec(it.absoluteFilePath(), outFiles);
-        }
-        else if (it.isFile())
-        {
-            if (shouldIncludeFile(it))
-                outFiles.push_back(it);
-        }
-    }
-}
-
-bool ReportGenerator::isValidUtf8(const QByteArray& data)
-{
-    const auto u8 = reinterpret_cast<const unsigned char*>(data.constData());
-    const int len = data.size();
-
-    int i = 0;
-    while (i < len)
-    {
-        unsigned char c = u8[i];
-
-        // 1-byte ASCII
-        if (c <= 0x7F)
-        {
-            ++i;
-            continue;
-        }
-
-        int n = 0;      // length of sequence
-        uint cp = 0;    // code point
-
-        if ((c & 0xE0) == 0xC0) { n = 2; cp = c & 0x1F; }
-        else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; }
-        else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; }
-        else return false;
-
-        if (i + n > len)
-            return false;
-
-        for (int k = 1; k < n; ++k)
-        {
-            unsigned char cc = u8[i + k];
-            if ((cc & 0xC0) != 0x80)
-                return false;
-            cp = (cp << 6) | (cc & 0x3F);
-        }
-
-        // Проверка на overlong encoding
-        if (n == 2 && cp < 0x80) return false;
-        if (n == 3 && cp < 0x800) return false;
-        if (n == 4 && cp < 0x10000) return false;
-
-        // Запрет surrogate range
-        if (cp >= 0xD800 && cp <= 0xDFFF) return false;
-
-        // Максимум Unicode
-        if (cp > 0x10FFFF) return false;
+        // В папки-симлинки модель не заходит, поэтому их содержимого здесь нет.
+        if (it.isSymLink)
+            continue;
 
-        i += n;
+        if (it.isFile && shouldIncludeFile(it))
+            outFiles.push_back(i);
     }
-    return true;
 }
 
-/**
- * @brief Экранирует строку для вставки в PowerShell-строку в одинарных кавычках.
- * @details В PowerShell одинарная кавычка экранируется удвоением: ' -> ''.
- */
-static QString psEscapeSingleQuoted(QString s)
+bool ReportGenerator::isValidUtf8(const QByteArray& data)
 {
-    return s.replace('\'', "''");
+    return utf8IsValid(data.constData(), data.size());
 }
 
 QString ReportGenerator::readDocxText(const QString& docxPath, QString* errorOut) const
 {
-#ifdef Q_OS_WIN
-    QTemporaryDir tmp;
-    if (!tmp.isValid())
-    {
-        if (errorOut) *errorOut = QStringLiteral("Не удалось создать временную папку для распаковки DOCX.");
-        return {};
-    }
-
-    // 1) DOCX = ZIP, но Expand-Archive в PS5 часто требует расширение .zip
-    const QString zipPath = QDir(tmp.path()).filePath(QStringLiteral("docx.zip"));
-    QFile::remove(zipPath);
-    if (!QFile::copy(docxPath, zipPath))
-    {
-        if (errorOut) *errorOut = QStringLiteral("Не удалось скопировать DOCX во временный ZIP для распаковки.");
-        return {};
-    }
-
-    const QString srcZip = psEscapeSingleQuoted(QDir::toNativeSeparators(zipPath));
-    const QString dst    = psEscapeSingleQuoted(QDir::toNativeSeparators(tmp.path()));
-
-    /**
-     * @details
-     *  Устанавливаем UTF-8 для вывода, чтобы ошибки читались нормально.
-     *  (Иначе на русской Windows часто будет OEM-кодировка и “кракозябры”.)
-     */
-    const QString cmd = QStringLiteral(
-                            "$ErrorActionPreference='Stop';"
-                            "$OutputEncoding=[Console]::OutputEncoding=[System.Text.Encoding]::UTF8;"
-                            "Expand-Archive -LiteralPath '%1' -DestinationPath '%2' -Force"
-                            ).arg(srcZip, dst);
-
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(QStringLiteral("powershell.exe"),
-               QStringList()
-                   << QStringLiteral("-NoProfile")
-                   << QStringLiteral("-NonInteractive")
-                   << QStringLiteral("-ExecutionPolicy") << QStringLiteral("Bypass")
-                   << QStringLiteral("-Command") << cmd);
-
-    proc.waitForFinished(-1);
-
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)
+    // 1) DOCX = ZIP: читаем центральный каталог прямо из файла, без распаковки на диск.
+    ZipReader zip(docxPath);
+    QString zipErr;
+    if (!zip.open(&zipErr))
     {
-        const QByteArray bytes = proc.readAll();
-        const QString psOut = QString::fromUtf8(bytes);
-        if (errorOut)
-            *errorOut = QStringLiteral("Ошибка извлечения DOCX. %1").arg(psOut.trimmed());
+        if (errorOut) *errorOut = QStringLiteral("Ошибка извлечения DOCX. %1").arg(zipErr);
         return {};
     }
 
-    // 2) Читаем word/document.xml
-    const QString xmlPath = QDir(tmp.path()).filePath(QStringLiteral("word/document.xml"));
-    QFile xmlFile(xmlPath);
-    if (!xmlFile.open(QIODevice::ReadOnly))
+    // 2) Распаковываем только word/document.xml
+    const QByteArray xmlData = zip.read(QStringLiteral("word/document.xml"), &zipErr);
+    if (!zipErr.isEmpty())
     {
         if (errorOut)
-            *errorOut = QStringLiteral("Не найден word/document.xml внутри DOCX или нет доступа: %1").arg(xmlFile.errorString());
+            *errorOut = QStringLiteral("Не найден word/document.xml внутри DOCX или он повреждён: %1").arg(zipErr);
         return {};
     }
 
     // 3) Парсим WordprocessingML и вытаскиваем текст
-    QXmlStreamReader xml(&xmlFile);
+    QXmlStreamReader xml(xmlData);
     QString out;
     out.reserve(4096);
 
@@ -874,66 +1887,158 @@ QString ReportGenerator::readDocxText(const QString& docxPath, QString* errorOut
     }
 
     return out.trimmed();
-#else
-    if (errorOut)
-        *errorOut = QStringLiteral("Извлечение текста из .docx сейчас реализовано только для Windows.");
-    return {};
-#endif
 }
 
-QString ReportGenerator::readFileForReport(const QFileInfo& file, QString* errorOut) const
+// Версии экстракторов для ключа кэша: увеличивать при любом изменении извлекаемого текста.
+static const char kPdfExtractor[] = "pdf/2";
+static const char kDocxExtractor[] = "docx/1";
+static const char kXlsxExtractor[] = "xlsx/2";
+
+/**
+ * @brief Извлечь текст документа через кэш: при совпадении ключа экстрактор не запускается.
+ * @param param Параметр экстрактора, влияющий на результат (входит в ключ).
+ * @param hitOut (опционально) текст взят из кэша.
+ */
+static QString extractCached(ExtractionCache* cache,
+                             const DirEntry& file,
+                             const QString& extractor,
+                             qint64 param,
+                             const std::function<QString(QString*)>& extract,
+                             QString* errorOut,
+                             bool* hitOut = nullptr)
+{
+    ExtractionCache::Key key;
+    if (cache)
+    {
+        key.absPath = file.absPath;
+        key.size = file.size;
+        key.mtimeMs = file.mtimeMs;
+        key.extractor = extractor;
+        key.param = param;
+
+        QString cached;
+        if (cache->lookup(key, &cached))
+        {
+            if (hitOut) *hitOut = true;
+            return cached;
+        }
+    }
+
+    QString err;
+    QString text = extract(&err);
+    if (!err.isEmpty())
+    {
+        if (errorOut) *errorOut = err;
+        return {};
+    }
+
+    if (cache)
+        cache->store(key, text);
+    return text;
+}
+
+/** \brief Вызвать check для байт файла (отображение в память, иначе чтение целиком); false — не прочитан. */
+static bool checkRawFileContent(const QString& path, const std::function<bool(const char*, qint64)>& check)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 len = f.size();
+    if (const uchar* mapped = (len > 0) ? f.map(0, len) : nullptr)
+        return check(reinterpret_cast<const char*>(mapped), len);   // отображение снимет ~QFile
+
+    const QByteArray bytes = f.readAll();
+    return check(bytes.constData(), bytes.size());
+}
+
+QString ReportGenerator::readFileForReport(const DirEntry& file, QString* errorOut, ExtractionCache* cache,
+                                          bool* binaryOut, ReportProfile::Extractor* extractorOut,
+                                          const RawContentCheck& beforeDecode) const
 {
-    const QString suf = file.suffix().toLower();
-    const QString ext = suf.isEmpty() ? QString() : QStringLiteral(".%1").arg(suf);
+    const QString suf = entrySuffix(file.name).toLower();
+    // Взятый только по содержимому (includeAnyText) файл документом не считаем.
+    const QString ext = (suf.isEmpty() || !matchesIncludeExt(file)) ? QString() : QStringLiteral(".%1").arg(suf);
+
+    // Документ разбирается из файла заново — проверка по его байтам идёт до разбора.
+    const bool isDocument = ext == QStringLiteral(".docx") || ext == QStringLiteral(".pdf")
+                            || ext == QStringLiteral(".xlsx") || ext == QStringLiteral(".xlsm");
+    if (isDocument && beforeDecode && checkRawFileContent(file.absPath, beforeDecode))
+        return {};
 
     QString text;
+    ReportProfile::Extractor extractor = ReportProfile::Extractor::Text;
+    bool cacheHit = false;
 
     if (ext == QStringLiteral(".doc"))
     {
+        extractor = ReportProfile::Extractor::Stub;
         text = QStringLiteral("[Файл .DOC: извлечение текста не реализовано. "
                               "Рекомендуется конвертировать в .DOCX или .TXT.]");
     }
     else if (ext == QStringLiteral(".docx"))
     {
         QString err;
-        text = readDocxText(file.absoluteFilePath(), &err);
+        extractor = ReportProfile::Extractor::Docx;
+        text = extractCached(cache, file, QLatin1String(kDocxExtractor), 0,
+                             [&](QString* e) { return readDocxText(file.absPath, e); }, &err, &cacheHit);
         if (!err.isEmpty())
         {
+            if (extractorOut) *extractorOut = extractor;
             if (errorOut) *errorOut = err;
             return {};
         }
     }
     else if (ext == QStringLiteral(".pdf"))
     {
+        // PDF останавливается по лимиту вывода уже при извлечении — лимит входит в ключ кэша.
         QString err;
-        text = readPdfText(file.absoluteFilePath(), &err);
+        extractor = ReportProfile::Extractor::Pdf;
+        text = extractCached(cache, file, pdfExtractorId(), m_opt.maxOutChars,
+                             [&](QString* e) { return readPdfText(file.absPath, e); }, &err, &cacheHit);
         if (!err.isEmpty())
         {
+            if (extractorOut) *extractorOut = extractor;
             if (errorOut) *errorOut = err;
             return {};
         }
     }
     else if (ext == QStringLiteral(".xls"))
     {
+        extractor = ReportProfile::Extractor::Stub;
         text = QStringLiteral("[Файл .XLS: старый бинарный формат Excel. "
                               "Извлечение текста не реализовано. "
                               "Сохраните как .XLSX или .CSV.]");
     }
     else if (ext == QStringLiteral(".xlsx") || ext == QStringLiteral(".xlsm"))
     {
+        // XLSX режется по лимиту уже при извлечении — лимит входит в ключ кэша.
         QString err;
-        text = readXlsxText(file.absoluteFilePath(), &err);
+        extractor = ReportProfile::Extractor::Xlsx;
+        text = extractCached(cache, file, QLatin1String(kXlsxExtractor), m_opt.maxOutChars,
+                             [&](QString* e) { return readXlsxText(file.absPath, e); }, &err, &cacheHit);
         if (!err.isEmpty())
         {
+            if (extractorOut) *extractorOut = extractor;
             if (errorOut) *errorOut = err;
             return {};
         }
     }
     else
     {
-        text = readTextSmart(file.absoluteFilePath(), errorOut);
+        bool binary = false;
+        text = readTextSmart(file.absPath, errorOut, m_opt.maxOutChars, &binary, beforeDecode);
+        if (binary)
+        {
+            if (extractorOut) *extractorOut = ReportProfile::Extractor::Binary;
+            if (binaryOut) *binaryOut = true;
+            return QStringLiteral("[ПРОПУЩЕН: двоичное содержимое (NUL или управляющие байты в начале файла)]");
+        }
     }
 
+    if (extractorOut)
+        *extractorOut = cacheHit ? ReportProfile::Extractor::Cache : extractor;
+
     // ✅ Единый лимит вывода для любого файла (0 = без лимита)
     truncateWithNote(text, m_opt.maxOutChars,
                      QStringLiteral("[ОБРЕЗАНО: превышен лимит вывода текста]"));
@@ -944,69 +2049,21 @@ QString ReportGenerator::readFileForReport(const QFileInfo& file, QString* error
 
 QString ReportGenerator::readPdfText(const QString& pdfPath, QString* errorOut) const
 {
-    const QString exe = findPdfToTextExe();
-    if (exe.isEmpty())
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral(
-                "Не найден pdftotext.exe. "
-                "Положите Poppler в <папка_приложения>/tools/poppler/pdftotext.exe "
-                "или установите pdftotext в систему (PATH).");
-
-        return {};
-    }
-
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.setProgram(exe);
-
-    // pdftotext [options] PDF-file [text-file], text-file "-" -> stdout
-    // -enc UTF-8, -layout см. manpage
-    proc.setArguments({ QStringLiteral("-enc"), QStringLiteral("UTF-8"),
-                       QStringLiteral("-layout"),
-                       pdfPath,
-                       QStringLiteral("-") });
-
-    proc.setWorkingDirectory(QFileInfo(exe).absolutePath());
-    proc.start();
-    if (!proc.waitForStarted())
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral("Не удалось запустить pdftotext: %1").arg(proc.errorString());
-        return {};
-    }
-
-    proc.waitForFinished(-1);
-
-    const QByteArray outBytes = proc.readAll();
-    QString t = QString::fromUtf8(outBytes);
-
-    /** \brief Убираем разрыв страницы (Form Feed, \f) из pdftotext.
- *  \details pdftotext часто вставляет 0x0C между страницами.
- *           В QTextEdit это выглядит как "квадратик" или "".
- */
-    t.replace(QChar(0x000C), QLatin1Char('\n'));
-
-    /** \brief (Опционально) нормализуем переводы строк под единый вид. */
-    t.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
-
-
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral("pdftotext завершился с ошибкой (exitCode=%1). Вывод: %2")
-                            .arg(proc.exitCode())
-                            .arg(t.trimmed());
-        return {};
-    }
-
-    return t.trimmed();
+    PdfTextLimits limits;
+    limits.maxPages = m_opt.pdfMaxPages;
+    limits.maxChars = m_opt.maxOutChars;
+    limits.timeoutMs = m_opt.pdfTimeoutMs;
+    limits.cancelRequested = m_opt.cancelRequested;
+    return extractPdfText(pdfPath, limits, errorOut);
 }
 
 
 
 // ---------------- XLSX/XLSM ----------------
 
+/** \brief Столбцов на листе Excel (A..XFD); ссылки дальше считаем мусором. */
+static constexpr int kXlsxMaxColumns = 16384;
+
 static QString xmlAttrByQName(const QXmlStreamAttributes& attrs, const QString& qname)
 {
     for (const auto& a : attrs)
@@ -1032,113 +2089,148 @@ static int excelColIndexFromCellRef(const QString& ref)
         if (ch < QLatin1Char('A') || ch > QLatin1Char('Z'))
             break;
         col = col * 26 + (ch.unicode() - QLatin1Char('A').unicode() + 1);
+        if (col > kXlsxMaxColumns)
+            return -1; // не ссылка Excel (XFD — последний столбец)
         ++i;
     }
     return (col > 0) ? (col - 1) : -1; // 0-based
 }
 
-static QVector<QString> readSharedStringsXml(const QString& ssPath, QString* errorOut)
+/**
+ * @brief sharedStrings.xml, разбираемый лениво.
+ * @details В памяти лежит только распакованный XML; строки разбираются по порядку
+ *          до самого большого запрошенного индекса. Если лимит вывода исчерпан рано,
+ *          хвост таблицы строк (часто — сотни тысяч строк) не разбирается вовсе.
+ */
+class XlsxSharedStrings
 {
-    QVector<QString> shared;
+public:
+    explicit XlsxSharedStrings(const QByteArray& ssData)
+        : m_xml(ssData)
+        , m_done(ssData.isEmpty()) // sharedStrings может отсутствовать — это нормально
+    {
+    }
 
-    QFile f(ssPath);
-    if (!f.open(QIODevice::ReadOnly))
-        return shared; // sharedStrings может отсутствовать — это нормально
+    /** \brief Строка по индексу; false если такой нет. */
+    bool at(int idx, QString* out)
+    {
+        while (idx >= m_items.size() && !m_done)
+            parseNext();
+
+        if (idx < 0 || idx >= m_items.size())
+            return false;
+        *out = m_items.at(idx);
+        return true;
+    }
 
-    QXmlStreamReader xml(&f);
+    /** \brief Ошибка XML (пусто, если её не было или до неё ещё не дошли). */
+    QString errorString() const { return m_error; }
 
-    QString cur;
-    bool inSi = false;
+private:
+    QXmlStreamReader m_xml;
+    QVector<QString> m_items;
+    QString m_error;
+    bool m_done = false;
 
-    while (!xml.atEnd())
+    /** \brief Разобрать следующий <si> (текст всех его <t>). */
+    void parseNext()
     {
-        xml.readNext();
+        QString cur;
+        bool inSi = false;
+        bool inT = false;
 
-        if (xml.isStartElement())
+        while (!m_xml.atEnd())
         {
-            const auto n = xml.name();
-            if (n == QStringLiteral("si"))
+            m_xml.readNext();
+
+            if (m_xml.isStartElement())
             {
-                cur.clear();
-                inSi = true;
+                const auto n = m_xml.name();
+                if (n == QStringLiteral("si"))
+                {
+                    cur.clear();
+                    inSi = true;
+                }
+                else if (inSi && n == QStringLiteral("t"))
+                {
+                    inT = true;
+                }
             }
-            else if (inSi && n == QStringLiteral("t"))
+            else if (m_xml.isCharacters())
             {
-                cur += xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                if (inT)
+                    cur += m_xml.text();
             }
-        }
-        else if (xml.isEndElement())
-        {
-            if (xml.name() == QStringLiteral("si"))
+            else if (m_xml.isEndElement())
             {
-                shared.push_back(cur);
-                inSi = false;
+                const auto n = m_xml.name();
+                if (n == QStringLiteral("t"))
+                {
+                    inT = false;
+                }
+                else if (n == QStringLiteral("si") && inSi)
+                {
+                    m_items.push_back(cur);
+                    return;
+                }
             }
         }
-    }
 
-    if (xml.hasError())
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral("Ошибка XML sharedStrings: %1").arg(xml.errorString());
+        if (m_xml.hasError())
+            m_error = QStringLiteral("Ошибка XML sharedStrings: %1").arg(m_xml.errorString());
+        m_done = true;
     }
+};
 
-    return shared;
-}
-
-static QString sheetXmlToTsv(const QString& sheetPath,
-                             const QVector<QString>& shared,
-                             qint64 maxChars,
-                             QString* errorOut)
+/**
+ * @brief Дописать лист в out как TSV, разбирая XML по мере распаковки.
+ * @details
+ *  Строка листа собирается в плоский вектор столбцов, который переиспользуется
+ *  между строками. Как только out превысил maxChars (общий лимит на все листы),
+ *  распаковка и разбор останавливаются.
+ * @return false — лимит исчерпан или генерация отменена: следующие листы не читать.
+ */
+static bool appendSheetTsv(const ZipReader& zip,
+                           const QString& sheetPath,
+                           XlsxSharedStrings& shared,
+                           qint64 maxChars,
+                           const std::atomic_bool* cancelRequested,
+                           QString& out,
+                           QString* errorOut)
 {
-    QFile f(sheetPath);
-    if (!f.open(QIODevice::ReadOnly))
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral("Не удалось открыть лист XLSX: %1").arg(f.errorString());
-        return {};
-    }
-
-    QXmlStreamReader xml(&f);
-    QString out;
-    out.reserve(8192);
+    QXmlStreamReader xml;
 
     int lastRowNum = 0;
     int currentRowNum = 0;
 
-    QMap<int, QString> rowCells;
+    QVector<QString> cols;   // значения столбцов текущей строки
     int maxCol = -1;
+    int nextCol = 0;         // для ячеек без r="A1"
 
     bool inCell = false;
+    bool inValue = false;
     QString cellRef;
     QString cellType;
     QString cellValue;
 
+    bool budgetHit = false;
+    bool canceled = false;
+
     auto flushRow = [&]() -> bool {
         if (currentRowNum <= 0)
             return true;
 
+        // Пишем: номер строки + табличные значения
+        out += QString::number(currentRowNum);
         if (maxCol >= 0)
         {
-            QStringList cols;
-            cols.resize(maxCol + 1);
-            for (auto it = rowCells.begin(); it != rowCells.end(); ++it)
+            for (int c = 0; c <= maxCol; ++c)
             {
-                const int c = it.key();
-                if (c >= 0 && c < cols.size())
-                    cols[c] = it.value();
+                out += QLatin1Char('\t');
+                out += cols.at(c);
+                cols[c].clear();
             }
-
-            // Пишем: номер строки + табличные значения
-            out += QString::number(currentRowNum);
-            out += QLatin1Char('\t');
-            out += cols.join(QStringLiteral("\t"));
-        }
-        else
-        {
-            out += QString::number(currentRowNum);
         }
-
         out += QLatin1Char('\n');
 
         if (maxChars > 0 && out.size() > maxChars)
@@ -1147,171 +2239,184 @@ static QString sheetXmlToTsv(const QString& sheetPath,
             return false;
         }
 
-
         return true;
     };
 
-    while (!xml.atEnd())
-    {
-        xml.readNext();
-
-        if (xml.isStartElement())
+    auto cellText = [&]() -> QString {
+        if (cellType == QStringLiteral("s"))
         {
-            const auto n = xml.name();
-
-            if (n == QStringLiteral("row"))
-            {
-                bool ok = false;
-                currentRowNum = xml.attributes().value(QStringLiteral("r")).toInt(&ok);
-                if (!ok || currentRowNum <= 0)
-                    currentRowNum = lastRowNum + 1;
-                lastRowNum = currentRowNum;
-
-                rowCells.clear();
-                maxCol = -1;
-            }
-            else if (n == QStringLiteral("c"))
-            {
-                inCell = true;
-                cellRef = xml.attributes().value(QStringLiteral("r")).toString();
-                cellType = xml.attributes().value(QStringLiteral("t")).toString();
-                cellValue.clear();
-            }
-            else if (inCell && n == QStringLiteral("v"))
-            {
-                cellValue = xml.readElementText(QXmlStreamReader::IncludeChildElements);
-            }
-            else if (inCell && cellType == QStringLiteral("inlineStr") && n == QStringLiteral("t"))
-            {
-                cellValue += xml.readElementText(QXmlStreamReader::IncludeChildElements);
-            }
+            bool ok = false;
+            const int idx = cellValue.toInt(&ok);
+            QString s;
+            if (ok && shared.at(idx, &s))
+                return s;
+            return QStringLiteral("[bad sharedString index: %1]").arg(cellValue);
         }
-        else if (xml.isEndElement())
+        if (cellType == QStringLiteral("b"))
+            return (cellValue == QStringLiteral("1")) ? QStringLiteral("TRUE") : QStringLiteral("FALSE");
+        return cellValue;
+    };
+
+    // Разобрать всё, что уже есть в буфере; false — дальше не читать.
+    auto pump = [&]() -> bool {
+        while (!xml.atEnd())
         {
-            const auto n = xml.name();
+            xml.readNext();
 
-            if (n == QStringLiteral("c") && inCell)
+            if (xml.isStartElement())
             {
-                const int col = excelColIndexFromCellRef(cellRef);
+                const auto n = xml.name();
 
-                QString val;
-                if (cellType == QStringLiteral("s"))
+                if (n == QStringLiteral("row"))
                 {
                     bool ok = false;
-                    const int idx = cellValue.toInt(&ok);
-                    if (ok && idx >= 0 && idx < shared.size())
-                        val = shared[idx];
-                    else
-                        val = QStringLiteral("[bad sharedString index: %1]").arg(cellValue);
+                    currentRowNum = xml.attributes().value(QStringLiteral("r")).toInt(&ok);
+                    if (!ok || currentRowNum <= 0)
+                        currentRowNum = lastRowNum + 1;
+                    lastRowNum = currentRowNum;
+
+                    maxCol = -1;
+                    nextCol = 0;
                 }
-                else if (cellType == QStringLiteral("b"))
+                else if (n == QStringLiteral("c"))
                 {
-                    val = (cellValue == QStringLiteral("1")) ? QStringLiteral("TRUE") : QStringLiteral("FALSE");
+                    inCell = true;
+                    cellRef = xml.attributes().value(QStringLiteral("r")).toString();
+                    cellType = xml.attributes().value(QStringLiteral("t")).toString();
+                    cellValue.clear();
                 }
-                else
+                else if (inCell && n == QStringLiteral("v"))
                 {
-                    val = cellValue;
+                    cellValue.clear();
+                    inValue = true;
                 }
-
-                if (col >= 0)
+                else if (inCell && cellType == QStringLiteral("inlineStr") && n == QStringLiteral("t"))
                 {
-                    rowCells[col] = val;
-                    maxCol = std::max(maxCol, col);
+                    inValue = true;
                 }
-
-                inCell = false;
             }
-            else if (n == QStringLiteral("row"))
+            else if (xml.isCharacters())
             {
-                if (!flushRow())
-                    break;
-                currentRowNum = 0;
+                // Текст может прийти несколькими кусками (граница порции данных).
+                if (inValue)
+                    cellValue += xml.text();
+            }
+            else if (xml.isEndElement())
+            {
+                const auto n = xml.name();
+
+                if (n == QStringLiteral("v") || n == QStringLiteral("t"))
+                {
+                    inValue = false;
+                }
+                else if (n == QStringLiteral("c") && inCell)
+                {
+                    const int col = cellRef.isEmpty() ? nextCol : excelColIndexFromCellRef(cellRef);
+                    if (col >= 0 && col < kXlsxMaxColumns)
+                    {
+                        if (col >= cols.size())
+                            cols.resize(col + 1);
+                        cols[col] = cellText();
+                        maxCol = std::max(maxCol, col);
+                        nextCol = col + 1;
+                    }
+
+                    inCell = false;
+                }
+                else if (n == QStringLiteral("row"))
+                {
+                    if (!flushRow())
+                    {
+                        budgetHit = true;
+                        return false;
+                    }
+                    currentRowNum = 0;
+                }
             }
         }
-    }
 
-    if (xml.hasError())
-    {
-        if (errorOut)
-            *errorOut = QStringLiteral("Ошибка XML листа XLSX: %1").arg(xml.errorString());
-        return {};
-    }
+        return xml.error() == QXmlStreamReader::NoError
+               || xml.error() == QXmlStreamReader::PrematureEndOfDocumentError;
+    };
 
-    return out/*.trimmed()*/;
-}
+    QString zipErr;
+    zip.readChunked(sheetPath, [&](const char* data, int size) {
+        if (cancelRequested && cancelRequested->load())
+        {
+            canceled = true;
+            return false;
+        }
+        xml.addData(QByteArray(data, size));
+        return pump();
+    }, &zipErr);
 
-QString ReportGenerator::readXlsxText(const QString& xlsxPath, QString* errorOut) const
-{
-#ifdef Q_OS_WIN
-    QTemporaryDir tmp;
-    if (!tmp.isValid())
+    if (canceled)
     {
-        if (errorOut) *errorOut = QStringLiteral("Не удалось создать временную папку для распаковки XLSX.");
-        return {};
+        if (errorOut) *errorOut = QStringLiteral("Извлечение отменено.");
+        return false;
     }
+    if (budgetHit)
+        return false;
 
-    // XLSX/XLSM = ZIP, но Expand-Archive любит .zip
-    const QString zipPath = QDir(tmp.path()).filePath(QStringLiteral("xlsx.zip"));
-    QFile::remove(zipPath);
-    if (!QFile::copy(xlsxPath, zipPath))
+    if (!zipErr.isEmpty())
     {
-        if (errorOut) *errorOut = QStringLiteral("Не удалось скопировать XLSX во временный ZIP для распаковки.");
-        return {};
+        if (errorOut) *errorOut = zipErr;
+    }
+    else if (xml.hasError())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Ошибка XML листа XLSX: %1").arg(xml.errorString());
     }
 
-    const QString srcZip = psEscapeSingleQuoted(QDir::toNativeSeparators(zipPath));
-    const QString dst    = psEscapeSingleQuoted(QDir::toNativeSeparators(tmp.path()));
-
-    const QString cmd = QStringLiteral(
-                            "$ErrorActionPreference='Stop';"
-                            "$OutputEncoding=[Console]::OutputEncoding=[System.Text.Encoding]::UTF8;"
-                            "Expand-Archive -LiteralPath '%1' -DestinationPath '%2' -Force"
-                            ).arg(srcZip, dst);
-
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(QStringLiteral("powershell.exe"),
-               QStringList()
-                   << QStringLiteral("-NoProfile")
-                   << QStringLiteral("-NonInteractive")
-                   << QStringLiteral("-ExecutionPolicy") << QStringLiteral("Bypass")
-                   << QStringLiteral("-Command") << cmd);
+    return true;
+}
 
-    proc.waitForFinished(-1);
+/**
+ * @brief Путь элемента архива по Target из workbook.xml.rels.
+ * @details Target бывает относительным к xl/ ("worksheets/sheet1.xml")
+ *          или абсолютным от корня пакета ("/xl/worksheets/sheet1.xml").
+ */
+static QString xlsxPartPath(const QString& target)
+{
+    if (target.startsWith(QLatin1Char('/')))
+        return QDir::cleanPath(target.mid(1));
+    return QDir::cleanPath(QStringLiteral("xl/") + target);
+}
 
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)
+QString ReportGenerator::readXlsxText(const QString& xlsxPath, QString* errorOut) const
+{
+    // XLSX/XLSM = ZIP: нужные XML распаковываем прямо в память.
+    ZipReader zip(xlsxPath);
+    QString zipErr;
+    if (!zip.open(&zipErr))
     {
-        const QString out = QString::fromUtf8(proc.readAll()).trimmed();
-        if (errorOut)
-            *errorOut = QStringLiteral("Ошибка извлечения XLSX (Expand-Archive): %1").arg(out);
+        if (errorOut) *errorOut = QStringLiteral("Ошибка извлечения XLSX: %1").arg(zipErr);
         return {};
     }
 
-    const QString xlDir = QDir(tmp.path()).filePath(QStringLiteral("xl"));
-    const QString ssPath = QDir(xlDir).filePath(QStringLiteral("sharedStrings.xml"));
-
+    // Таблица строк распаковывается сразу (листы идут потоком, вторую распаковку параллельно
+    // readChunked() не ведёт), а разбирается лениво — см. XlsxSharedStrings.
     QString ssErr;
-    const QVector<QString> shared = readSharedStringsXml(ssPath, &ssErr);
+    QByteArray ssData;
+    if (zip.contains(QStringLiteral("xl/sharedStrings.xml")))
+        ssData = zip.read(QStringLiteral("xl/sharedStrings.xml"), &ssErr);
     // ssErr не считаем фатальным — sharedStrings может отсутствовать
+    XlsxSharedStrings shared(ssData);
 
     // workbook rels: xl/_rels/workbook.xml.rels
     QHash<QString, QString> rel;
+    if (zip.contains(QStringLiteral("xl/_rels/workbook.xml.rels")))
     {
-        const QString relsPath = QDir(xlDir).filePath(QStringLiteral("_rels/workbook.xml.rels"));
-        QFile f(relsPath);
-        if (f.open(QIODevice::ReadOnly))
+        QXmlStreamReader xml(zip.read(QStringLiteral("xl/_rels/workbook.xml.rels")));
+        while (!xml.atEnd())
         {
-            QXmlStreamReader xml(&f);
-            while (!xml.atEnd())
+            xml.readNext();
+            if (xml.isStartElement() && xml.name() == QStringLiteral("Relationship"))
             {
-                xml.readNext();
-                if (xml.isStartElement() && xml.name() == QStringLiteral("Relationship"))
-                {
-                    const QString id = xml.attributes().value(QStringLiteral("Id")).toString();
-                    const QString target = xml.attributes().value(QStringLiteral("Target")).toString();
-                    if (!id.isEmpty() && !target.isEmpty())
-                        rel.insert(id, target);
-                }
+                const QString id = xml.attributes().value(QStringLiteral("Id")).toString();
+                const QString target = xml.attributes().value(QStringLiteral("Target")).toString();
+                if (!id.isEmpty() && !target.isEmpty())
+                    rel.insert(id, target);
             }
         }
     }
@@ -1320,30 +2425,26 @@ QString ReportGenerator::readXlsxText(const QString& xlsxPath, QString* errorOut
     QVector<Sheet> sheets;
 
     // workbook: xl/workbook.xml
+    if (zip.contains(QStringLiteral("xl/workbook.xml")))
     {
-        const QString wbPath = QDir(xlDir).filePath(QStringLiteral("workbook.xml"));
-        QFile f(wbPath);
-        if (f.open(QIODevice::ReadOnly))
+        QXmlStreamReader xml(zip.read(QStringLiteral("xl/workbook.xml")));
+        while (!xml.atEnd())
         {
-            QXmlStreamReader xml(&f);
-            while (!xml.atEnd())
+            xml.readNext();
+            if (xml.isStartElement() && xml.name() == QStringLiteral("sheet"))
             {
-                xml.readNext();
-                if (xml.isStartElement() && xml.name() == QStringLiteral("sheet"))
-                {
-                    const QString name = xml.attributes().value(QStringLiteral("name")).toString();
-                    const QString rid = xmlAttrByQName(xml.attributes(), QStringLiteral("r:id"));
-                    const QString target = rel.value(rid);
+                const QString name = xml.attributes().value(QStringLiteral("name")).toString();
+                const QString rid = xmlAttrByQName(xml.attributes(), QStringLiteral("r:id"));
+                const QString target = rel.value(rid);
 
-                    // target обычно "worksheets/sheet1.xml"
-                    QString sheetPath;
-                    if (!target.isEmpty())
-                        sheetPath = QDir(xlDir).filePath(target);
+                // target обычно "worksheets/sheet1.xml"
+                QString sheetPath;
+                if (!target.isEmpty())
+                    sheetPath = xlsxPartPath(target);
 
-                    if (!sheetPath.isEmpty() && QFileInfo::exists(sheetPath))
-                    {
-                        sheets.push_back({ name.isEmpty() ? QFileInfo(sheetPath).baseName() : name, sheetPath });
-                    }
+                if (!sheetPath.isEmpty() && zip.contains(sheetPath))
+                {
+                    sheets.push_back({ name.isEmpty() ? QFileInfo(sheetPath).baseName() : name, sheetPath });
                 }
             }
         }
@@ -1352,11 +2453,19 @@ QString ReportGenerator::readXlsxText(const QString& xlsxPath, QString* errorOut
     // fallback: если workbook не распарсили — берём все xl/worksheets/*.xml
     if (sheets.isEmpty())
     {
-        QDir wsDir(QDir(xlDir).filePath(QStringLiteral("worksheets")));
-        const QStringList files = wsDir.entryList(QStringList() << QStringLiteral("*.xml"),
-                                                  QDir::Files, QDir::Name);
-        for (const QString& fn : files)
-            sheets.push_back({ fn, wsDir.filePath(fn) });
+        QStringList files;
+        const QString wsPrefix = QStringLiteral("xl/worksheets/");
+        for (const QString& n : zip.entryNames())
+        {
+            if (n.startsWith(wsPrefix, Qt::CaseInsensitive)
+                && n.endsWith(QStringLiteral(".xml"), Qt::CaseInsensitive)
+                && !n.mid(wsPrefix.size()).contains(QLatin1Char('/')))
+                files.push_back(n);
+        }
+        std::sort(files.begin(), files.end());
+
+        for (const QString& fn : std::as_const(files))
+            sheets.push_back({ fn.mid(wsPrefix.size()), fn });
     }
 
     if (sheets.isEmpty())
@@ -1376,68 +2485,82 @@ QString ReportGenerator::readXlsxText(const QString& xlsxPath, QString* errorOut
     if (!ssErr.isEmpty())
         out += QStringLiteral("[предупреждение sharedStrings] %1\n").arg(ssErr);
 
+    // Лимит общий на все листы: как только он набран, остальное не распаковывается.
     for (const Sheet& sh : sheets)
     {
         out += QStringLiteral("\n----- SHEET: %1 -----\n").arg(sh.name);
+        if (maxChars > 0 && out.size() > maxChars)
+        {
+            truncateHardForFinalNote(out, maxChars);
+            break;
+        }
 
         QString sheetErr;
-        const QString tsv = sheetXmlToTsv(sh.path, shared, maxChars, &sheetErr);
+        const bool more = appendSheetTsv(zip, sh.path, shared, maxChars, m_opt.cancelRequested, out, &sheetErr);
+        if (isCanceled())
+        {
+            if (errorOut) *errorOut = QStringLiteral("Извлечение XLSX отменено.");
+            return {};
+        }
+        if (!more)
+            break;
 
         if (!sheetErr.isEmpty())
-        {
             out += QStringLiteral("[ОШИБКА ЛИСТА: %1]\n").arg(sheetErr);
-            continue;
-        }
 
-        out += tsv;
         out += QLatin1Char('\n');
-
-        if (maxChars > 0 && out.size() > maxChars)
-        {
-            truncateHardForFinalNote(out, maxChars);
-            break;
-        }
-
     }
 
+    if (!shared.errorString().isEmpty())
+        out += QStringLiteral("\n[предупреждение sharedStrings] %1\n").arg(shared.errorString());
+
     return out/*.trimmed()*/;
+}
 
-#else
-    if (errorOut)
-        *errorOut = QStringLiteral("Извлечение текста из XLSX сейчас реализовано только для Windows.");
-    return {};
-#endif
+
+QString ReportGenerator::pdfExtractorId() const
+{
+    // Бэкенд и лимит страниц меняют текст; таймаут — только через выбор бэкенда
+    // (ошибки не кэшируются).
+    return QStringLiteral("%1/%2/pages=%3")
+        .arg(QLatin1String(kPdfExtractor), QLatin1String(pdfTextBackendId(m_opt.pdfTimeoutMs)))
+        .arg(m_opt.pdfMaxPages);
 }
 
+QString ReportGenerator::blockFingerprint() const
+{
+    // includeExt решает, разбирается ли .pdf/.docx/.xlsx как документ или читается как текст;
+    // includeAnyText — выводится ли файл, взятый только по содержимому.
+    QStringList exts = m_opt.includeExt;
+    std::sort(exts.begin(), exts.end());
+
+    return QStringLiteral("report/3|%1|%2|%3|%4|%5|%6|%7|%8")
+        .arg(m_rootAbs)
+        .arg(m_opt.maxOutChars)
+        .arg((int)m_opt.noBomEncodingMode)
+        .arg(pdfExtractorId())
+        .arg(QLatin1String(kDocxExtractor))
+        .arg(QLatin1String(kXlsxExtractor))
+        .arg(exts.join(QLatin1Char(',')))
+        .arg(m_opt.includeAnyText ? 1 : 0);
+}
 
-QString ReportGenerator::findPdfToTextExe() const
+int ReportGenerator::extractionThreadCount() const
 {
-#ifdef Q_OS_WIN
-    const QDir appDir(QCoreApplication::applicationDirPath());
-
-    // 1) Вариант "положили прямо рядом с ContextMaker.exe" (не лучший, но пусть будет)
-    const QString flat = appDir.filePath(QStringLiteral("pdftotext.exe"));
-    if (QFileInfo::exists(flat))
-        return flat;
-
-    // 2) РЕКОМЕНДУЕМЫЙ вариант для деплоя:
-    // <рядом с exe>/tools/poppler/pdftotext.exe
-    const QString toolsPoppler = appDir.filePath(QStringLiteral("tools/poppler/pdftotext.exe"));
-    if (QFileInfo::exists(toolsPoppler))
-        return toolsPoppler;
-
-    // 3) Альтернатива: <рядом с exe>/poppler/pdftotext.exe
-    const QString poppler = appDir.filePath(QStringLiteral("poppler/pdftotext.exe"));
-    if (QFileInfo::exists(poppler))
-        return poppler;
-#endif
+    if (m_opt.threadPool)
+        return std::max(1, m_opt.threadPool->maxThreadCount());
 
-    // 4) Если пользователь установил pdftotext в систему и добавил в PATH
-    const QString inPath = QStandardPaths::findExecutable(QStringLiteral("pdftotext"));
-    if (!inPath.isEmpty())
-        return inPath;
+    if (m_opt.maxParallelReads > 0)
+        return m_opt.maxParallelReads;
+    return std::max(1, QThread::idealThreadCount());
+}
 
-    return {};
+int ReportGenerator::scanThreadCount() const
+{
+    if (m_opt.scanThreads > 0)
+        return m_opt.scanThreads;
+    // Дальше упираемся в диск, а не в ядра.
+    return std::clamp(QThread::idealThreadCount(), 1, 8);
 }
 
 
@@ -10,7 +10,89 @@
 #include <QSet>
 #include <QFileInfo>
 #include <QVector>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QMutexLocker>
 #include <atomic>
+#include <functional>
+
+#include "dirmodel.h"
+#include "reportprofile.h"
+
+class QIODevice;
+class QThreadPool;
+class ExtractionCache;
+class ReportSink;
+class ReportWriter;
+
+
+/**
+ * @brief Счётчики хода генерации (для прогресса в UI и диагностики долгих прогонов).
+ * @details Генератор только пишет, UI только читает (например, по таймеру).
+ *          Все поля атомарные, текущий файл — под мьютексом.
+ */
+struct ReportProgress
+{
+    /** \brief Этап генерации. */
+    enum Phase
+    {
+        Idle,
+        Scanning,    ///< Обход каталога.
+        Contents,    ///< Секция 2: извлечение и вывод файлов.
+        Finished
+    };
+
+    std::atomic_int phase { Idle };
+    std::atomic<qint64> entriesScanned { 0 };  ///< Элементов каталога найдено при обходе.
+    std::atomic<qint64> filesSelected { 0 };   ///< Файлов отобрано в секцию 2.
+    std::atomic<qint64> filesDone { 0 };       ///< Файлов уже выведено в отчёт.
+    std::atomic<qint64> filesExtracted { 0 };  ///< Из них прочитано/извлечено (не взято из прошлого отчёта).
+    std::atomic<qint64> bytesRead { 0 };       ///< Исходных байт в извлечённых файлах.
+    std::atomic<qint64> startedMs { 0 };       ///< Начало прогона (мс от эпохи UTC).
+
+    /** \brief Последний начатый файл и время начала его извлечения (мс от эпохи UTC). */
+    void setCurrentFile(const QString& path, qint64 sinceMs)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_currentFile = path;
+        m_currentSinceMs = sinceMs;
+    }
+
+    QString currentFile(qint64* sinceMs = nullptr) const
+    {
+        QMutexLocker lock(&m_mutex);
+        if (sinceMs) *sinceMs = m_currentSinceMs;
+        return m_currentFile;
+    }
+
+    /** \brief Сбросить перед новым прогоном. */
+    void reset()
+    {
+        phase = Idle;
+        entriesScanned = 0;
+        filesSelected = 0;
+        filesDone = 0;
+        filesExtracted = 0;
+        bytesRead = 0;
+        startedMs = 0;
+        setCurrentFile(QString(), 0);
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QString m_currentFile;
+    qint64 m_currentSinceMs = 0;
+};
+
+
+/**
+ * @brief Пути, от которых зависит отчёт (для слежения за изменениями).
+ */
+struct ReportDependencies
+{
+    QStringList dirs;    ///< Все папки модели, включая корень: их состав — это дерево.
+    QStringList files;   ///< Файлы секции 2 (до отбора по бюджету).
+};
 
 
 /**
@@ -27,17 +109,158 @@ public:
     {
         QString rootPath;
         QStringList includeExt;
+        /** \brief Брать в секцию 2 любые текстовые файлы, а не только из includeExt.
+         *  \details Текст определяется по содержимому (начало файла, см. textsniff.h);
+         *           двоичные файлы не из includeExt в отчёт не попадают вовсе.
+         *           PDF/DOCX/XLSX извлекаются только при расширении из includeExt.
+         */
+        bool includeAnyText = false;
+        /** \brief Исключаемые папки.
+         *  \details Элемент может быть:
+         *   - именем папки (`build`) — исключается на любом уровне;
+         *   - маской имени (`*.egg-info`, `cmake-build-*`) — тоже на любом уровне;
+         *   - путём/маской пути относительно корня (`src/generated`, `docs/*/tmp`).
+         *  Сравнение без учёта регистра.
+         */
         QStringList excludeDirNames;
         qint64 maxBytes = 1024 * 1024;
         qint64 maxOutChars = 1024 * 1024;   // лимит текста, вставляемого в отчёт (символы). 0 = без лимита
+        /** \brief Дерево внешней командой "tree /F /A" (только Windows).
+         *  \details Не знает excludeDirNames и лимитов дерева; то же оформление без внешнего
+         *           процесса даёт treeStyle = TreeStyle::Ascii.
+         */
         bool useCmdTree = false;
+        /** \brief Время на команду tree, мс (0 = без ограничения); по таймауту — встроенное дерево. */
+        int cmdTreeTimeoutMs = 120 * 1000;
+
+        /** \brief Оформление встроенного дерева. */
+        enum class TreeStyle
+        {
+            Unicode,   ///< ├── └── │ — папки первыми.
+            Ascii      ///< +--- \--- | — как "tree /F /A": файлы папки перед подпапками.
+        };
+
+        TreeStyle treeStyle = TreeStyle::Unicode;
         bool treeOnly = false; // Если true — генерируем только дерево, без секции 2
+        /** \brief Глубина встроенного дерева (0 = без ограничения).
+         *  \details Содержимое папок глубже заменяется одной строкой-сводкой (папок/файлов/размер).
+         *           На секцию 2 не влияет. Дерево через cmd этими лимитами не ограничивается.
+         */
+        int treeMaxDepth = 0;
+        /** \brief Сколько элементов показывать в одной папке дерева (0 = все); остальные — сводкой. */
+        int treeMaxEntriesPerDir = 0;
+        /** \brief Показывать в дереве только папки, где (на любой глубине) есть файлы для секции 2. */
+        bool treeOnlyIncludedDirs = false;
+        /** \brief Сколько первых страниц PDF извлекать (0 = все). */
+        int pdfMaxPages = 0;
+        /** \brief Время на извлечение одного PDF, мс (0 = без ограничения).
+         *  \details Битый или огромный PDF не должен подвешивать весь отчёт:
+         *           по таймауту файл получает ошибку чтения, отчёт строится дальше.
+         *           Прервать можно только процесс pdftotext, поэтому при таймауте > 0 (и
+         *           найденном pdftotext) PDF извлекается им даже в сборке с poppler-cpp;
+         *           poppler-cpp в процессе проверяет таймаут лишь между страницами.
+         */
+        int pdfTimeoutMs = 120 * 1000;
+        /** \brief Сколько файлов секции 2 извлекать параллельно.
+         *  \details 0 = по числу ядер (QThread::idealThreadCount()), 1 = последовательно.
+         *           Порядок вывода от этого не зависит.
+         */
+        int maxParallelReads = 0;
+        /** \brief Сколько потоков обходят каталог.
+         *  \details 0 = авто (по числу ядер, не больше 8), 1 = последовательно.
+         *           Модель каталога от этого не зависит; выигрыш — на сетевых и холодных дисках.
+         */
+        int scanThreads = 0;
+        /** \brief Общий пул потоков извлечения (nullptr = свой пул на время генерации).
+         *  \details Нужен, когда подряд строится много отчётов: потоки не пересоздаются.
+         *           При заданном пуле maxParallelReads не используется — ширина = maxThreadCount() пула.
+         */
+        QThreadPool* threadPool = nullptr;
+        /** \brief Кэшировать извлечённый текст PDF/DOCX/XLSX на диске.
+         *  \details Ключ: путь + размер + mtime + версия экстрактора. Повторный отчёт по тем же
+         *           документам стоит только обхода каталога.
+         */
+        bool useExtractionCache = true;
+        /** \brief Папка файлов кэша; пусто = QStandardPaths::CacheLocation/extract-cache. */
+        QString cacheDir;
+        /** \brief Прошлый отчёт для инкрементальной перегенерации (пусто = полный прогон).
+         *  \details Рядом должен лежать его манифест (<отчёт>.manifest). Блоки файлов,
+         *           у которых не изменились размер и mtime, копируются из прошлого отчёта
+         *           без чтения исходников; заново читаются только новые и изменённые.
+         *  \note Новый отчёт нельзя писать поверх прошлого напрямую — только через QSaveFile
+         *        или в другой файл: прошлый отчёт читается по ходу генерации.
+         */
+        QString previousReportPath;
+        /** \brief Куда записать манифест этого отчёта (пусто = не писать).
+         *  \details Манифест пишется только при выводе в устройство (generateToDevice).
+         */
+        QString manifestPath;
+        /** \brief В секцию 2 выводить только новые и изменённые файлы (относительно previousReportPath).
+         *  \details В конце перечисляются удалённые файлы. Манифест в этом режиме не пишется.
+         */
+        bool changedOnly = false;
+        /** \brief Общий бюджет отчёта в символах (0 = без лимита).
+         *  \details Отчёт целиком (дерево + секция 2) должен уложиться в бюджет. Файлы секции 2
+         *           отбираются заранее по оценке размера блока, в порядке budgetOrder/priorityRules;
+         *           не вошедшие в бюджет файлы не читаются и перечисляются в конце отчёта.
+         *           Вывод остаётся в порядке путей.
+         */
+        qint64 reportBudgetChars = 0;
+
+        /** \brief Символов на токен для бюджета в токенах (грубая оценка для кода и текста). */
+        static constexpr int kCharsPerToken = 4;
+
+        /** \brief Порядок заполнения бюджета. */
+        enum class BudgetOrder
+        {
+            Path,           ///< По путям (как в отчёте).
+            SmallestFirst,  ///< Сначала маленькие файлы — в бюджет попадает больше файлов.
+            NewestFirst     ///< Сначала недавно изменённые.
+        };
+
+        BudgetOrder budgetOrder = BudgetOrder::Path;
+
+        /** \brief Веса путей для бюджета: элементы "маска=вес", например "src/*=10", "*.md=-5".
+         *  \details Маска без '/' сравнивается с именем файла, с '/' — с путём от корня;
+         *           без учёта регистра. Действует первое совпавшее правило, вес по умолчанию 0.
+         *           Файлы с большим весом попадают в бюджет раньше, внутри веса — по budgetOrder.
+         */
+        QStringList priorityRules;
+
+        /** \brief Одинаковые по содержимому файлы выводить один раз.
+         *  \details Хэшируются (XXH64) только файлы, размер которых совпадает с размером
+         *           другого файла секции 2, — по уже прочитанным для вывода байтам. При равном
+         *           хэше байты сравниваются с первым вхождением; повтор не декодируется,
+         *           а выводится ссылкой на него.
+         */
+        bool dedupContent = false;
+
         /** \brief Флаг отмены генерации.
          *  \details Если не nullptr — генератор периодически проверяет флаг.
          *           При true старается завершиться как можно быстрее.
          *  \note Указатель должен жить дольше, чем работает генерация.
          */
         std::atomic_bool* cancelRequested = nullptr;
+        /** \brief Счётчики прогресса (может быть nullptr).
+         *  \note Сбрасывать (reset()) перед запуском — забота вызывающего.
+         *        Указатель должен жить дольше, чем работает генерация.
+         */
+        ReportProgress* progress = nullptr;
+        /** \brief Профиль генерации: время фаз и извлечения каждого файла (может быть nullptr).
+         *  \details Генератор сам вызывает profile->start() в начале прогона.
+         *  \note Указатель должен жить дольше, чем работает генерация.
+         */
+        ReportProfile* profile = nullptr;
+        /** \brief Дописать в конец отчёта раздел с профилем (фазы, экстракторы, самые долгие файлы).
+         *  \details Без profile генератор профилирует во внутренний объект.
+         */
+        bool profileAppendix = false;
+        /** \brief Сколько самых долгих файлов перечислять в разделе профиля. */
+        int profileSlowestFiles = 20;
+        /** \brief Куда записать пути, от которых зависит отчёт (может быть nullptr).
+         *  \details Заполняется по ходу генерации; читать — после её завершения.
+         */
+        ReportDependencies* dependenciesOut = nullptr;
 
 
         /**
@@ -62,24 +285,64 @@ public:
      */
     QString generate(QString* errorOut = nullptr) const;
 
+    /**
+     * @brief Сформировать отчёт, отдавая его в приёмник по мере готовности.
+     * @details Текст каждого файла уходит в sink сразу после извлечения,
+     *          поэтому пик памяти ограничен самым большим файлом, а не всем отчётом.
+     * @param sink Приёмник отчёта.
+     * @param errorOut (опционально) сообщение об ошибке/предупреждение.
+     * @return false если отчёт не сформирован (ошибка, отмена до начала вывода, ошибка записи).
+     */
+    bool generate(ReportSink& sink, QString* errorOut = nullptr) const;
+
+    /**
+     * @brief Сформировать отчёт и записать его в устройство (файл, pipe) кусками UTF-8.
+     * @note BOM не пишется — при необходимости его пишет вызывающий код.
+     */
+    bool generateToDevice(QIODevice* device, QString* errorOut = nullptr) const;
+
 private:
     Options m_opt;
     QSet<QString> m_includeSet;   ///< Быстрый набор расширений (в нижнем регистре).
     QSet<QString> m_excludeSet;   ///< Быстрый набор исключаемых папок (как имена).
+    QVector<QRegularExpression> m_excludeNameGlobs; ///< Маски имён исключаемых папок.
+    QVector<QRegularExpression> m_excludePathGlobs; ///< Маски путей относительно корня (с '/').
+    QString m_rootAbs;            ///< Абсолютный путь корня (для относительных путей).
+
+    /** \brief Разобранное правило Options::priorityRules. */
+    struct PriorityRule
+    {
+        QRegularExpression re;
+        bool isPath = false;      ///< Маска пути от корня (иначе — имени файла).
+        int weight = 0;
+    };
+    QVector<PriorityRule> m_priorityRules;
 
     /**
-     * @brief Проверка: папка/файл находится внутри исключаемой директории (на любом уровне).
-     * @param item Информация о файле/папке.
-     * @return true если объект находится в одной из excluded папок.
+     * @brief Проверка: папку нужно исключить из обхода.
+     * @details Вызывается один раз при спуске: исключённая папка не попадает в модель
+     *          и не читается, поэтому её содержимое вообще не проверяется.
+     *          Предки к этому моменту уже проверены — подниматься вверх не нужно.
+     * @param item Элемент модели каталога.
+     * @return true если это папка, подходящая под одно из исключений.
      */
-    bool isUnderExcluded(const QFileInfo& item) const;
+    bool isExcludedDir(const DirEntry& item) const;
+
+    /** \brief Проверка имени папки по набору имён и маскам имён. */
+    bool isExcludedDirName(const QString& name) const;
 
     /**
      * @brief Проверка: можно ли читать содержимое файла.
-     * @param file Информация о файле.
-     * @return true если расширение разрешено и размер <= maxBytes.
+     * @param file Элемент модели каталога.
+     * @return true если расширение разрешено (или includeAnyText) и размер <= maxBytes.
      */
-    bool shouldIncludeFile(const QFileInfo& file) const;
+    bool shouldIncludeFile(const DirEntry& file) const;
+
+    /** \brief Расширение файла есть в includeExt. */
+    bool matchesIncludeExt(const DirEntry& file) const;
+
+    /** \brief Проверка сырых байт файла до декодирования: true — файл дальше не читать. */
+    using RawContentCheck = std::function<bool(const char* data, qint64 len)>;
 
     /**
      * @brief Считывание текста с простым авто-определением кодировки.
@@ -87,32 +350,72 @@ private:
      *  1) BOM: UTF-8 / UTF-16 LE/BE / UTF-32 LE/BE
      *  2) Без BOM: строгая проверка UTF-8 (валидность последовательностей).
      *  3) Фолбэк: системная ANSI (QString::fromLocal8Bit).
+     *  Файл читается через QFile::map(); декодируется только префикс, которого хватает
+     *  на maxChars + 1 символов (0 = весь файл) — остальное всё равно отрежет лимит вывода.
+     * @param binaryOut Если задан — сначала проверяется начало файла (looksBinary());
+     *        двоичный файл дальше не читается: *binaryOut = true, результат пустой.
+     * @param beforeDecode Если задана — вызывается с байтами всего (не двоичного) файла
+     *        до декодирования; вернула true — файл не декодируется, результат пустой.
      */
-    QString readTextSmart(const QString& path, QString* errorOut = nullptr) const;
+    QString readTextSmart(const QString& path, QString* errorOut = nullptr, qint64 maxChars = 0,
+                          bool* binaryOut = nullptr, const RawContentCheck& beforeDecode = {}) const;
 
     /**
-     * @brief Сформировать дерево каталога с псевдографикой (Unicode).
-     * @param path Путь к каталогу.
-     * @param indent Текущий префикс отступов (служебный).
-     * @param outLines Выходные строки дерева.
+     * @brief Вывести дерево каталога с псевдографикой (Unicode или ASCII, см. treeStyle).
+     * @details В стиле ASCII порядок и отступы как у "tree /F /A": сначала файлы папки,
+     *          после них строка-разделитель, затем подпапки.
+     *          Обход итеративный (глубина дерева не ограничена стеком потока); отступы —
+     *          один общий префикс, который растёт и укорачивается на 4 символа на уровень.
+     *          Строки копятся в одном буфере и уходят в writer кусками по ~64K символов.
+     *          Лимиты treeMaxDepth / treeMaxEntriesPerDir и фильтр treeOnlyIncludedDirs
+     *          применяются при обходе: скрытое не выводится, а сворачивается в строку-сводку.
+     * @param model Модель каталога (уже отфильтрованная и отсортированная).
+     * @param w Куда писать (строки дерева — как отдельные строки отчёта).
      */
-    void showTreeRec(const QString& path, const QString& indent, QStringList& outLines) const;
+    void writeTree(const DirModel& model, ReportWriter& w) const;
 
     /**
-     * @brief Запустить "tree /F /A" через cmd (только Windows) и вернуть вывод.
+     * @brief Вывести дерево командой "tree /F /A" через cmd (только Windows), по мере вывода.
+     * @details Вывод читается кусками и уходит в writer целыми строками (без лишних пустых
+     *          строк в начале и конце). Первые строки придерживаются, пока не станет ясно,
+     *          что это дерево, а не сообщение об ошибке. При отмене и по cmdTreeTimeoutMs
+     *          процесс завершается.
+     * @param wroteOut true — в writer уже что-то выведено (откатываться на встроенное дерево поздно).
      * @param errorOut (опционально) сообщение об ошибке.
+     * @return true если команда отработала до конца.
      */
-    QString runCmdTree(QString* errorOut = nullptr) const;
+    bool runCmdTree(ReportWriter& w, bool* wroteOut, QString* errorOut = nullptr) const;
 
     /**
      * @brief Собрать список файлов (с учётом исключений), чтобы потом вывести содержимое.
-     * @param dirPath Текущая директория.
-     * @param outFiles Список файлов для чтения.
+     * @param model Модель каталога.
+     * @param outFiles Индексы файлов модели для чтения.
      */
-    void collectFilesRec(const QString& dirPath, QVector<QFileInfo>& outFiles) const;
+    void collectFiles(const DirModel& model, QVector<int>& outFiles) const;
+
+    /** \brief Вес файла по priorityRules (первое совпавшее правило, иначе 0). */
+    int priorityWeight(const DirEntry& file) const;
+
+    /**
+     * @brief Отобрать файлы под бюджет отчёта.
+     * @details Файлы перебираются в порядке приоритета (вес, затем budgetOrder, затем путь);
+     *          файл берётся, если его оценка ещё помещается в остаток. Не поместившийся файл
+     *          пропускается, следующие (меньшие) ещё могут войти.
+     * @param files Файлы в порядке вывода (по путям).
+     * @param costOf Оценка сверху: сколько символов займёт блок файла в отчёте.
+     * @param budget Сколько символов доступно.
+     * @param skipped Не вошедшие файлы (в порядке files).
+     * @return Отобранные файлы в порядке files.
+     */
+    QVector<int> selectWithinBudget(const DirModel& model,
+                                    const QVector<int>& files,
+                                    const std::function<qint64(int)>& costOf,
+                                    qint64 budget,
+                                    QVector<int>* skipped) const;
 
     /**
      * @brief Проверка UTF-8 на валидность (строгая, без "замен").
+     * @details Векторный пропуск ASCII, см. utf8codec.h.
      * @param data Байты.
      */
     static bool isValidUtf8(const QByteArray& data);
@@ -121,31 +424,60 @@ private:
      * @details
      *  - .docx: попытка извлечь текст
      *  - .doc: текст не извлекаем (сообщение)
-     *  - остальное: readTextSmart()
+     *  - остальное: readTextSmart(); двоичное содержимое не читается, вместо текста — пометка
+     *  PDF/DOCX/XLSX сначала ищутся в кэше (если он передан).
+     *  Документы разбираются только при расширении из includeExt (в режиме includeAnyText
+     *  остальное читается как текст).
+     * @param binaryOut (опционально) файл оказался двоичным.
+     * @param extractorOut (опционально) чем извлечён текст (для профиля).
+     * @param beforeDecode (опционально) проверка байт файла до декодирования или разбора
+     *        документа (дедупликация); вернула true — результат пустой.
      */
-    QString readFileForReport(const QFileInfo& file, QString* errorOut = nullptr) const;
+    QString readFileForReport(const DirEntry& file, QString* errorOut = nullptr,
+                              ExtractionCache* cache = nullptr, bool* binaryOut = nullptr,
+                              ReportProfile::Extractor* extractorOut = nullptr,
+                              const RawContentCheck& beforeDecode = {}) const;
 
     /**
      * @brief Извлекает текст из DOCX.
-     * @details Реализация для Windows: распаковка через PowerShell Expand-Archive
-     *          и чтение word/document.xml.
+     * @details Встроенный ZipReader распаковывает в память только word/document.xml
+     *          (без временных файлов и внешних процессов, на любой ОС).
      */
     QString readDocxText(const QString& docxPath, QString* errorOut = nullptr) const;
 
     /**
-     * @brief Извлекает текст из PDF через внешнюю утилиту pdftotext (Poppler).
-     * @note  Нужен pdftotext.exe рядом с приложением или в PATH.
+     * @brief Извлекает текст из PDF (poppler-cpp в процессе или pdftotext, см. pdftext.h).
+     * @details Учитывает pdfMaxPages, pdfTimeoutMs, лимит вывода и отмену.
+     * @note  Без poppler-cpp нужен pdftotext.exe рядом с приложением или в PATH.
      */
     QString readPdfText(const QString& pdfPath, QString* errorOut = nullptr) const;
 
     /**
      * @brief Извлекает текст из XLSX/XLSM (OpenXML) через распаковку и парсинг XML.
-     * @note  Реализация через PowerShell Expand-Archive (Windows).
+     * @details Листы разбираются потоком по мере распаковки; лимит вывода общий на все листы —
+     *          как только он набран, распаковка останавливается. sharedStrings разбирается лениво.
+     * @note  Нужные XML (workbook, rels, sharedStrings, листы) читаются встроенным ZipReader.
      */
     QString readXlsxText(const QString& xlsxPath, QString* errorOut = nullptr) const;
 
 
-    QString findPdfToTextExe() const;
+    /** \brief Раздел профиля в конце отчёта (при profileAppendix). */
+    void writeProfileAppendix(ReportWriter& w, const ReportProfile* profile) const;
+
+    /** \brief Завершить вывод: сбросить буфер приёмника и проверить ошибки записи. */
+    bool finishWrite(ReportWriter& w, QString* errorOut) const;
+
+    /** \brief Версия экстрактора PDF для ключа кэша (с бэкендом и лимитом страниц). */
+    QString pdfExtractorId() const;
+
+    /** \brief Параметры, от которых зависит текст блока файла (для проверки манифеста). */
+    QString blockFingerprint() const;
+
+    /** \brief Число потоков для извлечения содержимого (из Options::maxParallelReads). */
+    int extractionThreadCount() const;
+
+    /** \brief Число потоков обхода каталога (из Options::scanThreads). */
+    int scanThreadCount() const;
 
     /** \brief Проверка: пользователь запросил отмену. */
     bool isCanceled() const;
@@ -0,0 +1,169 @@
+/**
+ * @file reportmanifest.cpp
+ * @brief Реализация манифеста отчёта.
+ */
+
+#include "reportmanifest.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+
+
+namespace {
+
+constexpr quint32 kMagic = 0x434D4D46;       // "CMMF"
+constexpr quint32 kFormatVersion = 2;   // 2: Block::chars
+
+} // namespace
+
+
+ReportManifest::~ReportManifest()
+{
+    detachReport();
+}
+
+QString ReportManifest::pathForReport(const QString& reportPath)
+{
+    return reportPath + QStringLiteral(".manifest");
+}
+
+void ReportManifest::add(const Block& block)
+{
+    m_index.insert(block.relPath, m_blocks.size());
+    m_blocks.push_back(block);
+}
+
+const ReportManifest::Block* ReportManifest::find(const QString& relPath) const
+{
+    const auto it = m_index.constFind(relPath);
+    return (it == m_index.constEnd()) ? nullptr : &m_blocks.at(it.value());
+}
+
+bool ReportManifest::load(const QString& manifestPath, QString* errorOut)
+{
+    m_blocks.clear();
+    m_index.clear();
+    m_fingerprint.clear();
+
+    QFile f(manifestPath);
+    if (!f.open(QIODevice::ReadOnly))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось открыть манифест: %1").arg(f.errorString());
+        return false;
+    }
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kFormatVersion)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Неизвестный формат манифеста.");
+        return false;
+    }
+
+    in >> m_fingerprint >> count;
+
+    m_blocks.reserve((int)count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        Block b;
+        in >> b.relPath >> b.size >> b.mtimeMs >> b.offset >> b.length >> b.chars;
+        if (in.status() == QDataStream::Ok)
+            add(b);
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        m_blocks.clear();
+        m_index.clear();
+        if (errorOut) *errorOut = QStringLiteral("Манифест повреждён.");
+        return false;
+    }
+
+    return true;
+}
+
+bool ReportManifest::save(const QString& manifestPath, QString* errorOut) const
+{
+    QSaveFile f(manifestPath);
+    if (!f.open(QIODevice::WriteOnly))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось записать манифест: %1").arg(f.errorString());
+        return false;
+    }
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << kMagic << kFormatVersion << m_fingerprint << (quint32)m_blocks.size();
+
+    for (const Block& b : m_blocks)
+        out << b.relPath << b.size << b.mtimeMs << b.offset << b.length << b.chars;
+
+    if (out.status() != QDataStream::Ok || !f.commit())
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось записать манифест: %1").arg(f.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool ReportManifest::attachReport(const QString& reportPath, QString* errorOut)
+{
+    detachReport();
+
+    m_report.setFileName(reportPath);
+    if (!m_report.open(QIODevice::ReadOnly))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось открыть прошлый отчёт: %1").arg(m_report.errorString());
+        return false;
+    }
+
+    m_mapSize = m_report.size();
+    m_map = (m_mapSize > 0) ? m_report.map(0, m_mapSize) : nullptr;
+    if (!m_map)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось отобразить прошлый отчёт в память.");
+        detachReport();
+        return false;
+    }
+
+    // Отчёт мог быть сохранён с BOM — смещения в манифесте считаются без него.
+    m_base = (m_mapSize >= 3 && m_map[0] == 0xEF && m_map[1] == 0xBB && m_map[2] == 0xBF) ? 3 : 0;
+    return true;
+}
+
+void ReportManifest::detachReport()
+{
+    if (m_map)
+        m_report.unmap(const_cast<uchar*>(m_map));
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_base = 0;
+
+    if (m_report.isOpen())
+        m_report.close();
+}
+
+QByteArray ReportManifest::blockBytes(const Block& block) const
+{
+    if (!m_map || block.length <= 0 || block.offset < 0)
+        return {};
+
+    const qint64 begin = m_base + block.offset;
+    if (begin + block.length > m_mapSize)
+        return {};
+
+    const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(m_map + begin),
+                                                     (int)block.length);
+
+    // Быстрая проверка, что это действительно блок нужного файла (отчёт могли править руками).
+    const QByteArray head = QStringLiteral("BEGIN FILE: %1 ").arg(block.relPath).toUtf8();
+    if (!bytes.startsWith('\n') || bytes.indexOf(head) < 0 || bytes.indexOf(head) > 512)
+        return {};
+
+    return bytes;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file reportmanifest.h
+ * @brief Манифест отчёта: какие файлы вошли и где лежат их блоки в выходном файле.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+
+/**
+ * @brief Манифест прошлого прогона для инкрементальной перегенерации.
+ * @details
+ *  Для каждого файла секции 2 хранится: относительный путь, размер, mtime и
+ *  диапазон байтов его блока (```text ... ```) в UTF-8 выводе генератора.
+ *  Если файл не изменился, его блок копируется из прошлого отчёта как есть,
+ *  без чтения и извлечения исходника.
+ *
+ *  fingerprint описывает параметры, от которых зависит текст блока
+ *  (лимит вывода, режим кодировки, версии экстракторов); при несовпадении
+ *  прошлый отчёт не используется.
+ */
+class ReportManifest
+{
+public:
+    /** \brief Блок одного файла в отчёте. */
+    struct Block
+    {
+        QString relPath;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        qint64 offset = 0;   ///< Смещение блока в байтах от начала вывода генератора (без BOM).
+        qint64 length = 0;   ///< Длина блока в байтах.
+        qint64 chars = 0;    ///< Длина блока в символах UTF-16 — в них считается бюджет отчёта.
+    };
+
+    ReportManifest() = default;
+    ~ReportManifest();
+
+    ReportManifest(const ReportManifest&) = delete;
+    ReportManifest& operator=(const ReportManifest&) = delete;
+
+    /** \brief Путь манифеста рядом с отчётом: <отчёт>.manifest. */
+    static QString pathForReport(const QString& reportPath);
+
+    QString fingerprint() const { return m_fingerprint; }
+    void setFingerprint(const QString& fp) { m_fingerprint = fp; }
+
+    /** \brief Добавить блок (порядок сохраняется). */
+    void add(const Block& block);
+
+    /** \brief Найти блок по относительному пути (nullptr если нет). */
+    const Block* find(const QString& relPath) const;
+
+    const QVector<Block>& blocks() const { return m_blocks; }
+    bool isEmpty() const { return m_blocks.isEmpty(); }
+
+    bool load(const QString& manifestPath, QString* errorOut = nullptr);
+    bool save(const QString& manifestPath, QString* errorOut = nullptr) const;
+
+    /**
+     * @brief Подключить прошлый отчёт, чтобы брать из него блоки.
+     * @details Файл отображается в память; BOM в начале учитывается.
+     *          Блоки, выходящие за пределы файла, при этом отбрасываются.
+     */
+    bool attachReport(const QString& reportPath, QString* errorOut = nullptr);
+
+    /** \brief Отключить прошлый отчёт (до замены файла отчёта новым). */
+    void detachReport();
+
+    /**
+     * @brief Байты блока из прошлого отчёта (без копирования, пока отчёт подключён).
+     * @return пустой массив, если отчёт не подключён или блок не похож на ожидаемый.
+     */
+    QByteArray blockBytes(const Block& block) const;
+
+private:
+    QString m_fingerprint;
+    QVector<Block> m_blocks;
+    QHash<QString, int> m_index;
+
+    QFile m_report;
+    const uchar* m_map = nullptr;
+    qint64 m_mapSize = 0;
+    qint64 m_base = 0;   ///< Размер BOM в начале прошлого отчёта.
+};
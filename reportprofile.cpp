@@ -0,0 +1,272 @@
+/**
+ * @file reportprofile.cpp
+ * @brief Реализация профиля генерации.
+ */
+
+#include "reportprofile.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+
+
+namespace {
+
+QString formatMs(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 1);
+}
+
+/** \brief Путь в ячейке таблицы Markdown: '|' разбил бы строку на столбцы. */
+QString tableCell(QString text)
+{
+    text.replace(QLatin1Char('|'), QStringLiteral("\\|"));
+    return text;
+}
+
+} // namespace
+
+
+const char* ReportProfile::extractorName(Extractor e)
+{
+    switch (e)
+    {
+    case Extractor::Text:      return "text";
+    case Extractor::Binary:    return "binary";
+    case Extractor::Docx:      return "docx";
+    case Extractor::Xlsx:      return "xlsx";
+    case Extractor::Pdf:       return "pdf";
+    case Extractor::Cache:     return "cache";
+    case Extractor::Stub:      return "stub";
+    case Extractor::Duplicate: return "duplicate";
+    case Extractor::Count:     break;
+    }
+    return "?";
+}
+
+void ReportProfile::start()
+{
+    QMutexLocker lock(&m_mutex);
+    m_phases.clear();
+    m_files.clear();
+    for (ExtractorStats& s : m_extractors)
+        s = ExtractorStats();
+    m_threads.clear();
+    threadIndexLocked();
+    m_clock.start();
+}
+
+qint64 ReportProfile::nowUs() const
+{
+    return m_clock.isValid() ? m_clock.nsecsElapsed() / 1000 : 0;
+}
+
+int ReportProfile::threadIndexLocked()
+{
+    const quintptr id = quintptr(QThread::currentThreadId());
+    auto it = m_threads.constFind(id);
+    if (it != m_threads.constEnd())
+        return it.value();
+    const int index = m_threads.size();
+    m_threads.insert(id, index);
+    return index;
+}
+
+void ReportProfile::addPhase(const QString& name, qint64 startUs)
+{
+    const qint64 endUs = nowUs();
+
+    QMutexLocker lock(&m_mutex);
+    PhaseSpan span;
+    span.name = name;
+    span.startUs = startUs;
+    span.durUs = std::max<qint64>(0, endUs - startUs);
+    span.thread = threadIndexLocked();
+    m_phases.push_back(span);
+}
+
+void ReportProfile::addFile(FileSpan span)
+{
+    QMutexLocker lock(&m_mutex);
+    span.thread = threadIndexLocked();
+
+    ExtractorStats& s = m_extractors[int(span.extractor)];
+    ++s.calls;
+    if (span.error)
+        ++s.errors;
+    s.bytesIn += span.bytesIn;
+    s.charsOut += span.charsOut;
+    s.totalUs += span.durUs;
+    s.maxUs = std::max(s.maxUs, span.durUs);
+
+    m_files.push_back(std::move(span));
+}
+
+QVector<ReportProfile::PhaseSpan> ReportProfile::phases() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_phases;
+}
+
+ReportProfile::ExtractorStats ReportProfile::extractorStats(Extractor e) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_extractors[int(e)];
+}
+
+QVector<ReportProfile::FileSpan> ReportProfile::slowestFiles(int n) const
+{
+    QVector<FileSpan> files;
+    {
+        QMutexLocker lock(&m_mutex);
+        files = m_files;
+    }
+
+    n = std::clamp(n, 0, int(files.size()));
+    std::partial_sort(files.begin(), files.begin() + n, files.end(),
+                      [](const FileSpan& a, const FileSpan& b) { return a.durUs > b.durUs; });
+    files.resize(n);
+    return files;
+}
+
+qint64 ReportProfile::totalUs() const
+{
+    QMutexLocker lock(&m_mutex);
+    qint64 end = 0;
+    for (const PhaseSpan& p : m_phases)
+        end = std::max(end, p.startUs + p.durUs);
+    return end;
+}
+
+QStringList ReportProfile::toMarkdown(int slowest) const
+{
+    QStringList out;
+    out << QStringLiteral("## 3. Профиль генерации");
+    out << QStringLiteral("*(время на момент вывода этого раздела: %1 мс)*").arg(formatMs(nowUs()));
+    out << QString();
+
+    out << QStringLiteral("| Фаза | начало, мс | длительность, мс |");
+    out << QStringLiteral("|---|---:|---:|");
+    for (const PhaseSpan& p : phases())
+        out << QStringLiteral("| %1 | %2 | %3 |").arg(p.name, formatMs(p.startUs), formatMs(p.durUs));
+    out << QString();
+
+    out << QStringLiteral("| Экстрактор | файлов | ошибок | байт на входе | символов на выходе | всего, мс | макс, мс |");
+    out << QStringLiteral("|---|---:|---:|---:|---:|---:|---:|");
+    for (int i = 0; i < int(Extractor::Count); ++i)
+    {
+        const ExtractorStats s = extractorStats(Extractor(i));
+        if (s.calls == 0)
+            continue;
+        out << QStringLiteral("| %1 | %2 | %3 | %4 | %5 | %6 | %7 |")
+                   .arg(QLatin1String(extractorName(Extractor(i))))
+                   .arg(s.calls)
+                   .arg(s.errors)
+                   .arg(s.bytesIn)
+                   .arg(s.charsOut)
+                   .arg(formatMs(s.totalUs), formatMs(s.maxUs));
+    }
+
+    const QVector<FileSpan> top = slowestFiles(slowest);
+    if (!top.isEmpty())
+    {
+        out << QString();
+        out << QStringLiteral("### Самые долгие файлы");
+        out << QStringLiteral("| Файл | экстрактор | байт | мс |");
+        out << QStringLiteral("|---|---|---:|---:|");
+        for (const FileSpan& f : top)
+        {
+            out << QStringLiteral("| %1 | %2%3 | %4 | %5 |")
+                       .arg(tableCell(f.path), QLatin1String(extractorName(f.extractor)),
+                            f.error ? QStringLiteral(" (ошибка)") : QString())
+                       .arg(f.bytesIn)
+                       .arg(formatMs(f.durUs));
+        }
+    }
+    return out;
+}
+
+QByteArray ReportProfile::toChromeTrace() const
+{
+    QVector<PhaseSpan> phasesCopy;
+    QVector<FileSpan> filesCopy;
+    int threads = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        phasesCopy = m_phases;
+        filesCopy = m_files;
+        threads = m_threads.size();
+    }
+
+    QJsonArray events;
+
+    for (int t = 0; t < threads; ++t)
+    {
+        QJsonObject meta;
+        meta.insert(QStringLiteral("ph"), QStringLiteral("M"));
+        meta.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+        meta.insert(QStringLiteral("pid"), 1);
+        meta.insert(QStringLiteral("tid"), t);
+        meta.insert(QStringLiteral("args"), QJsonObject { { QStringLiteral("name"),
+                                                            t == 0 ? QStringLiteral("generator")
+                                                                   : QStringLiteral("worker %1").arg(t) } });
+        events.push_back(meta);
+    }
+
+    for (const PhaseSpan& p : phasesCopy)
+    {
+        QJsonObject e;
+        e.insert(QStringLiteral("name"), p.name);
+        e.insert(QStringLiteral("cat"), QStringLiteral("phase"));
+        e.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        e.insert(QStringLiteral("ts"), double(p.startUs));
+        e.insert(QStringLiteral("dur"), double(p.durUs));
+        e.insert(QStringLiteral("pid"), 1);
+        e.insert(QStringLiteral("tid"), p.thread);
+        events.push_back(e);
+    }
+
+    for (const FileSpan& f : filesCopy)
+    {
+        QJsonObject args;
+        args.insert(QStringLiteral("path"), f.path);
+        args.insert(QStringLiteral("bytesIn"), double(f.bytesIn));
+        args.insert(QStringLiteral("charsOut"), double(f.charsOut));
+        if (f.error)
+            args.insert(QStringLiteral("error"), true);
+
+        QJsonObject e;
+        e.insert(QStringLiteral("name"), QLatin1String(extractorName(f.extractor)));
+        e.insert(QStringLiteral("cat"), QStringLiteral("file"));
+        e.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        e.insert(QStringLiteral("ts"), double(f.startUs));
+        e.insert(QStringLiteral("dur"), double(f.durUs));
+        e.insert(QStringLiteral("pid"), 1);
+        e.insert(QStringLiteral("tid"), f.thread);
+        e.insert(QStringLiteral("args"), args);
+        events.push_back(e);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool ReportProfile::saveChromeTrace(const QString& path, QString* errorOut) const
+{
+    const QByteArray json = toChromeTrace();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось записать трассу %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file reportprofile.h
+ * @brief Профиль генерации отчёта: время фаз, счётчики экстракторов, самые медленные файлы.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+
+/**
+ * @brief Куда ушло время генерации.
+ * @details
+ *  Генератор отмечает фазы (обход, дерево, отбор, содержимое, ...) и каждое извлечение файла.
+ *  По собранному можно построить приложение к отчёту (toMarkdown()) или трассу
+ *  в формате Chrome trace events (toChromeTrace(): chrome://tracing, Perfetto).
+ *
+ *  Время — в микросекундах от start(). Потокобезопасен: файлы отмечаются из рабочих потоков.
+ *  Объект принадлежит вызывающему и передаётся через ReportGenerator::Options::profile.
+ */
+class ReportProfile
+{
+public:
+    /** \brief Чем извлекался файл. */
+    enum class Extractor
+    {
+        Text,       ///< Текстовый файл (readTextSmart).
+        Binary,     ///< Двоичный по содержимому: прочитано только начало.
+        Docx,
+        Xlsx,
+        Pdf,
+        Cache,      ///< PDF/DOCX/XLSX из кэша извлечения.
+        Stub,       ///< .doc/.xls: только пометка, файл не читается.
+        Duplicate,  ///< Только хэш содержимого: двойник уже есть.
+        Count
+    };
+
+    /** \brief Короткое имя экстрактора ("text", "pdf", ...). */
+    static const char* extractorName(Extractor e);
+
+    /** \brief Отрезок времени фазы. */
+    struct PhaseSpan
+    {
+        QString name;
+        qint64 startUs = 0;
+        qint64 durUs = 0;
+        int thread = 0;
+    };
+
+    /** \brief Извлечение одного файла. */
+    struct FileSpan
+    {
+        QString path;          ///< Путь от корня (как в отчёте).
+        Extractor extractor = Extractor::Text;
+        qint64 bytesIn = 0;    ///< Размер исходного файла.
+        qint64 charsOut = 0;   ///< Символов текста после извлечения.
+        qint64 startUs = 0;
+        qint64 durUs = 0;
+        int thread = 0;
+        bool error = false;
+    };
+
+    /** \brief Итог по экстрактору. */
+    struct ExtractorStats
+    {
+        qint64 calls = 0;
+        qint64 errors = 0;
+        qint64 bytesIn = 0;
+        qint64 charsOut = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+    };
+
+    /** \brief Начать новый прогон: всё собранное сбрасывается, часы — с нуля. */
+    void start();
+
+    /** \brief Микросекунд от start(). */
+    qint64 nowUs() const;
+
+    /** \brief Отметить фазу [startUs, nowUs()) текущего потока. */
+    void addPhase(const QString& name, qint64 startUs);
+
+    /** \brief Отметить извлечение файла (thread заполняется здесь). */
+    void addFile(FileSpan span);
+
+    QVector<PhaseSpan> phases() const;
+    ExtractorStats extractorStats(Extractor e) const;
+
+    /** \brief n самых долгих извлечений, по убыванию времени. */
+    QVector<FileSpan> slowestFiles(int n) const;
+
+    /** \brief Отрезок от start() до конца последней отмеченной фазы. */
+    qint64 totalUs() const;
+
+    /**
+     * @brief Приложение к отчёту: таблицы фаз, экстракторов и самых медленных файлов.
+     * @details Первая строка — заголовок раздела "## 3. ..."; завершающей пустой строки нет.
+     */
+    QStringList toMarkdown(int slowest) const;
+
+    /** \brief JSON в формате Chrome trace events (фазы и файлы — события "X" по потокам). */
+    QByteArray toChromeTrace() const;
+
+    /** \brief Записать toChromeTrace() в файл (через QSaveFile). */
+    bool saveChromeTrace(const QString& path, QString* errorOut = nullptr) const;
+
+    /**
+     * @brief Фаза на время жизни объекта.
+     * @details С profile == nullptr ничего не делает — удобно для необязательного профиля.
+     */
+    class Scope
+    {
+    public:
+        Scope(ReportProfile* profile, const QString& name)
+            : m_profile(profile), m_name(name), m_startUs(profile ? profile->nowUs() : 0)
+        {
+        }
+        ~Scope()
+        {
+            if (m_profile)
+                m_profile->addPhase(m_name, m_startUs);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ReportProfile* m_profile;
+        QString m_name;
+        qint64 m_startUs;
+    };
+
+private:
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<PhaseSpan> m_phases;
+    QVector<FileSpan> m_files;
+    ExtractorStats m_extractors[int(Extractor::Count)];
+    QHash<quintptr, int> m_threads;   ///< Идентификатор потока -> номер (0 — поток, вызвавший start()).
+
+    int threadIndexLocked();
+};
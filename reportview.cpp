@@ -0,0 +1,327 @@
+/**
+ * @file reportview.cpp
+ * @brief Реализация постраничного просмотра отчёта.
+ */
+
+#include "reportview.h"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QListView>
+#include <QScrollBar>
+#include <QSplitter>
+#include <QStringListModel>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextEdit>
+#include <QToolButton>
+#include <QVBoxLayout>
+#include <algorithm>
+
+
+namespace {
+
+const QString kBeginMarker = QStringLiteral("\n----- BEGIN FILE: ");
+
+/** \brief Граница раздела/блока в отчёте и её подпись в оглавлении. */
+struct Marker
+{
+    int pos = 0;          ///< Начало строки, с которой начинается раздел/блок.
+    QString title;        ///< Подпись в оглавлении.
+    QString anchor;       ///< Текст для поиска в отрисованном Markdown.
+};
+
+} // namespace
+
+
+ReportView::ReportView(QWidget* parent)
+    : QWidget(parent)
+{
+    m_outlineView = new QListView(this);
+    m_outlineModel = new QStringListModel(this);
+    m_outlineView->setModel(m_outlineModel);
+    m_outlineView->setUniformItemSizes(true);   // оглавление на сотни тысяч файлов без пересчёта высот
+    m_outlineView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    m_text = new QTextEdit(this);
+    m_text->setReadOnly(true);
+
+    m_cbMarkdown = new QCheckBox(QStringLiteral("Markdown"), this);
+    m_cbMarkdown->setChecked(true);
+    m_cbMarkdown->setToolTip(QStringLiteral("Рисовать страницу как Markdown (иначе — обычный текст, быстрее)"));
+
+    m_pbPrev = new QToolButton(this);
+    m_pbPrev->setArrowType(Qt::LeftArrow);
+    m_pbNext = new QToolButton(this);
+    m_pbNext->setArrowType(Qt::RightArrow);
+    m_pageLabel = new QLabel(this);
+
+    auto* nav = new QHBoxLayout();
+    nav->setContentsMargins(0, 0, 0, 0);
+    nav->addWidget(m_pbPrev);
+    nav->addWidget(m_pageLabel);
+    nav->addWidget(m_pbNext);
+    nav->addStretch(1);
+    nav->addWidget(m_cbMarkdown);
+
+    auto* splitter = new QSplitter(Qt::Horizontal, this);
+    splitter->addWidget(m_outlineView);
+    splitter->addWidget(m_text);
+    splitter->setStretchFactor(0, 1);
+    splitter->setStretchFactor(1, 3);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(nav);
+    layout->addWidget(splitter, 1);
+
+    connect(m_outlineView, &QListView::activated, this, &ReportView::onOutlineActivated);
+    connect(m_outlineView, &QListView::clicked, this, &ReportView::onOutlineActivated);
+    connect(m_pbPrev, &QToolButton::clicked, this, &ReportView::onPrevPage);
+    connect(m_pbNext, &QToolButton::clicked, this, &ReportView::onNextPage);
+    connect(m_cbMarkdown, &QCheckBox::toggled, this, &ReportView::onMarkdownToggled);
+
+    refreshNav();
+}
+
+void ReportView::setReport(const QString& markdown, bool keepPosition)
+{
+    const int oldPage = m_currentPage;
+    const int oldScroll = m_text->verticalScrollBar()->value();
+
+    m_report = markdown;
+
+    QStringList titles;
+    buildIndex(titles);
+    m_outlineModel->setStringList(titles);
+
+    // Оглавление нужно только там, где есть что листать.
+    m_outlineView->setVisible(m_pages.size() > 1);
+
+    m_currentPage = -1;
+    if (keepPosition && oldPage >= 0 && !m_pages.isEmpty())
+    {
+        showPage(std::min(oldPage, int(m_pages.size()) - 1));
+        m_text->verticalScrollBar()->setValue(oldScroll);
+        return;
+    }
+    showPage(0);
+}
+
+void ReportView::clear()
+{
+    m_report.clear();
+    m_pages.clear();
+    m_outline.clear();
+    m_anchors.clear();
+    m_outlineModel->setStringList({});
+    m_currentPage = -1;
+    m_text->clear();
+    refreshNav();
+}
+
+void ReportView::buildIndex(QStringList& titles)
+{
+    m_pages.clear();
+    m_outline.clear();
+    m_anchors.clear();
+    titles.clear();
+
+    const int size = m_report.size();
+    if (size == 0)
+        return;
+
+    // Небольшой отчёт — одной страницей, как раньше.
+    if (size <= kMaxMarkdownChars)
+        m_pages.push_back(Page{0, size, true});
+
+    QVector<Marker> markers;
+
+    // Блоки файлов: начало блока — строка с fence перед "----- BEGIN FILE: ".
+    for (int p = m_report.indexOf(kBeginMarker); p >= 0; p = m_report.indexOf(kBeginMarker, p + 1))
+    {
+        const int fenceStart = m_report.lastIndexOf(QLatin1Char('\n'), p - 1) + 1;
+        const int lineEnd = m_report.indexOf(QLatin1Char('\n'), p + 1);
+        const QString line = m_report.mid(p + 1, (lineEnd < 0 ? size : lineEnd) - p - 1);
+
+        QString title = line.mid(kBeginMarker.size() - 1);
+        const int bracket = title.lastIndexOf(QStringLiteral(" ["));
+        if (bracket > 0)
+            title.truncate(bracket);
+
+        markers.push_back(Marker{fenceStart, QStringLiteral("    ") + title, line});
+    }
+
+    // Разделы: строки "## ..." до первого блока (внутри блоков могут быть свои заголовки из .md файлов).
+    const int sectionsEnd = markers.isEmpty() ? size : markers.first().pos;
+    markers.push_back(Marker{0, m_report.left(m_report.indexOf(QLatin1Char('\n'))), QString()});
+    for (int p = m_report.indexOf(QStringLiteral("\n## ")); p >= 0 && p < sectionsEnd;
+         p = m_report.indexOf(QStringLiteral("\n## "), p + 1))
+    {
+        const int lineEnd = m_report.indexOf(QLatin1Char('\n'), p + 1);
+        const QString line = m_report.mid(p + 1, (lineEnd < 0 ? size : lineEnd) - p - 1);
+        markers.push_back(Marker{p + 1, line, line.mid(3)});
+    }
+
+    std::sort(markers.begin(), markers.end(), [](const Marker& a, const Marker& b){
+        return a.pos < b.pos;
+    });
+
+    if (m_pages.isEmpty())
+    {
+        // Жадно набираем страницы из целых разделов/блоков до kPageChars.
+        int pageBegin = 0;
+        int prev = 0;
+        for (const Marker& m : std::as_const(markers))
+        {
+            if (m.pos - pageBegin > kPageChars && prev > pageBegin)
+            {
+                addPages(pageBegin, prev);
+                pageBegin = prev;
+            }
+            prev = m.pos;
+        }
+
+        if (size - pageBegin > kPageChars && prev > pageBegin)
+        {
+            addPages(pageBegin, prev);
+            pageBegin = prev;
+        }
+        addPages(pageBegin, size);
+    }
+
+    m_outline.reserve(markers.size());
+    m_anchors.reserve(markers.size());
+    titles.reserve(markers.size());
+    for (const Marker& m : std::as_const(markers))
+    {
+        const int page = pageAt(m.pos);
+        m_outline.push_back(OutlineItem{page, m.pos - m_pages.at(page).begin});
+        m_anchors.push_back(m.anchor);
+        titles.push_back(m.title);
+    }
+}
+
+void ReportView::addPages(int begin, int end)
+{
+    if (end - begin <= kPageChars)
+    {
+        m_pages.push_back(Page{begin, end - begin, true});
+        return;
+    }
+
+    // Один огромный блок: режем по строкам, такие куски рисуются только как текст.
+    while (begin < end)
+    {
+        int cut = end;
+        if (end - begin > kPageChars)
+        {
+            cut = m_report.lastIndexOf(QLatin1Char('\n'), begin + kPageChars);
+            cut = (cut > begin) ? cut + 1 : begin + kPageChars;
+        }
+        m_pages.push_back(Page{begin, cut - begin, false});
+        begin = cut;
+    }
+}
+
+int ReportView::pageAt(int pos) const
+{
+    const auto it = std::upper_bound(m_pages.cbegin(), m_pages.cend(), pos, [](int p, const Page& page){
+        return p < page.begin;
+    });
+    return std::max(0, int(it - m_pages.cbegin()) - 1);
+}
+
+void ReportView::showPage(int page, int offset)
+{
+    if (page < 0 || page >= m_pages.size())
+    {
+        refreshNav();
+        return;
+    }
+
+    const Page& pg = m_pages.at(page);
+    const bool markdown = m_cbMarkdown->isChecked() && pg.whole && pg.length <= kMaxMarkdownChars;
+
+    if (page != m_currentPage || markdown != m_currentMarkdown)
+    {
+        const QString text = m_report.mid(pg.begin, pg.length);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        if (markdown)
+            m_text->setMarkdown(text);
+        else
+            m_text->setPlainText(text);
+#else
+        m_text->setPlainText(text);
+#endif
+        m_currentPage = page;
+        m_currentMarkdown = markdown;
+    }
+
+    if (offset <= 0)
+    {
+        m_text->moveCursor(QTextCursor::Start);
+        m_text->verticalScrollBar()->setValue(0);
+    }
+    else
+    {
+        QTextCursor c(m_text->document());
+        if (m_currentMarkdown)
+        {
+            // После вёрстки Markdown позиции в тексте другие — ищем подпись блока.
+            const int row = m_outlineView->currentIndex().row();
+            const QString anchor = (row >= 0 && row < m_anchors.size()) ? m_anchors.at(row) : QString();
+            c = anchor.isEmpty() ? QTextCursor(m_text->document()) : m_text->document()->find(anchor);
+        }
+        else
+        {
+            c.setPosition(std::min(offset, m_text->document()->characterCount() - 1));
+        }
+
+        // Сначала в конец, потом к цели — чтобы цель оказалась вверху окна.
+        m_text->moveCursor(QTextCursor::End);
+        m_text->setTextCursor(c);
+        m_text->ensureCursorVisible();
+    }
+
+    refreshNav();
+}
+
+void ReportView::refreshNav()
+{
+    const int count = m_pages.size();
+    m_pbPrev->setEnabled(m_currentPage > 0);
+    m_pbNext->setEnabled(m_currentPage >= 0 && m_currentPage + 1 < count);
+    m_pageLabel->setText(count > 1 ? QStringLiteral("Страница %1 из %2").arg(m_currentPage + 1).arg(count)
+                                   : QString());
+    m_pbPrev->setVisible(count > 1);
+    m_pbNext->setVisible(count > 1);
+}
+
+void ReportView::onOutlineActivated(const QModelIndex& index)
+{
+    const int row = index.row();
+    if (row < 0 || row >= m_outline.size())
+        return;
+
+    const OutlineItem& item = m_outline.at(row);
+    showPage(item.page, item.offset);
+}
+
+void ReportView::onPrevPage()
+{
+    showPage(m_currentPage - 1);
+}
+
+void ReportView::onNextPage()
+{
+    showPage(m_currentPage + 1);
+}
+
+void ReportView::onMarkdownToggled(bool on)
+{
+    Q_UNUSED(on);
+    showPage(m_currentPage);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file reportview.h
+ * @brief Просмотр большого отчёта по страницам, с оглавлением по файлам.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWidget>
+
+class QCheckBox;
+class QLabel;
+class QListView;
+class QModelIndex;
+class QStringListModel;
+class QTextEdit;
+class QToolButton;
+
+
+/**
+ * @brief Виджет просмотра отчёта без вёрстки всего документа.
+ * @details
+ *  QTextEdit::setMarkdown() на отчёте в десятки МБ надолго блокирует GUI и
+ *  занимает в памяти в разы больше самого текста. Здесь отчёт один раз
+ *  размечается на страницы (границы — блоки файлов), а в QTextEdit
+ *  загружается только текущая страница. Слева — оглавление: разделы и файлы.
+ *
+ *  Markdown рисуется только по запросу (галочка) и только для страниц не
+ *  больше kMaxMarkdownChars; остальное показывается как обычный текст.
+ */
+class ReportView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ReportView(QWidget* parent = nullptr);
+
+    /**
+     * @brief Показать отчёт (строка разделяется неявно, копии нет).
+     * @param keepPosition Остаться на той же странице и прокрутке (обновление того же отчёта).
+     */
+    void setReport(const QString& markdown, bool keepPosition = false);
+
+    void clear();
+
+    /** \brief Поле текста текущей страницы (для контекстного меню, стилей и т.п.). */
+    QTextEdit* textView() const { return m_text; }
+
+    /** \brief Целевой размер страницы (символы). */
+    static constexpr int kPageChars = 256 * 1024;
+
+    /** \brief Больше этого страница как Markdown не рисуется. */
+    static constexpr int kMaxMarkdownChars = 1024 * 1024;
+
+private slots:
+    void onOutlineActivated(const QModelIndex& index);
+    void onPrevPage();
+    void onNextPage();
+    void onMarkdownToggled(bool on);
+
+private:
+    /** \brief Страница: диапазон отчёта. */
+    struct Page
+    {
+        int begin = 0;
+        int length = 0;
+        bool whole = true;   ///< false — кусок одного большого блока (Markdown не рисуем).
+    };
+
+    /** \brief Пункт оглавления: страница и смещение внутри неё. */
+    struct OutlineItem
+    {
+        int page = 0;
+        int offset = 0;
+    };
+
+    QString m_report;
+    QVector<Page> m_pages;
+    QVector<OutlineItem> m_outline;
+    QStringList m_anchors;           ///< Для каждого пункта оглавления — текст для поиска в Markdown.
+    int m_currentPage = -1;
+    bool m_currentMarkdown = false;  ///< Текущая страница отрисована как Markdown.
+
+    QListView* m_outlineView = nullptr;
+    QStringListModel* m_outlineModel = nullptr;
+    QTextEdit* m_text = nullptr;
+    QCheckBox* m_cbMarkdown = nullptr;
+    QToolButton* m_pbPrev = nullptr;
+    QToolButton* m_pbNext = nullptr;
+    QLabel* m_pageLabel = nullptr;
+
+    /** \brief Разметить отчёт на страницы и собрать оглавление (один линейный проход). */
+    void buildIndex(QStringList& titles);
+
+    /** \brief Добавить страницы для диапазона [begin, end), разрезая его по строкам. */
+    void addPages(int begin, int end);
+
+    /** \brief Страница, в которую попадает позиция отчёта. */
+    int pageAt(int pos) const;
+
+    /** \brief Показать страницу и прокрутить к смещению внутри неё. */
+    void showPage(int page, int offset = 0);
+
+    void refreshNav();
+};
@@ -0,0 +1,97 @@
+/**
+ * @file reportwatcher.cpp
+ * @brief Реализация слежения за каталогом отчёта.
+ */
+
+#include "reportwatcher.h"
+
+#include <QFileInfo>
+#include <algorithm>
+
+
+ReportWatcher::ReportWatcher(QObject* parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    connect(&m_debounce, &QTimer::timeout, this, &ReportWatcher::onDebounceTimeout);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ReportWatcher::onPathChanged);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ReportWatcher::onFileChanged);
+}
+
+int ReportWatcher::watch(const QStringList& dirs, const QStringList& files)
+{
+    const QStringList oldDirs = m_watcher.directories();
+    const QStringList oldFiles = m_watcher.files();
+    if (!oldDirs.isEmpty())
+        m_watcher.removePaths(oldDirs);
+    if (!oldFiles.isEmpty())
+        m_watcher.removePaths(oldFiles);
+    m_files.clear();
+
+    const int dirCount = std::min<int>(dirs.size(), kMaxWatchedPaths);
+    const int fileCount = std::min<int>(files.size(), kMaxWatchedPaths - dirCount);
+
+    // addPaths() возвращает то, что поставить не удалось (исчезло, нет прав) — это не ошибка.
+    if (dirCount > 0)
+        m_watcher.addPaths(dirs.mid(0, dirCount));
+    if (fileCount > 0)
+    {
+        const QStringList watched = files.mid(0, fileCount);
+        m_watcher.addPaths(watched);
+        for (const QString& f : watched)
+            m_files.insert(f);
+    }
+
+    m_active = true;
+    return int(dirs.size() - dirCount) + int(files.size() - fileCount);
+}
+
+void ReportWatcher::stop()
+{
+    m_active = false;
+    m_debounce.stop();
+    m_pending.clear();
+    m_files.clear();
+
+    const QStringList all = m_watcher.directories() + m_watcher.files();
+    if (!all.isEmpty())
+        m_watcher.removePaths(all);
+}
+
+void ReportWatcher::onPathChanged(const QString& path)
+{
+    noteChange(path);
+}
+
+void ReportWatcher::onFileChanged(const QString& path)
+{
+    // Сохранение через временный файл и rename снимает наблюдение — ставим заново.
+    if (m_files.contains(path) && !m_watcher.files().contains(path) && QFileInfo::exists(path))
+        m_watcher.addPath(path);
+    noteChange(path);
+}
+
+void ReportWatcher::noteChange(const QString& path)
+{
+    if (!m_active)
+        return;
+
+    if (m_pending.isEmpty())
+        m_firstEvent.start();
+    m_pending.insert(path);
+
+    // Серия не длиннее maxDelayMs: таймер не переносится дальше этой границы.
+    const qint64 left = std::max<qint64>(0, m_maxDelayMs - m_firstEvent.elapsed());
+    m_debounce.start(int(std::min<qint64>(m_debounceMs, left)));
+}
+
+void ReportWatcher::onDebounceTimeout()
+{
+    if (m_pending.isEmpty())
+        return;
+
+    QStringList paths = m_pending.values();
+    m_pending.clear();
+    paths.sort();
+    emit changed(paths);
+}
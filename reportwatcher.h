@@ -0,0 +1,77 @@
+/**
+ * @file reportwatcher.h
+ * @brief Слежение за каталогом отчёта: сигнал после серии изменений (с задержкой).
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+
+/**
+ * @brief Наблюдатель за папками и файлами отчёта поверх QFileSystemWatcher.
+ * @details
+ *  Папки наблюдаются ради дерева (создание, удаление, переименование), файлы секции 2 —
+ *  ради содержимого: в Linux (inotify) запись в файл не меняет папку.
+ *  Серия событий (сборка, сохранение в IDE через временный файл) превращается в один
+ *  сигнал changed(): он приходит через debounceMs после последнего события, но не позже
+ *  maxDelayMs после первого — непрерывный поток изменений отчёт не замораживает.
+ *
+ *  Число путей ограничено kMaxWatchedPaths (дескрипторы inotify/ReadDirectoryChangesW
+ *  не бесконечны): сначала берутся папки, затем файлы, лишнее не наблюдается.
+ */
+class ReportWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** \brief Сколько путей наблюдать не больше (папки + файлы). */
+    static constexpr int kMaxWatchedPaths = 8192;
+
+    explicit ReportWatcher(QObject* parent = nullptr);
+
+    /** \brief Пауза после последнего события перед сигналом, мс (по умолчанию 500). */
+    void setDebounceMs(int ms) { m_debounceMs = ms; }
+
+    /** \brief Наибольшая задержка сигнала от первого события серии, мс (по умолчанию 3000). */
+    void setMaxDelayMs(int ms) { m_maxDelayMs = ms; }
+
+    /**
+     * @brief Заменить набор наблюдаемых путей.
+     * @details Накопленные, но ещё не отправленные изменения сохраняются.
+     * @return Сколько путей не поместилось в kMaxWatchedPaths (0 — наблюдаются все).
+     */
+    int watch(const QStringList& dirs, const QStringList& files);
+
+    /** \brief Перестать наблюдать и забыть накопленные изменения. */
+    void stop();
+
+    bool isActive() const { return m_active; }
+
+signals:
+    /** \brief Серия изменений закончилась: изменённые папки и файлы (без повторов). */
+    void changed(const QStringList& paths);
+
+private slots:
+    void onPathChanged(const QString& path);
+    void onFileChanged(const QString& path);
+    void onDebounceTimeout();
+
+private:
+    QFileSystemWatcher m_watcher;
+    QTimer m_debounce;
+    QElapsedTimer m_firstEvent;     ///< Начало текущей серии событий.
+    QSet<QString> m_pending;        ///< Изменённые пути текущей серии.
+    QSet<QString> m_files;          ///< Наблюдаемые файлы (для повторной постановки после замены).
+    int m_debounceMs = 500;
+    int m_maxDelayMs = 3000;
+    bool m_active = false;
+
+    /** \brief Отметить событие и (пере)запустить таймер серии. */
+    void noteChange(const QString& path);
+};
@@ -0,0 +1,264 @@
+/**
+ * @file reportwriter.cpp
+ * @brief Реализация потокового вывода отчёта.
+ */
+
+#include "reportwriter.h"
+
+#include <QIODevice>
+#include <QSaveFile>
+#include <QStringView>
+#include <algorithm>
+
+
+bool StringReportSink::write(const QString& text)
+{
+    if (m_out)
+        m_out->append(text);
+    return true;
+}
+
+
+DeviceReportSink::DeviceReportSink(QIODevice* device, int chunkBytes)
+    : m_device(device)
+    , m_chunkBytes(chunkBytes > 0 ? chunkBytes : 64 * 1024)
+{
+    m_buffer.reserve(m_chunkBytes);
+}
+
+DeviceReportSink::~DeviceReportSink()
+{
+    flush();
+}
+
+bool DeviceReportSink::write(const QString& text)
+{
+    if (!m_error.isEmpty())
+        return false;
+
+    // Длинный текст кодируем частями: копия в UTF-8 не больше chunkBytes символов.
+    const int size = text.size();
+    for (int pos = 0; pos < size; )
+    {
+        int n = std::min(m_chunkBytes, size - pos);
+        // Суррогатную пару не разрываем.
+        if (pos + n < size && text.at(pos + n - 1).isHighSurrogate())
+            --n;
+
+        const QByteArray utf8 = QStringView(text).mid(pos, n).toUtf8();
+        m_buffer += utf8;
+        m_total += utf8.size();
+        pos += n;
+
+        if (m_buffer.size() >= m_chunkBytes && !flush())
+            return false;
+    }
+
+    return true;
+}
+
+bool DeviceReportSink::writeUtf8(const QByteArray& utf8)
+{
+    if (!m_error.isEmpty())
+        return false;
+
+    m_total += utf8.size();
+
+    // Крупный готовый кусок не копируем в буфер, а пишем сразу после него.
+    if (m_buffer.size() + utf8.size() < m_chunkBytes)
+    {
+        m_buffer += utf8;
+        return true;
+    }
+
+    return flush() && writeAll(utf8.constData(), utf8.size());
+}
+
+bool DeviceReportSink::flush()
+{
+    if (!m_error.isEmpty())
+        return false;
+
+    if (m_buffer.isEmpty())
+        return true;
+
+    if (!writeAll(m_buffer.constData(), m_buffer.size()))
+        return false;
+
+    m_buffer.resize(0); // ёмкость буфера сохраняем
+    return true;
+}
+
+bool DeviceReportSink::writeAll(const char* data, qint64 left)
+{
+    if (!m_device)
+    {
+        m_error = QStringLiteral("Не задано устройство вывода.");
+        return false;
+    }
+
+    while (left > 0)
+    {
+        const qint64 n = m_device->write(data, left);
+        if (n <= 0)
+        {
+            m_error = m_device->errorString();
+            if (m_error.isEmpty())
+                m_error = QStringLiteral("Ошибка записи отчёта.");
+            return false;
+        }
+        data += n;
+        left -= n;
+    }
+    return true;
+}
+
+
+namespace {
+
+/**
+ * @brief Длина UTF-8 в единицах UTF-16 без декодирования.
+ * @details Каждый байт, кроме байтов продолжения (10xxxxxx), начинает символ;
+ *          4-байтовый символ (F0..F4) в UTF-16 — суррогатная пара.
+ */
+qint64 utf16Length(const QByteArray& utf8)
+{
+    qint64 n = 0;
+    for (const char ch : utf8)
+    {
+        const auto c = static_cast<unsigned char>(ch);
+        n += ((c & 0xC0) != 0x80) + (c >= 0xF0);
+    }
+    return n;
+}
+
+} // namespace
+
+
+void ReportWriter::put(const QString& text)
+{
+    if (!m_ok)
+        return;
+
+    if (!m_sink.write(text))
+    {
+        m_ok = false;
+        return;
+    }
+    m_chars += text.size();
+}
+
+void ReportWriter::line(const QString& text)
+{
+    if (!m_first)
+        put(QStringLiteral("\n"));
+    m_first = false;
+
+    put(text);
+}
+
+void ReportWriter::lines(const QStringList& list)
+{
+    for (const QString& s : list)
+        line(s);
+}
+
+void ReportWriter::block(const QString& relPath, const QString& text)
+{
+    if (!m_first)
+        put(QStringLiteral("\n"));
+    m_first = false;
+
+    if (m_ok)
+        m_sink.beginBlock(relPath);
+    put(text);
+}
+
+void ReportWriter::rawBlock(const QString& relPath, const QByteArray& utf8)
+{
+    if (m_ok)
+        m_sink.beginBlock(relPath);
+    rawUtf8(utf8);
+}
+
+void ReportWriter::rawUtf8(const QByteArray& utf8)
+{
+    if (!m_ok)
+        return;
+
+    m_first = false;
+    if (!m_sink.writeUtf8(utf8))
+    {
+        m_ok = false;
+        return;
+    }
+    m_chars += utf16Length(utf8);
+}
+
+
+bool saveReportToFile(const QString& text, const QString& path, bool withBom, QString* errorOut)
+{
+    return saveReportToFile(text, path, compressionForPath(path), withBom, errorOut);
+}
+
+bool saveReportToFile(const QString& text, const QString& path, OutputCompression compression,
+                      bool withBom, QString* errorOut)
+{
+    if (!compressionAvailable(compression))
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Эта сборка не умеет сжимать в %1.").arg(compressionSuffix(compression));
+        return false;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось открыть файл для записи:\n%1").arg(file.errorString());
+        return false;
+    }
+
+    CompressedWriteDevice packed(&file, compression);
+    QIODevice* device = &file;
+    if (compression != OutputCompression::None)
+    {
+        if (!packed.open(QIODevice::WriteOnly))
+        {
+            if (errorOut) *errorOut = packed.errorString();
+            file.cancelWriting();
+            return false;
+        }
+        device = &packed;
+    }
+
+    bool ok = true;
+    {
+        DeviceReportSink sink(device, 1024 * 1024);
+        if (withBom)
+            ok = sink.writeUtf8(QByteArray("\xEF\xBB\xBF", 3));
+        ok = ok && sink.write(text) && sink.flush();
+        if (!ok && errorOut)
+            *errorOut = sink.errorString();
+    }
+
+    if (ok && compression != OutputCompression::None && !packed.finish())
+    {
+        ok = false;
+        if (errorOut) *errorOut = packed.errorString();
+    }
+
+    if (!ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    if (!file.commit())
+    {
+        if (errorOut)
+            *errorOut = QStringLiteral("Не удалось записать файл:\n%1").arg(file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file reportwriter.h
+ * @brief Потоковый вывод отчёта: приёмники (sink) и построчный писатель.
+ */
+
+#pragma once
+
+#include "compressedoutput.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+
+
+/**
+ * @brief Приёмник текста отчёта.
+ * @details Генератор отдаёт отчёт кусками по мере готовности, приёмник решает,
+ *          куда их деть: в строку, в файл, в pipe и т.п.
+ */
+class ReportSink
+{
+public:
+    virtual ~ReportSink() = default;
+
+    /**
+     * @brief Записать очередной кусок отчёта.
+     * @return false если запись не удалась (генерация прекращается).
+     */
+    virtual bool write(const QString& text) = 0;
+
+    /**
+     * @brief Записать готовый кусок в UTF-8 (например, блок из прошлого отчёта).
+     * @details По умолчанию декодирует и передаёт в write().
+     */
+    virtual bool writeUtf8(const QByteArray& utf8) { return write(QString::fromUtf8(utf8)); }
+
+    /** \brief Сколько байт UTF-8 уже принято (-1 если приёмник не считает байты). */
+    virtual qint64 bytesWritten() const { return -1; }
+
+    /**
+     * @brief Следующий write() / writeUtf8() — блок файла relPath целиком.
+     * @details Граница, по которой отчёт можно разрезать на части (SplitReportSink);
+     *          остальные приёмники её не замечают.
+     */
+    virtual void beginBlock(const QString& /*relPath*/) {}
+
+    /** \brief Дописать буферизованные данные. */
+    virtual bool flush() { return true; }
+
+    /** \brief Текст последней ошибки записи. */
+    virtual QString errorString() const { return {}; }
+};
+
+
+/**
+ * @brief Приёмник в QString (для отображения в UI).
+ */
+class StringReportSink : public ReportSink
+{
+public:
+    explicit StringReportSink(QString* out) : m_out(out) {}
+
+    bool write(const QString& text) override;
+
+private:
+    QString* m_out = nullptr;
+};
+
+
+/**
+ * @brief Приёмник в QIODevice: кодирует в UTF-8 и пишет кусками.
+ * @details В памяти держится только буфер до chunkBytes, а не весь отчёт; длинный текст
+ *          (хоть весь отчёт одной строкой) тоже кодируется частями по chunkBytes символов.
+ *          BOM не пишется — при необходимости его пишет вызывающий код.
+ */
+class DeviceReportSink : public ReportSink
+{
+public:
+    explicit DeviceReportSink(QIODevice* device, int chunkBytes = 64 * 1024);
+    ~DeviceReportSink() override;
+
+    bool write(const QString& text) override;
+    bool writeUtf8(const QByteArray& utf8) override;
+    qint64 bytesWritten() const override { return m_total; }
+    bool flush() override;
+    QString errorString() const override { return m_error; }
+
+private:
+    QIODevice* m_device = nullptr;
+    QByteArray m_buffer;
+    int m_chunkBytes = 64 * 1024;
+    qint64 m_total = 0;
+    QString m_error;
+
+    bool writeAll(const char* data, qint64 left);
+};
+
+
+/**
+ * @brief Построчный писатель поверх ReportSink.
+ * @details Повторяет семантику QStringList::join('\n'): перевод строки ставится
+ *          между строками, после последней строки его нет.
+ */
+class ReportWriter
+{
+public:
+    explicit ReportWriter(ReportSink& sink) : m_sink(sink) {}
+
+    /** \brief Вывести одну строку (может содержать внутренние '\n'). */
+    void line(const QString& text);
+
+    /** \brief Вывести несколько строк подряд. */
+    void lines(const QStringList& list);
+
+    /**
+     * @brief Вставить готовый фрагмент UTF-8 как есть.
+     * @details Фрагмент должен сам начинаться с '\n' (как блок, записанный через line()),
+     *          поэтому допустим только не первым.
+     */
+    void rawUtf8(const QByteArray& utf8);
+
+    /**
+     * @brief Вывести блок файла секции 2: как line(), но приёмник узнаёт границу блока.
+     * @param relPath Путь файла от корня (как в заголовке блока).
+     */
+    void block(const QString& relPath, const QString& text);
+
+    /** \brief То же для готового блока UTF-8 из прошлого отчёта (см. rawUtf8()). */
+    void rawBlock(const QString& relPath, const QByteArray& utf8);
+
+    /** \brief Текущая позиция вывода в байтах UTF-8 (-1 если приёмник не считает байты). */
+    qint64 bytePos() const { return m_sink.bytesWritten(); }
+
+    /** \brief Запись пока идёт без ошибок. */
+    bool ok() const { return m_ok; }
+
+    /** \brief Сколько символов (UTF-16) уже отдано в приёмник (вставки rawUtf8 — тоже в символах). */
+    qint64 charsWritten() const { return m_chars; }
+
+    ReportSink& sink() { return m_sink; }
+
+private:
+    ReportSink& m_sink;
+    bool m_first = true;
+    bool m_ok = true;
+    qint64 m_chars = 0;
+
+    void put(const QString& text);
+};
+
+
+/**
+ * @brief Сохранить готовый отчёт в файл.
+ * @details UTF-8 кодируется кусками (без второй копии отчёта в памяти), файл пишется
+ *          через QSaveFile — старый файл заменяется только после успешной записи.
+ *          Путь на ".gz" / ".zst" — сжатие на лету (см. compressedoutput.h).
+ *          Можно вызывать из фонового потока.
+ * @param withBom Писать BOM UTF-8 (внутрь сжатого потока, если сжатие).
+ * @return false и errorOut при ошибке.
+ */
+bool saveReportToFile(const QString& text, const QString& path, bool withBom, QString* errorOut);
+
+/** \brief То же с форматом сжатия, заданным явно (путь может быть временным, без ".gz"). */
+bool saveReportToFile(const QString& text, const QString& path, OutputCompression compression,
+                      bool withBom, QString* errorOut);
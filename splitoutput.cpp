@@ -0,0 +1,313 @@
+/**
+ * @file splitoutput.cpp
+ * @brief Реализация вывода отчёта частями.
+ */
+
+#include "splitoutput.h"
+#include "compressedoutput.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringView>
+#include <algorithm>
+
+
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+/** \brief Длинный путь в заголовке — с многоточием посередине: заголовок не выходит из резерва. */
+QString elide(const QString& text, int maxChars = 160)
+{
+    if (text.size() <= maxChars)
+        return text;
+    const int half = maxChars / 2 - 1;
+    return text.left(half) + QStringLiteral("…") + text.right(half);
+}
+
+/**
+ * @brief Путь без сжатия и расширения отчёта: "out/x.md.gz" -> ("out/x", ".md", ".gz").
+ * @details Явно заданное сжатие заменяет суффикс пути: ("out/x.md", Gzip) -> ("out/x", ".md", ".gz").
+ */
+void splitBasePath(const QString& basePath, OutputCompression compression,
+                   QString* stem, QString* ext, QString* packed)
+{
+    *packed = compressionSuffix(compressionForPath(basePath));
+    QString rest = basePath.left(basePath.size() - packed->size());
+    if (compression != OutputCompression::None)
+        *packed = compressionSuffix(compression);
+
+    const QString name = QFileInfo(rest).fileName();
+    const int dot = name.lastIndexOf(QLatin1Char('.'));
+    *ext = dot > 0 ? name.mid(dot) : QString();
+    if (ext->isEmpty() && packed->isEmpty())
+        *ext = QStringLiteral(".md");
+    rest.chop(dot > 0 ? name.size() - dot : 0);
+    *stem = rest;
+}
+
+/** \brief Куда откладывается часть прошлого прогона, пока новые части встают на место. */
+QString backupPath(const QString& partPath)
+{
+    return partPath + QStringLiteral(".bak");
+}
+
+} // namespace
+
+
+SplitReportSink::SplitReportSink(const QString& basePath, qint64 maxPartChars, bool withBom,
+                                 OutputCompression compression)
+    : m_basePath(basePath)
+    , m_maxChars(std::max<qint64>(maxPartChars, 4 * kHeaderReserve))
+    , m_withBom(withBom)
+    , m_compression(compression != OutputCompression::None ? compression : compressionForPath(basePath))
+{
+}
+
+SplitReportSink::~SplitReportSink()
+{
+    if (!m_finished)
+        discard();
+}
+
+QString SplitReportSink::partPath(const QString& basePath, int number, OutputCompression compression)
+{
+    QString stem, ext, packed;
+    splitBasePath(basePath, compression, &stem, &ext, &packed);
+    return stem + QStringLiteral(".part") + QStringLiteral("%1").arg(number, 3, 10, QLatin1Char('0')) + ext + packed;
+}
+
+QString SplitReportSink::manifestPath(const QString& basePath)
+{
+    QString stem, ext, packed;
+    splitBasePath(basePath, OutputCompression::None, &stem, &ext, &packed);
+    return stem + QStringLiteral(".parts.json");
+}
+
+void SplitReportSink::beginBlock(const QString& relPath)
+{
+    m_blockRel = relPath;
+    m_blockNext = true;
+}
+
+bool SplitReportSink::write(const QString& text)
+{
+    if (!m_error.isEmpty())
+        return false;
+
+    if (!m_titleDone)
+    {
+        const int nl = text.indexOf(QLatin1Char('\n'));
+        m_title += (nl < 0) ? text : text.left(nl);
+        m_titleDone = (nl >= 0);
+    }
+
+    const bool isBlock = m_blockNext;
+    m_blockNext = false;
+
+    if (isBlock)
+    {
+        // Блок, который не влезает в начатую часть, целиком уходит в следующую.
+        if (!m_body.isEmpty() && m_body.size() + text.size() > bodyLimit())
+        {
+            if (!closePart(m_body.size(), false))
+                return false;
+            m_body.resize(0);   // ёмкость буфера сохраняем
+            m_bodyStart = 0;
+        }
+        m_files << m_blockRel;
+    }
+
+    m_body += text;
+
+    // Не влезло и в пустую часть — режем по последнему концу строки в пределах части.
+    // Записанное не вырезается после каждой части (это квадратично от длины блока),
+    // а сдвигается один раз в конце.
+    const int limit = int(bodyLimit());
+    while (m_body.size() - m_bodyStart > limit)
+    {
+        int cut = m_bodyStart + int(QStringView(m_body).mid(m_bodyStart, limit).lastIndexOf(QLatin1Char('\n'))) + 1;
+        if (cut <= m_bodyStart)
+        {
+            cut = m_bodyStart + limit;
+            if (m_body.at(cut - 1).isHighSurrogate())
+                --cut;
+        }
+        if (!closePart(cut, false))
+            return false;
+
+        if (isBlock)
+        {
+            m_files << m_blockRel;
+            m_continued = m_blockRel;
+        }
+    }
+
+    if (m_bodyStart > 0)
+    {
+        m_body.remove(0, m_bodyStart);
+        m_bodyStart = 0;
+    }
+    return true;
+}
+
+QString SplitReportSink::header(int number, bool last) const
+{
+    QString title = m_title;
+    if (title.startsWith(QStringLiteral("# ")))
+        title.remove(0, 2);
+
+    QStringList out;
+    out << (last ? QStringLiteral("> Часть %1 из %1 · %2").arg(number).arg(elide(title))
+                 : QStringLiteral("> Часть %1 · %2").arg(number).arg(elide(title)));
+
+    if (m_files.isEmpty())
+        out << QStringLiteral("> Блоков файлов в этой части нет");
+    else if (m_files.size() == 1)
+        out << QStringLiteral("> Файл: %1").arg(elide(m_files.first()));
+    else
+        out << QStringLiteral("> Файлов: %1, с %2 по %3")
+                   .arg(m_files.size())
+                   .arg(elide(m_files.first()), elide(m_files.last()));
+
+    if (!m_continued.isEmpty())
+        out << QStringLiteral("> В начале — продолжение блока %1").arg(elide(m_continued));
+    if (!last)
+        out << QStringLiteral("> Далее: %1").arg(QFileInfo(partPath(m_basePath, number + 1, m_compression)).fileName());
+
+    return out.join(QLatin1Char('\n')) + QStringLiteral("\n\n");
+}
+
+bool SplitReportSink::closePart(int end, bool last)
+{
+    const int number = m_parts.size() + 1;
+
+    Part part;
+    part.path = partPath(m_basePath, number, m_compression);
+    part.tempPath = part.path + QStringLiteral(".partial");
+    part.files = m_files;
+
+    // Заголовок считается до того, как список файлов части сбрасывается.
+    const QString text = header(number, last) + QStringView(m_body).mid(m_bodyStart, end - m_bodyStart).toString();
+    part.chars = text.size();
+
+    QString err;
+    if (!saveReportToFile(text, part.tempPath, m_compression, m_withBom, &err))
+    {
+        m_error = err;
+        return false;
+    }
+
+    m_parts.push_back(part);
+    m_bodyStart = end;
+    m_files.clear();
+    m_continued.clear();
+    return true;
+}
+
+bool SplitReportSink::finish(QString* errorOut)
+{
+    if (m_error.isEmpty())
+        closePart(m_body.size(), true);
+
+    if (!m_error.isEmpty())
+    {
+        if (errorOut) *errorOut = m_error;
+        return false;
+    }
+
+    QJsonArray parts;
+    QJsonObject fileToPart;
+    for (int i = 0; i < m_parts.size(); ++i)
+    {
+        const Part& p = m_parts.at(i);
+        QJsonObject obj;
+        obj.insert(QStringLiteral("file"), QFileInfo(p.path).fileName());
+        obj.insert(QStringLiteral("chars"), double(p.chars));
+        obj.insert(QStringLiteral("files"), QJsonArray::fromStringList(p.files));
+        parts.push_back(obj);
+
+        // Разрезанный блок — по части, где он начинается.
+        for (const QString& f : p.files)
+        {
+            if (!fileToPart.contains(f))
+                fileToPart.insert(f, i + 1);
+        }
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), kFormatVersion);
+    root.insert(QStringLiteral("title"), m_title);
+    root.insert(QStringLiteral("maxPartChars"), double(m_maxChars));
+    root.insert(QStringLiteral("parts"), parts);
+    root.insert(QStringLiteral("files"), fileToPart);
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    // Манифест готовится до переименования частей: его ошибка не оставит новые части
+    // под старым манифестом.
+    const QString path = manifestPath(m_basePath);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+    {
+        m_error = QStringLiteral("Не удалось записать манифест частей %1: %2").arg(path, file.errorString());
+        if (errorOut) *errorOut = m_error;
+        return false;
+    }
+
+    // Части прошлого прогона сначала откладываются в <часть>.bak, потом новые встают на их
+    // место. Любая ошибка до записи манифеста возвращает прошлый отчёт целиком.
+    QStringList backedUp;   // пути частей, отложенных в .bak
+    QStringList placed;     // новые части, уже под своими именами
+    auto rollback = [&](const QString& message) {
+        for (const QString& p : std::as_const(placed))
+            QFile::remove(p);
+        for (const QString& p : std::as_const(backedUp))
+            QFile::rename(backupPath(p), p);
+        file.cancelWriting();
+        m_error = message;
+        if (errorOut) *errorOut = m_error;
+        return false;
+    };
+
+    for (const Part& p : std::as_const(m_parts))
+    {
+        if (!QFile::exists(p.path))
+            continue;
+        QFile::remove(backupPath(p.path));
+        if (!QFile::rename(p.path, backupPath(p.path)))
+            return rollback(QStringLiteral("Не удалось переименовать %1 в %2").arg(p.path, backupPath(p.path)));
+        backedUp << p.path;
+    }
+
+    for (const Part& p : std::as_const(m_parts))
+    {
+        if (!QFile::rename(p.tempPath, p.path))
+            return rollback(QStringLiteral("Не удалось переименовать %1 в %2").arg(p.tempPath, p.path));
+        placed << p.path;
+    }
+
+    if (!file.commit())
+        return rollback(QStringLiteral("Не удалось записать манифест частей %1: %2").arg(path, file.errorString()));
+
+    for (const QString& p : std::as_const(backedUp))
+        QFile::remove(backupPath(p));
+    m_finished = true;
+
+    // Части прошлого прогона, которых в этом нет, иначе выглядели бы продолжением отчёта.
+    for (int n = m_parts.size() + 1; QFile::exists(partPath(m_basePath, n, m_compression)); ++n)
+        QFile::remove(partPath(m_basePath, n, m_compression));
+    return true;
+}
+
+void SplitReportSink::discard()
+{
+    for (const Part& p : std::as_const(m_parts))
+        QFile::remove(p.tempPath);
+    m_parts.clear();
+    m_body.clear();
+    m_bodyStart = 0;
+}
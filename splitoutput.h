@@ -0,0 +1,109 @@
+/**
+ * @file splitoutput.h
+ * @brief Вывод отчёта частями ограниченного размера: report.part001.md, ... и манифест частей.
+ */
+
+#pragma once
+
+#include "reportwriter.h"
+#include "compressedoutput.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * @brief Приёмник, который режет отчёт на нумерованные файлы не больше maxPartChars символов.
+ * @details
+ *  Граница части ставится перед блоком файла (ReportSink::beginBlock()), если блок не влезает
+ *  в текущую часть; блок длиннее части (и текст вне блоков, например огромное дерево)
+ *  режется по концу строки. В памяти — только текущая часть, а не весь отчёт.
+ *
+ *  Каждая часть начинается с короткого заголовка: номер, заголовок отчёта, первый и последний
+ *  файл части и имя следующей части. После finish() рядом пишется манифест
+ *  <имя>.parts.json: части, их размеры и файлы, а также файл -> номер части.
+ *
+ *  Части пишутся во временные файлы (<часть>.partial) и получают свои имена вместе
+ *  с манифестом только в finish(): отменённый или неудачный прогон не трогает прошлый
+ *  отчёт частями. Сжатие (явное или по ".gz" / ".zst" в basePath) — у каждой части своё.
+ *  Байты не считаются (bytesWritten() == -1): манифест инкрементальной сборки
+ *  (ReportManifest) для разрезанного отчёта не пишется.
+ */
+class SplitReportSink : public ReportSink
+{
+public:
+    /** \brief Сколько символов части оставлено под её заголовок. */
+    static constexpr int kHeaderReserve = 1024;
+
+    /** \brief Записанная часть. */
+    struct Part
+    {
+        QString path;
+        QString tempPath;     ///< Куда часть записана до finish().
+        qint64 chars = 0;     ///< Символов вместе с заголовком.
+        QStringList files;    ///< Блоки файлов в части (разрезанный блок — в обеих частях).
+    };
+
+    /**
+     * @param basePath Путь отчёта, от которого строятся имена частей (report.md -> report.part001.md).
+     * @param maxPartChars Предел части в символах, не меньше 4 * kHeaderReserve.
+     * @param withBom Писать BOM UTF-8 в начало каждой части.
+     * @param compression Сжатие частей; None — по расширению basePath.
+     */
+    SplitReportSink(const QString& basePath, qint64 maxPartChars, bool withBom = false,
+                    OutputCompression compression = OutputCompression::None);
+    /** \brief Без finish() временные файлы частей удаляются. */
+    ~SplitReportSink() override;
+
+    SplitReportSink(const SplitReportSink&) = delete;
+    SplitReportSink& operator=(const SplitReportSink&) = delete;
+
+    /** \brief Путь части number (с 1): <база>.part001<расширение>[.gz|.zst]. */
+    static QString partPath(const QString& basePath, int number,
+                            OutputCompression compression = OutputCompression::None);
+
+    /** \brief Путь манифеста частей: <база>.parts.json. */
+    static QString manifestPath(const QString& basePath);
+
+    bool write(const QString& text) override;
+    void beginBlock(const QString& relPath) override;
+    QString errorString() const override { return m_error; }
+
+    /**
+     * @brief Записать последнюю часть, переименовать части в их имена и записать манифест;
+     *        удалить части прошлого прогона с большими номерами.
+     * @details Части прошлого прогона на время переименования откладываются в <часть>.bak;
+     *          при любой ошибке они возвращаются на место, а новые части убираются.
+     */
+    bool finish(QString* errorOut = nullptr);
+
+    /** \brief Удалить временные файлы частей (генерация не удалась); прошлый отчёт остаётся. */
+    void discard();
+
+    const QVector<Part>& parts() const { return m_parts; }
+
+private:
+    QString m_basePath;
+    qint64 m_maxChars = 0;
+    bool m_withBom = false;
+    OutputCompression m_compression = OutputCompression::None;
+
+    QString m_title;              ///< Первая строка отчёта (без "# ").
+    bool m_titleDone = false;
+    QString m_body;               ///< Текст текущей части без заголовка (с m_bodyStart).
+    int m_bodyStart = 0;          ///< Начало текущей части в m_body: уже записанное сдвигается раз за write().
+    QStringList m_files;          ///< Файлы текущей части.
+    QString m_continued;          ///< Файл, блок которого начался в прошлой части.
+    QString m_blockRel;           ///< Файл следующего write() (пусто — не блок).
+    bool m_blockNext = false;
+
+    QVector<Part> m_parts;
+    QString m_error;
+    bool m_finished = false;
+
+    qint64 bodyLimit() const { return m_maxChars - kHeaderReserve; }
+    QString header(int number, bool last) const;
+    /** \brief Записать m_body[m_bodyStart, end) частью; m_bodyStart = end. */
+    bool closePart(int end, bool last);
+};
@@ -0,0 +1,56 @@
+/**
+ * @file textsniff.cpp
+ * @brief Реализация проверки "текст или двоичные данные".
+ */
+
+#include "textsniff.h"
+
+#include <cstring>
+
+
+namespace {
+
+bool hasTextBom(const unsigned char* p, qint64 len)
+{
+    if (len >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+        return true;                                  // UTF-8
+    if (len >= 2 && ((p[0] == 0xFF && p[1] == 0xFE) || (p[0] == 0xFE && p[1] == 0xFF)))
+        return true;                                  // UTF-16 LE/BE (и UTF-32 LE)
+    if (len >= 4 && p[0] == 0x00 && p[1] == 0x00 && p[2] == 0xFE && p[3] == 0xFF)
+        return true;                                  // UTF-32 BE
+    return false;
+}
+
+/** \brief Управляющий байт, которого не бывает в обычном тексте. */
+inline bool isSuspiciousControl(unsigned char c)
+{
+    if (c == 0x7F)
+        return true;
+    if (c >= 0x20)
+        return false;
+    // \t \n \v \f \r, ESC (цветные логи), SUB (конец файла в старых DOS-текстах)
+    return c != 0x09 && c != 0x0A && c != 0x0B && c != 0x0C && c != 0x0D && c != 0x1B && c != 0x1A;
+}
+
+} // namespace
+
+
+bool looksBinary(const char* data, qint64 len)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    const qint64 n = (len < kTextSniffBytes) ? len : kTextSniffBytes;
+    if (n <= 0)
+        return false;
+
+    if (hasTextBom(p, n))
+        return false;
+
+    if (std::memchr(p, 0, size_t(n)))
+        return true;
+
+    qint64 controls = 0;
+    for (qint64 i = 0; i < n; ++i)
+        controls += isSuspiciousControl(p[i]) ? 1 : 0;
+
+    return controls * 16 > n;
+}
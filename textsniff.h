@@ -0,0 +1,22 @@
+/**
+ * @file textsniff.h
+ * @brief Быстрая проверка "текст или двоичные данные" по началу файла.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+
+/** \brief Сколько байт от начала файла смотрит looksBinary(). */
+constexpr qint64 kTextSniffBytes = 8 * 1024;
+
+/**
+ * @brief Похоже ли начало файла на двоичные данные.
+ * @details Смотрит не больше kTextSniffBytes байт:
+ *  - BOM UTF-8/UTF-16/UTF-32 — текст (нули в UTF-16/32 ожидаемы);
+ *  - любой байт 0x00 — двоичные данные (в текстах без BOM NUL не встречается);
+ *  - больше 1/16 управляющих байт (кроме \\t \\n \\r \\f \\v и ESC) — двоичные данные.
+ *  Недопустимый UTF-8 двоичным не считается: это может быть текст в ANSI.
+ */
+bool looksBinary(const char* data, qint64 len);
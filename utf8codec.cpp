@@ -0,0 +1,306 @@
+/**
+ * @file utf8codec.cpp
+ * @brief Реализация строгого UTF-8.
+ * @details
+ *  Исходники почти целиком ASCII, поэтому основное время уходит на поиск следующего
+ *  не-ASCII байта. Он ищется векторно (AVX2 — если компилятор нацелен на AVX2,
+ *  SSE2 — на любом x86-64, NEON — на AArch64); многобайтовые последовательности
+ *  разбираются скалярно. Декодирование сразу пишет UTF-16, без второго прохода fromUtf8().
+ */
+
+#include "utf8codec.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CONTEXTMAKER_UTF8_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONTEXTMAKER_UTF8_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CONTEXTMAKER_UTF8_NEON 1
+#endif
+
+
+namespace {
+
+/**
+ * @brief Длина ASCII-участка в начале p.
+ * @details Векторный цикл останавливается на блоке с не-ASCII байтом,
+ *          точную позицию добирает скалярный хвост.
+ */
+inline qint64 asciiRun(const unsigned char* p, qint64 len)
+{
+    qint64 i = 0;
+
+#if defined(CONTEXTMAKER_UTF8_AVX2)
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        if (_mm256_movemask_epi8(v) != 0)
+            break;
+    }
+#endif
+
+#if defined(CONTEXTMAKER_UTF8_SSE2)
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(v) != 0)
+            break;
+    }
+#elif defined(CONTEXTMAKER_UTF8_NEON)
+    for (; i + 16 <= len; i += 16)
+    {
+        if (vmaxvq_u8(vld1q_u8(p + i)) >= 0x80)
+            break;
+    }
+#endif
+
+    while (i < len && p[i] < 0x80)
+        ++i;
+    return i;
+}
+
+/**
+ * @brief То же, что asciiRun(), но ASCII-участок сразу расширяется в UTF-16.
+ */
+inline qint64 asciiWiden(const unsigned char* p, qint64 len, char16_t* out)
+{
+    qint64 i = 0;
+    auto* dst = reinterpret_cast<std::uint16_t*>(out);
+
+#if defined(CONTEXTMAKER_UTF8_AVX2)
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        if (_mm256_movemask_epi8(v) != 0)
+            break;
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 16),
+                            _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+    }
+#endif
+
+#if defined(CONTEXTMAKER_UTF8_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(v) != 0)
+            break;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#elif defined(CONTEXTMAKER_UTF8_NEON)
+    for (; i + 16 <= len; i += 16)
+    {
+        const uint8x16_t v = vld1q_u8(p + i);
+        if (vmaxvq_u8(v) >= 0x80)
+            break;
+
+        vst1q_u16(dst + i, vmovl_u8(vget_low_u8(v)));
+        vst1q_u16(dst + i + 8, vmovl_high_u8(v));
+    }
+#endif
+
+    while (i < len && p[i] < 0x80)
+    {
+        dst[i] = p[i];
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * @brief Разобрать одну многобайтовую последовательность (p[0] >= 0x80).
+ * @return Длина последовательности, 0 если она недопустима.
+ */
+inline int decodeMultiByte(const unsigned char* p, qint64 left, uint* cpOut)
+{
+    const unsigned char c = p[0];
+
+    int n = 0;      // length of sequence
+    uint cp = 0;    // code point
+
+    if ((c & 0xE0) == 0xC0) { n = 2; cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; }
+    else return 0;
+
+    if (n > left)
+        return 0;
+
+    for (int k = 1; k < n; ++k)
+    {
+        const unsigned char cc = p[k];
+        if ((cc & 0xC0) != 0x80)
+            return 0;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+
+    // Проверка на overlong encoding
+    if (n == 2 && cp < 0x80) return 0;
+    if (n == 3 && cp < 0x800) return 0;
+    if (n == 4 && cp < 0x10000) return 0;
+
+    // Запрет surrogate range
+    if (cp >= 0xD800 && cp <= 0xDFFF) return 0;
+
+    // Максимум Unicode
+    if (cp > 0x10FFFF) return 0;
+
+    *cpOut = cp;
+    return n;
+}
+
+} // namespace
+
+
+bool utf8IsValid(const char* data, qint64 len)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+
+    qint64 i = 0;
+    while (i < len)
+    {
+        i += asciiRun(p + i, len - i);
+        if (i >= len)
+            break;
+
+        uint cp = 0;
+        const int n = decodeMultiByte(p + i, len - i, &cp);
+        if (n == 0)
+            return false;
+        i += n;
+    }
+    return true;
+}
+
+bool utf8IsValidScalar(const char* data, qint64 len)
+{
+    const auto* u8 = reinterpret_cast<const unsigned char*>(data);
+
+    qint64 i = 0;
+    while (i < len)
+    {
+        const unsigned char c = u8[i];
+
+        // 1-byte ASCII
+        if (c <= 0x7F)
+        {
+            ++i;
+            continue;
+        }
+
+        int n = 0;      // length of sequence
+        uint cp = 0;    // code point
+
+        if ((c & 0xE0) == 0xC0) { n = 2; cp = c & 0x1F; }
+        else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; }
+        else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; }
+        else return false;
+
+        if (i + n > len)
+            return false;
+
+        for (int k = 1; k < n; ++k)
+        {
+            const unsigned char cc = u8[i + k];
+            if ((cc & 0xC0) != 0x80)
+                return false;
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+
+        if (n == 2 && cp < 0x80) return false;
+        if (n == 3 && cp < 0x800) return false;
+        if (n == 4 && cp < 0x10000) return false;
+        if (cp >= 0xD800 && cp <= 0xDFFF) return false;
+        if (cp > 0x10FFFF) return false;
+
+        i += n;
+    }
+    return true;
+}
+
+const char* utf8SimdPath()
+{
+#if defined(CONTEXTMAKER_UTF8_AVX2)
+    return "avx2";
+#elif defined(CONTEXTMAKER_UTF8_SSE2)
+    return "sse2";
+#elif defined(CONTEXTMAKER_UTF8_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+qint64 utf8DecodeStrictTo(const char* data, qint64 len, char16_t* out)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+
+    qint64 i = 0;
+    qint64 o = 0;
+    while (i < len)
+    {
+        const qint64 run = asciiWiden(p + i, len - i, out + o);
+        i += run;
+        o += run;
+        if (i >= len)
+            break;
+
+        uint cp = 0;
+        const int n = decodeMultiByte(p + i, len - i, &cp);
+        if (n == 0)
+            return -1;
+        i += n;
+
+        if (cp >= 0x10000)
+        {
+            cp -= 0x10000;
+            out[o++] = char16_t(0xD800 + (cp >> 10));
+            out[o++] = char16_t(0xDC00 + (cp & 0x3FF));
+        }
+        else
+        {
+            out[o++] = char16_t(cp);
+        }
+    }
+    return o;
+}
+
+bool utf8DecodeStrict(const char* data, qint64 len, QString* out)
+{
+    if (len <= 0)
+    {
+        if (out) *out = QString();
+        return true;
+    }
+
+    // Больше INT_MAX символов QString (Qt 5) не вмещает; такие файлы отсекаются лимитом maxBytes раньше.
+    if (len > std::numeric_limits<int>::max())
+        return false;
+
+    QString s(int(len), Qt::Uninitialized);
+    const qint64 n = utf8DecodeStrictTo(data, len, reinterpret_cast<char16_t*>(s.data()));
+    if (n < 0)
+        return false;
+
+    s.truncate(int(n));
+    // Кириллица и т.п.: символов заметно меньше байт — не держим лишнюю ёмкость.
+    if (n < len / 2)
+        s.squeeze();
+
+    if (out) *out = std::move(s);
+    return true;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file utf8codec.h
+ * @brief Строгая проверка и декодирование UTF-8 с быстрым проходом по ASCII (SSE2/AVX2/NEON).
+ */
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+
+/**
+ * @brief Строгая проверка UTF-8 (без "замен").
+ * @details Запрещены: обрезанные и лишние байты продолжения, overlong-кодировки,
+ *          суррогаты U+D800..U+DFFF и всё выше U+10FFFF.
+ *          ASCII-участки пропускаются блоками по 16/32 байта.
+ */
+bool utf8IsValid(const char* data, qint64 len);
+
+/**
+ * @brief Проверка и декодирование за один проход.
+ * @param out Буфер минимум на len единиц UTF-16 (в UTF-16 символов не больше, чем байт в UTF-8).
+ * @return Число записанных единиц UTF-16, или -1 если данные не являются строгим UTF-8.
+ */
+qint64 utf8DecodeStrictTo(const char* data, qint64 len, char16_t* out);
+
+/**
+ * @brief Проверка и декодирование в QString за один проход.
+ * @return false если данные не являются строгим UTF-8 (out не меняется).
+ */
+bool utf8DecodeStrict(const char* data, qint64 len, QString* out);
+
+/**
+ * @brief Эталон: побайтовый автомат без векторного пропуска ASCII (прежняя isValidUtf8()).
+ * @details Медленный; нужен только для сверки с utf8IsValid() (ContextMakerBench, сценарий
+ *          utf8-selfcheck) на каждой платформе и наборе инструкций.
+ */
+bool utf8IsValidScalar(const char* data, qint64 len);
+
+/** \brief Каким набором инструкций пропускается ASCII в этой сборке: "avx2", "sse2", "neon" или "scalar". */
+const char* utf8SimdPath();
@@ -0,0 +1,645 @@
+/**
+ * @file zipreader.cpp
+ * @brief Реализация минимального читателя ZIP.
+ */
+
+#include "zipreader.h"
+
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace {
+
+/** \brief Размер куска, который отдаётся обработчику. */
+constexpr int kChunkBytes = 256 * 1024;
+
+constexpr quint32 kSigEocd = 0x06054b50;
+constexpr quint32 kSigCentral = 0x02014b50;
+constexpr quint32 kSigLocal = 0x04034b50;
+
+quint16 rd16(const uchar* p) { return qFromLittleEndian<quint16>(p); }
+quint32 rd32(const uchar* p) { return qFromLittleEndian<quint32>(p); }
+
+
+#ifndef CONTEXTMAKER_HAVE_ZLIB
+
+/**
+ * @brief Канонический код Хаффмана, декодирование по таблице.
+ * @details Запись таблицы: (символ << 4) | длина кода; 0 — нет такого кода.
+ *          Таблица индексируется следующими `bits` битами потока (младший бит первый).
+ */
+struct Huffman
+{
+    QVector<quint16> table;
+    int bits = 0;
+
+    bool build(const quint8* lengths, int n)
+    {
+        int count[16] = {0};
+        int maxLen = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            ++count[lengths[i]];
+            maxLen = std::max(maxLen, (int)lengths[i]);
+        }
+        count[0] = 0;
+
+        table.clear();
+        bits = maxLen;
+        if (maxLen == 0)
+            return true; // пустое дерево допустимо (например, нет дистанций)
+
+        // Переподписанный код — ошибка; неполный допускаем (один код дистанции и т.п.).
+        int left = 1;
+        for (int len = 1; len <= 15; ++len)
+        {
+            left <<= 1;
+            left -= count[len];
+            if (left < 0)
+                return false;
+        }
+
+        int next[16] = {0};
+        int code = 0;
+        for (int len = 1; len <= 15; ++len)
+        {
+            code = (code + count[len - 1]) << 1;
+            next[len] = code;
+        }
+
+        table.fill(0, 1 << maxLen);
+        for (int sym = 0; sym < n; ++sym)
+        {
+            const int len = lengths[sym];
+            if (len == 0)
+                continue;
+
+            const int c = next[len]++;
+            int rev = 0;
+            for (int k = 0; k < len; ++k)
+                rev |= ((c >> k) & 1) << (len - 1 - k);
+
+            const quint16 e = (quint16)((sym << 4) | len);
+            for (int k = rev; k < (1 << maxLen); k += (1 << len))
+                table[k] = e;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Встроенный inflate (RFC 1951, raw deflate без заголовка zlib).
+ * @details Выход копится в буфере; готовые куски отдаются обработчику,
+ *          в буфере остаются последние 32 КиБ — окно для обратных ссылок.
+ */
+class Inflater
+{
+public:
+    Inflater(const uchar* in, qint64 size, const ZipReader::ChunkHandler& onChunk)
+        : m_in(in), m_inSize(size), m_onChunk(onChunk)
+    {
+        m_out.reserve(kChunkBytes + kWindow + 512);
+    }
+
+    bool run(QString* errorOut)
+    {
+        bool last = false;
+        while (!last && !m_stopped)
+        {
+            last = bits(1) != 0;
+            const int type = (int)bits(2);
+
+            bool ok = false;
+            if (type == 0)
+                ok = stored();
+            else if (type == 1)
+                ok = fixed();
+            else if (type == 2)
+                ok = dynamic();
+
+            if (!ok || m_inPos > m_inSize + 8)
+            {
+                if (errorOut && !m_stopped)
+                    *errorOut = QStringLiteral("Повреждённые данные deflate.");
+                return m_stopped;
+            }
+        }
+
+        if (m_stopped)
+            return true;
+
+        return emitPending(true);
+    }
+
+private:
+    static constexpr int kWindow = 32 * 1024;
+
+    const uchar* m_in = nullptr;
+    qint64 m_inSize = 0;
+    qint64 m_inPos = 0;
+    quint64 m_bitBuf = 0;
+    int m_bitCnt = 0;
+
+    QByteArray m_out;
+    int m_pendingStart = 0;   ///< Начало ещё не отданных данных в m_out.
+    bool m_stopped = false;
+    const ZipReader::ChunkHandler& m_onChunk;
+
+    void need(int n)
+    {
+        // За концом входа подставляем нули; выход за границу ловится в run().
+        while (m_bitCnt < n)
+        {
+            const quint64 b = (m_inPos < m_inSize) ? m_in[m_inPos] : 0;
+            ++m_inPos;
+            m_bitBuf |= b << m_bitCnt;
+            m_bitCnt += 8;
+        }
+    }
+
+    quint32 bits(int n)
+    {
+        if (n == 0)
+            return 0;
+        need(n);
+        const quint32 v = (quint32)(m_bitBuf & ((1ull << n) - 1));
+        m_bitBuf >>= n;
+        m_bitCnt -= n;
+        return v;
+    }
+
+    int decode(const Huffman& h)
+    {
+        if (h.bits == 0)
+            return -1;
+        need(h.bits);
+        const quint16 e = h.table.at((int)(m_bitBuf & ((1u << h.bits) - 1)));
+        if (e == 0)
+            return -1;
+        const int len = e & 15;
+        m_bitBuf >>= len;
+        m_bitCnt -= len;
+        return e >> 4;
+    }
+
+    bool emitPending(bool final)
+    {
+        const int pending = m_out.size() - m_pendingStart;
+        if (pending <= 0 || (!final && pending < kChunkBytes))
+            return true;
+
+        if (m_onChunk && !m_onChunk(m_out.constData() + m_pendingStart, pending))
+        {
+            m_stopped = true;
+            return true;
+        }
+
+        // Оставляем только окно для обратных ссылок.
+        if (m_out.size() > kWindow)
+            m_out.remove(0, m_out.size() - kWindow);
+        m_pendingStart = m_out.size();
+        return true;
+    }
+
+    bool stored()
+    {
+        // Выравнивание на границу байта: отбрасываем остаток текущего байта.
+        const int drop = m_bitCnt & 7;
+        m_bitBuf >>= drop;
+        m_bitCnt -= drop;
+
+        const quint32 len = bits(16);
+        const quint32 nlen = bits(16);
+        if ((len ^ 0xFFFFu) != nlen)
+            return false;
+
+        quint32 left = len;
+        while (left > 0 && m_bitCnt >= 8)
+        {
+            m_out.append((char)bits(8));
+            --left;
+        }
+
+        if (m_inPos + left > m_inSize)
+            return false;
+
+        m_out.append(reinterpret_cast<const char*>(m_in + m_inPos), (int)left);
+        m_inPos += left;
+
+        emitPending(false);
+        return true;
+    }
+
+    bool fixed()
+    {
+        static Huffman lit;
+        static Huffman dist;
+        static const bool built = [] {
+            quint8 l[288];
+            int i = 0;
+            for (; i < 144; ++i) l[i] = 8;
+            for (; i < 256; ++i) l[i] = 9;
+            for (; i < 280; ++i) l[i] = 7;
+            for (; i < 288; ++i) l[i] = 8;
+            lit.build(l, 288);
+
+            quint8 d[30];
+            for (int k = 0; k < 30; ++k) d[k] = 5;
+            dist.build(d, 30);
+            return true;
+        }();
+        Q_UNUSED(built);
+
+        return codes(lit, dist);
+    }
+
+    bool dynamic()
+    {
+        static const quint8 order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        const int nlen = (int)bits(5) + 257;
+        const int ndist = (int)bits(5) + 1;
+        const int ncode = (int)bits(4) + 4;
+        if (nlen > 286 || ndist > 30)
+            return false;
+
+        quint8 lengths[320] = {0};
+        for (int i = 0; i < ncode; ++i)
+            lengths[order[i]] = (quint8)bits(3);
+
+        Huffman cl;
+        if (!cl.build(lengths, 19))
+            return false;
+
+        int idx = 0;
+        while (idx < nlen + ndist)
+        {
+            const int sym = decode(cl);
+            if (sym < 0)
+                return false;
+
+            if (sym < 16)
+            {
+                lengths[idx++] = (quint8)sym;
+                continue;
+            }
+
+            quint8 val = 0;
+            int rep = 0;
+            if (sym == 16)
+            {
+                if (idx == 0)
+                    return false;
+                val = lengths[idx - 1];
+                rep = 3 + (int)bits(2);
+            }
+            else if (sym == 17)
+            {
+                rep = 3 + (int)bits(3);
+            }
+            else
+            {
+                rep = 11 + (int)bits(7);
+            }
+
+            if (idx + rep > nlen + ndist)
+                return false;
+            while (rep--)
+                lengths[idx++] = val;
+        }
+
+        if (lengths[256] == 0)
+            return false; // нет кода конца блока
+
+        Huffman lit;
+        Huffman dist;
+        if (!lit.build(lengths, nlen) || !dist.build(lengths + nlen, ndist))
+            return false;
+
+        return codes(lit, dist);
+    }
+
+    bool codes(const Huffman& lit, const Huffman& dist)
+    {
+        static const quint16 lbase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const quint8 lext[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const quint16 dbase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                          257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                          8193, 12289, 16385, 24577};
+        static const quint8 dext[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        while (true)
+        {
+            int sym = decode(lit);
+            if (sym < 0)
+                return false;
+
+            if (sym < 256)
+            {
+                m_out.append((char)sym);
+            }
+            else if (sym == 256)
+            {
+                return true;
+            }
+            else
+            {
+                sym -= 257;
+                if (sym >= 29)
+                    return false;
+                const int len = lbase[sym] + (int)bits(lext[sym]);
+
+                const int dsym = decode(dist);
+                if (dsym < 0 || dsym >= 30)
+                    return false;
+                const int d = dbase[dsym] + (int)bits(dext[dsym]);
+
+                const int pos = m_out.size();
+                if (d > pos)
+                    return false;
+
+                // Копирование с перекрытием (d < len) — побайтно.
+                m_out.resize(pos + len);
+                char* p = m_out.data();
+                for (int k = 0; k < len; ++k)
+                    p[pos + k] = p[pos + k - d];
+            }
+
+            if (m_out.size() - m_pendingStart >= kChunkBytes)
+            {
+                emitPending(false);
+                if (m_stopped)
+                    return true;
+            }
+
+            if (m_inPos > m_inSize + 8)
+                return false;
+        }
+    }
+};
+
+#endif // !CONTEXTMAKER_HAVE_ZLIB
+
+
+/**
+ * @brief Распаковать raw deflate, отдавая куски обработчику.
+ */
+bool inflateRaw(const uchar* in, qint64 size, const ZipReader::ChunkHandler& onChunk, QString* errorOut)
+{
+#ifdef CONTEXTMAKER_HAVE_ZLIB
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось инициализировать zlib.");
+        return false;
+    }
+
+    QByteArray out(kChunkBytes, Qt::Uninitialized);
+    zs.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(in));
+    zs.avail_in = (uInt)size;
+
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END)
+    {
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = (uInt)out.size();
+
+        rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END)
+        {
+            if (errorOut)
+                *errorOut = QStringLiteral("Ошибка zlib: %1").arg(QString::fromLatin1(zs.msg ? zs.msg : "data error"));
+            inflateEnd(&zs);
+            return false;
+        }
+
+        const int produced = out.size() - (int)zs.avail_out;
+        if (produced > 0 && onChunk && !onChunk(out.constData(), produced))
+            break;
+
+        if (rc == Z_OK && produced == 0 && zs.avail_in == 0)
+        {
+            if (errorOut) *errorOut = QStringLiteral("Неожиданный конец данных deflate.");
+            inflateEnd(&zs);
+            return false;
+        }
+    }
+
+    inflateEnd(&zs);
+    return true;
+#else
+    Inflater inf(in, size, onChunk);
+    return inf.run(errorOut);
+#endif
+}
+
+} // namespace
+
+
+ZipReader::ZipReader(const QString& path)
+    : m_file(path)
+{
+}
+
+ZipReader::~ZipReader()
+{
+    if (m_mapped)
+        m_file.unmap(const_cast<uchar*>(m_data));
+}
+
+bool ZipReader::open(QString* errorOut)
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        if (errorOut) *errorOut = QStringLiteral("Не удалось открыть архив: %1").arg(m_file.errorString());
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    m_mapped = (m_data != nullptr);
+    if (!m_mapped)
+    {
+        m_fallback = m_file.readAll();
+        m_data = reinterpret_cast<const uchar*>(m_fallback.constData());
+        m_size = m_fallback.size();
+    }
+
+    // EOCD: ищем сигнатуру с конца (после неё может быть комментарий до 64 КиБ).
+    qint64 eocd = -1;
+    const qint64 minPos = std::max<qint64>(0, m_size - 22 - 0xFFFF);
+    for (qint64 p = m_size - 22; p >= minPos; --p)
+    {
+        if (rd32(m_data + p) == kSigEocd)
+        {
+            eocd = p;
+            break;
+        }
+    }
+
+    if (eocd < 0)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Файл не является ZIP-архивом (нет центрального каталога).");
+        return false;
+    }
+
+    const quint16 count = rd16(m_data + eocd + 10);
+    const quint32 cdSize = rd32(m_data + eocd + 12);
+    const quint32 cdOffset = rd32(m_data + eocd + 16);
+
+    if (cdOffset == 0xFFFFFFFFu || count == 0xFFFF)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Архивы ZIP64 не поддерживаются.");
+        return false;
+    }
+
+    if ((qint64)cdOffset + cdSize > m_size)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Повреждён центральный каталог ZIP.");
+        return false;
+    }
+
+    qint64 p = cdOffset;
+    const qint64 cdEnd = (qint64)cdOffset + cdSize;
+    for (int i = 0; i < count; ++i)
+    {
+        if (p + 46 > cdEnd || rd32(m_data + p) != kSigCentral)
+        {
+            if (errorOut) *errorOut = QStringLiteral("Повреждён центральный каталог ZIP.");
+            return false;
+        }
+
+        Entry e;
+        e.flags = rd16(m_data + p + 8);
+        e.method = rd16(m_data + p + 10);
+        e.compressedSize = rd32(m_data + p + 20);
+        e.uncompressedSize = rd32(m_data + p + 24);
+        const quint16 nameLen = rd16(m_data + p + 28);
+        const quint16 extraLen = rd16(m_data + p + 30);
+        const quint16 commentLen = rd16(m_data + p + 32);
+        e.localHeaderOffset = rd32(m_data + p + 42);
+
+        if (p + 46 + nameLen > cdEnd)
+        {
+            if (errorOut) *errorOut = QStringLiteral("Повреждён центральный каталог ZIP.");
+            return false;
+        }
+
+        // Бит 11 — имя в UTF-8; иначе CP437, но в OpenXML имена ASCII.
+        const char* rawName = reinterpret_cast<const char*>(m_data + p + 46);
+        const QString name = (e.flags & 0x0800) ? QString::fromUtf8(rawName, nameLen)
+                                                : QString::fromLatin1(rawName, nameLen);
+
+        if (!name.endsWith(QLatin1Char('/')))
+        {
+            m_entries.insert(name.toLower(), e);
+            m_names.push_back(name);
+        }
+
+        p += 46 + nameLen + extraLen + commentLen;
+    }
+
+    return true;
+}
+
+const ZipReader::Entry* ZipReader::find(const QString& name) const
+{
+    QString key = name;
+    if (key.startsWith(QLatin1Char('/')))
+        key.remove(0, 1);
+
+    const auto it = m_entries.constFind(key.toLower());
+    return (it == m_entries.constEnd()) ? nullptr : &it.value();
+}
+
+bool ZipReader::contains(const QString& name) const
+{
+    return find(name) != nullptr;
+}
+
+bool ZipReader::readChunked(const QString& name, const ChunkHandler& onChunk, QString* errorOut) const
+{
+    const Entry* e = find(name);
+    if (!e)
+    {
+        if (errorOut) *errorOut = QStringLiteral("В архиве нет элемента %1.").arg(name);
+        return false;
+    }
+
+    if (e->flags & 0x0001)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Элемент %1 зашифрован.").arg(name);
+        return false;
+    }
+
+    const qint64 lh = e->localHeaderOffset;
+    if (lh + 30 > m_size || rd32(m_data + lh) != kSigLocal)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Повреждён локальный заголовок ZIP (%1).").arg(name);
+        return false;
+    }
+
+    // Длины имени/extra в локальном заголовке могут отличаться от центрального каталога.
+    const qint64 dataPos = lh + 30 + rd16(m_data + lh + 26) + rd16(m_data + lh + 28);
+    if (dataPos + e->compressedSize > m_size)
+    {
+        if (errorOut) *errorOut = QStringLiteral("Элемент %1 выходит за пределы архива.").arg(name);
+        return false;
+    }
+
+    const uchar* data = m_data + dataPos;
+
+    if (e->method == 0)
+    {
+        // Stored: отдаём кусками как есть.
+        qint64 left = e->compressedSize;
+        while (left > 0)
+        {
+            const int n = (int)std::min<qint64>(left, kChunkBytes);
+            if (onChunk && !onChunk(reinterpret_cast<const char*>(data), n))
+                break;
+            data += n;
+            left -= n;
+        }
+        return true;
+    }
+
+    if (e->method == 8)
+    {
+        QString err;
+        if (!inflateRaw(data, e->compressedSize, onChunk, &err))
+        {
+            if (errorOut) *errorOut = QStringLiteral("Не удалось распаковать %1: %2").arg(name, err);
+            return false;
+        }
+        return true;
+    }
+
+    if (errorOut) *errorOut = QStringLiteral("Неподдерживаемый метод сжатия %1 (%2).").arg(e->method).arg(name);
+    return false;
+}
+
+QByteArray ZipReader::read(const QString& name, QString* errorOut) const
+{
+    QByteArray out;
+    if (const Entry* e = find(name))
+        out.reserve((int)std::min<quint32>(e->uncompressedSize, 256u * 1024 * 1024));
+
+    const bool ok = readChunked(name, [&out](const char* data, int size) {
+        out.append(data, size);
+        return true;
+    }, errorOut);
+
+    return ok ? out : QByteArray();
+}
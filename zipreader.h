@@ -0,0 +1,86 @@
+/**
+ * @file zipreader.h
+ * @brief Минимальный читатель ZIP (OpenXML: DOCX/XLSX) без распаковки на диск.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+
+/**
+ * @brief Читатель ZIP-архива: центральный каталог + inflate отдельных элементов.
+ * @details
+ *  - архив отображается в память (QFile::map), при неудаче читается целиком;
+ *  - поддерживаются методы Stored (0) и Deflate (8), без шифрования и без ZIP64;
+ *  - inflate: zlib, если проект собран с ним (CONTEXTMAKER_HAVE_ZLIB),
+ *    иначе встроенный декодер по RFC 1951.
+ *  Временных файлов и внешних процессов нет — работает на любой ОС.
+ */
+class ZipReader
+{
+public:
+    /**
+     * @brief Обработчик очередного распакованного куска.
+     * @return false — остановить распаковку (данных уже достаточно).
+     */
+    using ChunkHandler = std::function<bool(const char* data, int size)>;
+
+    explicit ZipReader(const QString& path);
+    ~ZipReader();
+
+    ZipReader(const ZipReader&) = delete;
+    ZipReader& operator=(const ZipReader&) = delete;
+
+    /**
+     * @brief Открыть архив и прочитать центральный каталог.
+     * @param errorOut (опционально) сообщение об ошибке.
+     */
+    bool open(QString* errorOut = nullptr);
+
+    /** \brief Есть ли элемент (имя с '/', без учёта регистра). */
+    bool contains(const QString& name) const;
+
+    /** \brief Имена всех элементов архива (в порядке центрального каталога). */
+    QStringList entryNames() const { return m_names; }
+
+    /**
+     * @brief Распаковать элемент целиком.
+     * @param name Имя элемента (например "word/document.xml").
+     * @param errorOut (опционально) сообщение об ошибке.
+     */
+    QByteArray read(const QString& name, QString* errorOut = nullptr) const;
+
+    /**
+     * @brief Распаковать элемент кусками, отдавая их обработчику по мере готовности.
+     * @details Позволяет разбирать XML потоково и прерваться, не распаковывая остаток.
+     * @return false при ошибке; остановка обработчиком ошибкой не считается.
+     */
+    bool readChunked(const QString& name, const ChunkHandler& onChunk, QString* errorOut = nullptr) const;
+
+private:
+    struct Entry
+    {
+        quint16 flags = 0;
+        quint16 method = 0;
+        quint32 compressedSize = 0;
+        quint32 uncompressedSize = 0;
+        quint32 localHeaderOffset = 0;
+    };
+
+    QFile m_file;
+    QByteArray m_fallback;            ///< Содержимое архива, если map() недоступен.
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    bool m_mapped = false;
+
+    QHash<QString, Entry> m_entries;  ///< Ключ — имя в нижнем регистре.
+    QStringList m_names;
+
+    const Entry* find(const QString& name) const;
+};